@@ -0,0 +1,225 @@
+#include "AABB.h"
+#include "Rectangle.h"
+#include "Circle.h"
+
+// Gets the smallest box that holds the whole shape, rotation included.
+AABB shapeBounds(Shape::IShape *shape)
+{
+	AABB box{ 0.0f, 0.0f, 0.0f, 0.0f };
+
+	if (shape)
+	{
+		Vector2D center = shape->center();
+
+		box.minX = center.getX();
+		box.minY = center.getY();
+		box.maxX = center.getX();
+		box.maxY = center.getY();
+
+		switch (shape->type())
+		{
+		case Shape::RECTANGLE:
+		{
+			Shape::Rectangle *rect = static_cast<Shape::Rectangle*>(shape);
+
+			box = rect->bounds();
+
+			break;
+		}
+		case Shape::CIRCLE:
+		{
+			Shape::Circle *circle = static_cast<Shape::Circle*>(shape);
+
+			float radius = (float)circle->radius();
+
+			box = expandBounds(box, radius);
+
+			break;
+		}
+		}
+	}
+
+	return box;
+}
+
+// Gets the smallest box that holds the line.
+AABB lineBounds(const Line line)
+{
+	AABB box{ line.start.getX(), line.start.getY(), line.start.getX(), line.start.getY() };
+
+	if (line.end.getX() < box.minX) { box.minX = line.end.getX(); }
+	if (box.maxX < line.end.getX()) { box.maxX = line.end.getX(); }
+	if (line.end.getY() < box.minY) { box.minY = line.end.getY(); }
+	if (box.maxY < line.end.getY()) { box.maxY = line.end.getY(); }
+
+	return box;
+}
+
+// Moves the box by the offset.
+AABB translateBounds(const AABB box, Vector2D offset)
+{
+	AABB moved{ box.minX + offset.getX(), box.minY + offset.getY(), box.maxX + offset.getX(), box.maxY + offset.getY() };
+
+	return moved;
+}
+
+// Gets the smallest box that holds both boxes.
+AABB combineBounds(const AABB a, const AABB b)
+{
+	AABB combined = a;
+
+	if (b.minX < combined.minX) { combined.minX = b.minX; }
+	if (b.minY < combined.minY) { combined.minY = b.minY; }
+	if (combined.maxX < b.maxX) { combined.maxX = b.maxX; }
+	if (combined.maxY < b.maxY) { combined.maxY = b.maxY; }
+
+	return combined;
+}
+
+// Grows the box by the amount on every side.
+AABB expandBounds(const AABB box, float amount)
+{
+	AABB expanded{ box.minX - amount, box.minY - amount, box.maxX + amount, box.maxY + amount };
+
+	return expanded;
+}
+
+// Checks if two boxes overlap. Boxes that only share an edge don't overlap.
+bool boundsOverlap(const AABB a, const AABB b)
+{
+	return (a.minX < b.maxX && b.minX < a.maxX &&
+			a.minY < b.maxY && b.minY < a.maxY);
+}
+
+// Checks if the inner box is completely inside the outer box.
+bool boundsContain(const AABB outer, const AABB inner)
+{
+	return (outer.minX <= inner.minX && outer.minY <= inner.minY &&
+			inner.maxX <= outer.maxX && inner.maxY <= outer.maxY);
+}
+
+// Checks if any part of the line is inside of the box. The line is clipped
+// against each axis of the box in turn, and misses once nothing is left.
+bool lineOverlapsBounds(const Line line, const AABB box)
+{
+	float start = 0.0f;
+	float end = 1.0f;
+
+	float origin[2]{ line.start.getX(), line.start.getY() };
+	float direction[2]{ line.end.getX() - line.start.getX(), line.end.getY() - line.start.getY() };
+	float minimum[2]{ box.minX, box.minY };
+	float maximum[2]{ box.maxX, box.maxY };
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (direction[axis] == 0.0f)
+		{
+			// Running parallel to this axis, so it has to already be inside
+			if (origin[axis] < minimum[axis] || maximum[axis] < origin[axis])
+			{
+				return false;
+			}
+		}
+		else
+		{
+			float enter = (minimum[axis] - origin[axis]) / direction[axis];
+			float exit = (maximum[axis] - origin[axis]) / direction[axis];
+
+			if (exit < enter)
+			{
+				float temp = enter;
+				enter = exit;
+				exit = temp;
+			}
+
+			if (start < enter) { start = enter; }
+			if (exit < end) { end = exit; }
+
+			if (end < start)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Finds when a box moving by the displacement first touches the target.
+// Each axis gives a window of time where the boxes overlap on it, and the
+// boxes only touch while both windows are open. Boxes that already overlap
+// are skipped so a mover that's stuck can still get out.
+// time is how far along the displacement the boxes touch, from 0 to 1.
+// normal is the side of the target that was hit.
+bool sweepBounds(const AABB moving, Vector2D displacement, const AABB target, float &time, Vector2D &normal)
+{
+	float enterTime = -1.0f;
+	float exitTime = 2.0f;
+	int enterAxis = -1;
+
+	float direction[2]{ displacement.getX(), displacement.getY() };
+	float movingMin[2]{ moving.minX, moving.minY };
+	float movingMax[2]{ moving.maxX, moving.maxY };
+	float targetMin[2]{ target.minX, target.minY };
+	float targetMax[2]{ target.maxX, target.maxY };
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (direction[axis] == 0.0f)
+		{
+			// Not moving on this axis, so they have to already line up on it
+			if (movingMax[axis] <= targetMin[axis] || targetMax[axis] <= movingMin[axis])
+			{
+				return false;
+			}
+		}
+		else
+		{
+			float enter = 0.0f;
+			float exit = 0.0f;
+
+			if (0.0f < direction[axis])
+			{
+				enter = (targetMin[axis] - movingMax[axis]) / direction[axis];
+				exit = (targetMax[axis] - movingMin[axis]) / direction[axis];
+			}
+			else
+			{
+				enter = (targetMax[axis] - movingMin[axis]) / direction[axis];
+				exit = (targetMin[axis] - movingMax[axis]) / direction[axis];
+			}
+
+			if (enterTime < enter)
+			{
+				enterTime = enter;
+				enterAxis = axis;
+			}
+
+			if (exit < exitTime) { exitTime = exit; }
+		}
+	}
+
+	if (enterAxis == -1 || enterTime < 0.0f || 1.0f < enterTime || exitTime <= enterTime)
+	{
+		return false;
+	}
+
+	time = enterTime;
+
+	if (enterAxis == 0)
+	{
+		normal = Vector2D(0.0f < direction[0] ? -1.0f : 1.0f, 0.0f);
+	}
+	else
+	{
+		normal = Vector2D(0.0f, 0.0f < direction[1] ? -1.0f : 1.0f);
+	}
+
+	return true;
+}
+
+// Gets the distance around the box. Used as the cost of a box in the tree.
+float boundsPerimeter(const AABB box)
+{
+	return 2.0f * ((box.maxX - box.minX) + (box.maxY - box.minY));
+}
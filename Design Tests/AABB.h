@@ -0,0 +1,30 @@
+#pragma once
+//==========================================================================================
+// File Name: AABB.h
+// Author: Brian Blackmon
+// Date Created: 9/2/2019
+// Purpose: 
+// Axis aligned bounding boxes for quick overlap rejection.
+//==========================================================================================
+#include "Vector2D.h"
+#include "IShape.h"
+#include "Line.h"
+
+struct AABB
+{
+	float minX;
+	float minY;
+	float maxX;
+	float maxY;
+};
+
+AABB shapeBounds(Shape::IShape *shape);
+AABB lineBounds(const Line line);
+AABB translateBounds(const AABB box, Vector2D offset);
+AABB combineBounds(const AABB a, const AABB b);
+AABB expandBounds(const AABB box, float amount);
+bool boundsOverlap(const AABB a, const AABB b);
+bool boundsContain(const AABB outer, const AABB inner);
+bool lineOverlapsBounds(const Line line, const AABB box);
+bool sweepBounds(const AABB moving, Vector2D displacement, const AABB target, float &time, Vector2D &normal);
+float boundsPerimeter(const AABB box);
@@ -0,0 +1,554 @@
+#include "AABBTree.h"
+#include "EntityID.h"
+
+AABBTree::AABBTree()
+	:m_root(m_NULL_NODE), m_freeNode(m_NULL_NODE)
+{
+}
+
+AABBTree::~AABBTree()
+{
+}
+
+//=============================================================================
+// Function: void add(int, const AABB)
+// Description:
+// Adds a leaf for the entity. Adding an entity that's already in the tree
+// updates it instead. A leaf left in the slot by a deleted entity is
+// removed first, so queries can't find the old ID.
+// Parameters:
+// int ID - The entity to add.
+// const AABB bounds - The entity's box.
+//=============================================================================
+void AABBTree::add(int ID, const AABB bounds)
+{
+	if (ID < 0)
+	{
+		return;
+	}
+
+	if (contains(ID))
+	{
+		update(ID, bounds);
+		return;
+	}
+
+	int slot = entitySlot(ID);
+
+	if ((int)m_leaves.size() <= slot)
+	{
+		m_leaves.resize(slot + 1, m_NULL_NODE);
+	}
+
+	if (m_leaves[slot] != m_NULL_NODE)
+	{
+		remove(m_nodes[m_leaves[slot]].m_ID);
+	}
+
+	int leaf = allocateNode();
+
+	m_nodes[leaf].m_bounds = expandBounds(bounds, m_FAT_MARGIN);
+	m_nodes[leaf].m_height = 0;
+	m_nodes[leaf].m_ID = ID;
+
+	m_leaves[slot] = leaf;
+
+	insertLeaf(leaf);
+}
+
+//=============================================================================
+// Function: void remove(int)
+// Description:
+// Removes the entity's leaf from the tree.
+// Parameters:
+// int ID - The entity to remove.
+//=============================================================================
+void AABBTree::remove(int ID)
+{
+	if (contains(ID))
+	{
+		int leaf = m_leaves[entitySlot(ID)];
+
+		removeLeaf(leaf);
+		releaseNode(leaf);
+
+		m_leaves[entitySlot(ID)] = m_NULL_NODE;
+	}
+}
+
+//=============================================================================
+// Function: void update(int, const AABB)
+// Description:
+// Moves the entity's leaf if its new box doesn't fit inside the old fat
+// box anymore. Otherwise nothing changes.
+// Parameters:
+// int ID - The entity that changed.
+// const AABB bounds - The entity's new box.
+//=============================================================================
+void AABBTree::update(int ID, const AABB bounds)
+{
+	if (!contains(ID))
+	{
+		add(ID, bounds);
+		return;
+	}
+
+	int leaf = m_leaves[entitySlot(ID)];
+
+	if (!boundsContain(m_nodes[leaf].m_bounds, bounds))
+	{
+		removeLeaf(leaf);
+
+		m_nodes[leaf].m_bounds = expandBounds(bounds, m_FAT_MARGIN);
+
+		insertLeaf(leaf);
+	}
+}
+
+bool AABBTree::contains(int ID)
+{
+	int slot = entitySlot(ID);
+
+	// An old ID for a reused slot doesn't match the leaf's
+	return (0 <= ID && slot < (int)m_leaves.size() && m_leaves[slot] != m_NULL_NODE &&
+		m_nodes[m_leaves[slot]].m_ID == ID);
+}
+
+//=============================================================================
+// Function: void query(const AABB, std::vector<int>&)
+// Description:
+// Adds every entity whose fat box overlaps the bounds. Entities that are
+// just outside of the bounds can show up, so the results still need an
+// exact check.
+// Parameters:
+// const AABB bounds - The area to look in.
+// std::vector<int> &results - Where the overlapping entities are added.
+//=============================================================================
+void AABBTree::query(const AABB bounds, std::vector<int> &results)
+{
+	if (m_root == m_NULL_NODE)
+	{
+		return;
+	}
+
+	// Physics workers query the tree at the same time, so each thread gets
+	// its own stack instead of sharing m_stack.
+	static thread_local std::vector<int> stack;
+
+	stack.clear();
+	stack.push_back(m_root);
+
+	while (!stack.empty())
+	{
+		int node = stack.back();
+		stack.pop_back();
+
+		if (boundsOverlap(m_nodes[node].m_bounds, bounds))
+		{
+			if (isLeaf(node))
+			{
+				results.push_back(m_nodes[node].m_ID);
+			}
+			else
+			{
+				stack.push_back(m_nodes[node].m_left);
+				stack.push_back(m_nodes[node].m_right);
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: void queryLines(const Line[], int, ILineVisitor&)
+// Description:
+// Walks the tree once for all of the lines. Each node carries the lines
+// that pass through it, so a branch is dropped as soon as none of them do.
+// Parameters:
+// const Line lines[] - The lines to check. No more than MAX_LINES.
+// int lineCount - How many lines there are.
+// ILineVisitor &visitor - Gets each entity the lines pass through.
+//=============================================================================
+void AABBTree::queryLines(const Line lines[], int lineCount, ILineVisitor &visitor)
+{
+	if (m_root == m_NULL_NODE || lineCount <= 0)
+	{
+		return;
+	}
+
+	if (BroadPhase::MAX_LINES < lineCount)
+	{
+		lineCount = BroadPhase::MAX_LINES;
+	}
+
+	unsigned int allLines = (lineCount == BroadPhase::MAX_LINES ? 0xFFFFFFFFu : ((1u << lineCount) - 1));
+
+	m_stack.clear();
+	m_maskStack.clear();
+
+	m_stack.push_back(m_root);
+	m_maskStack.push_back(allLines);
+
+	while (!m_stack.empty())
+	{
+		int node = m_stack.back();
+		unsigned int lineMask = m_maskStack.back();
+
+		m_stack.pop_back();
+		m_maskStack.pop_back();
+
+		lineMask = linesThrough(lines, lineMask, m_nodes[node].m_bounds);
+
+		if (lineMask != 0)
+		{
+			if (isLeaf(node))
+			{
+				if (!visitor.visit(m_nodes[node].m_ID, lineMask))
+				{
+					return;
+				}
+			}
+			else
+			{
+				m_stack.push_back(m_nodes[node].m_left);
+				m_maskStack.push_back(lineMask);
+
+				m_stack.push_back(m_nodes[node].m_right);
+				m_maskStack.push_back(lineMask);
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: int allocateNode()
+// Description:
+// Gets a node off of the free list, or adds a new one if there isn't one.
+// Output:
+// int - The index of the node.
+//=============================================================================
+int AABBTree::allocateNode()
+{
+	int node = m_NULL_NODE;
+
+	if (m_freeNode != m_NULL_NODE)
+	{
+		node = m_freeNode;
+		m_freeNode = m_nodes[node].m_parent;
+	}
+	else
+	{
+		node = (int)m_nodes.size();
+
+		TreeEntry entry;
+		m_nodes.push_back(entry);
+	}
+
+	AABB empty{ 0.0f, 0.0f, 0.0f, 0.0f };
+
+	m_nodes[node].m_bounds = empty;
+	m_nodes[node].m_parent = m_NULL_NODE;
+	m_nodes[node].m_left = m_NULL_NODE;
+	m_nodes[node].m_right = m_NULL_NODE;
+	m_nodes[node].m_height = 0;
+	m_nodes[node].m_ID = -1;
+
+	return node;
+}
+
+void AABBTree::releaseNode(int node)
+{
+	m_nodes[node].m_parent = m_freeNode;
+	m_nodes[node].m_height = -1;
+
+	m_freeNode = node;
+}
+
+//=============================================================================
+// Function: void insertLeaf(int)
+// Description:
+// Pairs the leaf up with the cheapest sibling under a new parent, then
+// refits and balances everything above it.
+// Parameters:
+// int leaf - The leaf to insert. Its box has to be set already.
+//=============================================================================
+void AABBTree::insertLeaf(int leaf)
+{
+	if (m_root == m_NULL_NODE)
+	{
+		m_root = leaf;
+		m_nodes[m_root].m_parent = m_NULL_NODE;
+		return;
+	}
+
+	AABB leafBounds = m_nodes[leaf].m_bounds;
+
+	int sibling = findSibling(leafBounds);
+	int oldParent = m_nodes[sibling].m_parent;
+
+	// Grabbing a node can move the node storage, so don't hold references
+	int newParent = allocateNode();
+
+	m_nodes[newParent].m_parent = oldParent;
+	m_nodes[newParent].m_bounds = combineBounds(leafBounds, m_nodes[sibling].m_bounds);
+	m_nodes[newParent].m_height = m_nodes[sibling].m_height + 1;
+	m_nodes[newParent].m_left = sibling;
+	m_nodes[newParent].m_right = leaf;
+
+	if (oldParent != m_NULL_NODE)
+	{
+		if (m_nodes[oldParent].m_left == sibling)
+		{
+			m_nodes[oldParent].m_left = newParent;
+		}
+		else
+		{
+			m_nodes[oldParent].m_right = newParent;
+		}
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	m_nodes[sibling].m_parent = newParent;
+	m_nodes[leaf].m_parent = newParent;
+
+	refit(oldParent);
+}
+
+//=============================================================================
+// Function: void removeLeaf(int)
+// Description:
+// Takes the leaf out of the tree. Its parent is thrown away and its sibling
+// takes the parent's place. The leaf node itself is kept.
+// Parameters:
+// int leaf - The leaf to remove.
+//=============================================================================
+void AABBTree::removeLeaf(int leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = m_NULL_NODE;
+		return;
+	}
+
+	int parent = m_nodes[leaf].m_parent;
+	int grandParent = m_nodes[parent].m_parent;
+	int sibling = m_nodes[parent].m_left;
+
+	if (sibling == leaf)
+	{
+		sibling = m_nodes[parent].m_right;
+	}
+
+	if (grandParent != m_NULL_NODE)
+	{
+		if (m_nodes[grandParent].m_left == parent)
+		{
+			m_nodes[grandParent].m_left = sibling;
+		}
+		else
+		{
+			m_nodes[grandParent].m_right = sibling;
+		}
+
+		m_nodes[sibling].m_parent = grandParent;
+
+		releaseNode(parent);
+
+		refit(grandParent);
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].m_parent = m_NULL_NODE;
+
+		releaseNode(parent);
+	}
+
+	m_nodes[leaf].m_parent = m_NULL_NODE;
+}
+
+//=============================================================================
+// Function: int findSibling(const AABB)
+// Description:
+// Walks down the tree looking for the node that grows the tree's total
+// perimeter the least when it's paired with the new box.
+// Parameters:
+// const AABB bounds - The box that's being inserted.
+// Output:
+// int - The node to use as the new box's sibling.
+//=============================================================================
+int AABBTree::findSibling(const AABB bounds)
+{
+	int node = m_root;
+
+	while (!isLeaf(node))
+	{
+		int left = m_nodes[node].m_left;
+		int right = m_nodes[node].m_right;
+
+		float perimeter = boundsPerimeter(m_nodes[node].m_bounds);
+		float combinedPerimeter = boundsPerimeter(combineBounds(m_nodes[node].m_bounds, bounds));
+
+		// The cost of making a new parent for this node and the box
+		float cost = 2.0f * combinedPerimeter;
+
+		// Every node above a child grows as well if we keep going
+		float inheritedCost = 2.0f * (combinedPerimeter - perimeter);
+
+		float leftCost = boundsPerimeter(combineBounds(m_nodes[left].m_bounds, bounds)) + inheritedCost;
+		float rightCost = boundsPerimeter(combineBounds(m_nodes[right].m_bounds, bounds)) + inheritedCost;
+
+		if (!isLeaf(left)) { leftCost -= boundsPerimeter(m_nodes[left].m_bounds); }
+		if (!isLeaf(right)) { rightCost -= boundsPerimeter(m_nodes[right].m_bounds); }
+
+		if (cost < leftCost && cost < rightCost)
+		{
+			break;
+		}
+
+		node = (leftCost < rightCost ? left : right);
+	}
+
+	return node;
+}
+
+//=============================================================================
+// Function: void refit(int)
+// Description:
+// Walks up from the node to the root, balancing each node and resizing its
+// box to fit its children.
+// Parameters:
+// int node - The first node to refit.
+//=============================================================================
+void AABBTree::refit(int node)
+{
+	while (node != m_NULL_NODE)
+	{
+		node = balance(node);
+
+		int left = m_nodes[node].m_left;
+		int right = m_nodes[node].m_right;
+
+		int leftHeight = m_nodes[left].m_height;
+		int rightHeight = m_nodes[right].m_height;
+
+		m_nodes[node].m_height = 1 + (leftHeight < rightHeight ? rightHeight : leftHeight);
+		m_nodes[node].m_bounds = combineBounds(m_nodes[left].m_bounds, m_nodes[right].m_bounds);
+
+		node = m_nodes[node].m_parent;
+	}
+}
+
+//=============================================================================
+// Function: int balance(int)
+// Description:
+// Rotates the taller child up if one side of the node is more than one
+// level taller than the other.
+// Parameters:
+// int a - The node to balance.
+// Output:
+// int - The node that's now in a's place.
+//=============================================================================
+int AABBTree::balance(int a)
+{
+	if (isLeaf(a) || m_nodes[a].m_height < 2)
+	{
+		return a;
+	}
+
+	int b = m_nodes[a].m_left;
+	int c = m_nodes[a].m_right;
+
+	int difference = m_nodes[c].m_height - m_nodes[b].m_height;
+
+	// Rotate c up, or b up if the left side is the tall one
+	if (1 < difference || difference < -1)
+	{
+		bool rotateRight = (1 < difference);
+
+		int up = (rotateRight ? c : b);
+		int stay = (rotateRight ? b : c);
+
+		int upLeft = m_nodes[up].m_left;
+		int upRight = m_nodes[up].m_right;
+
+		m_nodes[up].m_left = a;
+		m_nodes[up].m_parent = m_nodes[a].m_parent;
+		m_nodes[a].m_parent = up;
+
+		int parent = m_nodes[up].m_parent;
+
+		if (parent != m_NULL_NODE)
+		{
+			if (m_nodes[parent].m_left == a)
+			{
+				m_nodes[parent].m_left = up;
+			}
+			else
+			{
+				m_nodes[parent].m_right = up;
+			}
+		}
+		else
+		{
+			m_root = up;
+		}
+
+		// The taller grandchild stays with the node going up
+		int keep = upLeft;
+		int give = upRight;
+
+		if (m_nodes[upLeft].m_height <= m_nodes[upRight].m_height)
+		{
+			keep = upRight;
+			give = upLeft;
+		}
+
+		m_nodes[up].m_right = keep;
+
+		if (rotateRight)
+		{
+			m_nodes[a].m_right = give;
+		}
+		else
+		{
+			m_nodes[a].m_left = give;
+		}
+
+		m_nodes[give].m_parent = a;
+
+		int stayHeight = m_nodes[stay].m_height;
+		int giveHeight = m_nodes[give].m_height;
+
+		m_nodes[a].m_bounds = combineBounds(m_nodes[stay].m_bounds, m_nodes[give].m_bounds);
+		m_nodes[a].m_height = 1 + (stayHeight < giveHeight ? giveHeight : stayHeight);
+
+		int aHeight = m_nodes[a].m_height;
+		int keepHeight = m_nodes[keep].m_height;
+
+		m_nodes[up].m_bounds = combineBounds(m_nodes[a].m_bounds, m_nodes[keep].m_bounds);
+		m_nodes[up].m_height = 1 + (aHeight < keepHeight ? keepHeight : aHeight);
+
+		return up;
+	}
+
+	return a;
+}
+
+// Keeps the bits of the lines that pass through the box.
+unsigned int AABBTree::linesThrough(const Line lines[], unsigned int lineMask, const AABB bounds)
+{
+	unsigned int through = 0;
+
+	for (int i = 0; i < BroadPhase::MAX_LINES && (lineMask >> i) != 0; i++)
+	{
+		if (((lineMask >> i) & 1u) && lineOverlapsBounds(lines[i], bounds))
+		{
+			through |= (1u << i);
+		}
+	}
+
+	return through;
+}
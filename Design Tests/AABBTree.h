@@ -0,0 +1,73 @@
+#pragma once
+//==========================================================================================
+// File Name: AABBTree.h
+// Author: Brian Blackmon
+// Date Created: 9/4/2019
+// Purpose: 
+// A broad phase backed by a dynamic bounding volume tree. Every entity is a
+// leaf holding a box that's a little bigger than the entity, so small moves
+// don't change the tree at all. When an entity does leave its box, only its
+// leaf is pulled out and put back in, and the boxes above it are refit.
+// Mixed sizes and big empty areas don't cost anything extra like they do
+// in the grid.
+//==========================================================================================
+#include "IBroadPhase.h"
+
+class AABBTree : public IBroadPhase
+{
+public:
+	AABBTree();
+	~AABBTree();
+
+	BroadPhase::BroadPhaseType type() { return BroadPhase::AABB_TREE; }
+
+	void add(int ID, const AABB bounds);
+	void remove(int ID);
+	void update(int ID, const AABB bounds);
+
+	bool contains(int ID);
+
+	void query(const AABB bounds, std::vector<int> &results);
+	void queryLines(const Line lines[], int lineCount, ILineVisitor &visitor);
+
+private:
+	// How much bigger a leaf's box is than the entity in it
+	const float m_FAT_MARGIN = 8.0f;
+	const int m_NULL_NODE = -1;
+
+	struct TreeEntry
+	{
+		AABB m_bounds;
+		int m_parent;
+		int m_left;
+		int m_right;
+		// Leaves are 0. Free nodes are -1.
+		int m_height;
+		int m_ID;
+	};
+
+	std::vector<TreeEntry> m_nodes;
+	int m_root;
+	// The first free node. Free nodes are chained through m_parent.
+	int m_freeNode;
+
+	// The leaf for each entity, indexed by its slot
+	std::vector<int> m_leaves;
+
+	// Reused so line queries don't allocate
+	std::vector<int> m_stack;
+	std::vector<unsigned int> m_maskStack;
+
+	int allocateNode();
+	void releaseNode(int node);
+
+	bool isLeaf(int node) { return m_nodes[node].m_left == m_NULL_NODE; }
+
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int findSibling(const AABB bounds);
+	void refit(int node);
+	int balance(int node);
+
+	unsigned int linesThrough(const Line lines[], unsigned int lineMask, const AABB bounds);
+};
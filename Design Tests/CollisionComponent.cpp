@@ -3,7 +3,8 @@
 
 
 CollisionComponent::CollisionComponent(pShape shape)
-	:Component(COLLISION), m_shape(shape), m_solid(false)
+	:Component(COLLISION), m_shape(shape), m_solid(false),
+	m_category(CollisionLayer::DEFAULT), m_mask(CollisionLayer::ALL)
 {
 
 }
@@ -13,3 +14,43 @@ CollisionComponent::~CollisionComponent()
 {
 	delete m_shape;
 }
+
+//=============================================================================
+// Function: unsigned int parseLayers(const std::string&)
+// Description:
+// Turns a list of layer names split up by | into layer bits. Names that
+// aren't known are skipped.
+// Parameters:
+// const std::string &layers - The names. EX: Player|Door
+// Output:
+// unsigned int - The bits for every layer named.
+//=============================================================================
+unsigned int CollisionLayer::parseLayers(const std::string &layers)
+{
+	unsigned int bits = NONE;
+
+	size_t start = 0;
+
+	while (start <= layers.size())
+	{
+		size_t end = layers.find('|', start);
+
+		if (end == std::string::npos)
+		{
+			end = layers.size();
+		}
+
+		std::string name = layers.substr(start, end - start);
+
+		if (name == "Default") { bits |= DEFAULT; }
+		else if (name == "Player") { bits |= PLAYER; }
+		else if (name == "Enemy") { bits |= ENEMY; }
+		else if (name == "Door") { bits |= DOOR; }
+		else if (name == "Attack") { bits |= ATTACK; }
+		else if (name == "All") { bits |= ALL; }
+
+		start = end + 1;
+	}
+
+	return bits;
+}
@@ -5,7 +5,11 @@
 // Date Created: 3/25/2019
 // Purpose: 
 // Holds the collision information for an entity.
+// Each component is in one or more collision categories and has a mask of
+// the categories it collides with. Two components only get checked against
+// each other when each one's mask has the other's category.
 //==========================================================================================
+#include <string>
 #include "Component.h"
 
 #include "Rectangle.h"
@@ -15,6 +19,23 @@ typedef Shape::IShape* pShape;
 typedef Shape::Circle* pCircle;
 typedef Shape::Rectangle* pRectangle;
 
+namespace CollisionLayer
+{
+	enum CollisionLayerType : unsigned int
+	{
+		NONE = 0,
+		DEFAULT = 1u << 0,
+		PLAYER = 1u << 1,
+		ENEMY = 1u << 2,
+		DOOR = 1u << 3,
+		ATTACK = 1u << 4,
+		ALL = 0xFFFFFFFFu
+	};
+
+	// Turns a list like "Player|Door" into bits
+	unsigned int parseLayers(const std::string &layers);
+}
+
 class CollisionComponent : public Component
 {
 public:
@@ -24,14 +45,25 @@ public:
 	void setRotation(const float rotation) { m_shape->setRotation(rotation); }
 	void setCenter(Vector2D center) { m_shape->setCenter(center.getX(), center.getY()); }
 	void setSolid(bool isSolid) { m_solid = isSolid; }
+	void setCategory(unsigned int category) { m_category = category; }
+	void setMask(unsigned int mask) { m_mask = mask; }
 
 	pShape shape() { return m_shape; }
 	float rotation() const { return m_shape->rotation(); }
 	Vector2D center() { return m_shape->center(); }
 	bool isSolid() { return m_solid; }
+	unsigned int category() const { return m_category; }
+	unsigned int mask() const { return m_mask; }
+
+	bool canCollide(const CollisionComponent *other) const
+	{
+		return (m_mask & other->m_category) != 0 && (other->m_mask & m_category) != 0;
+	}
 
 private:
 	pShape m_shape;
 	bool m_solid;
+	unsigned int m_category;
+	unsigned int m_mask;
 };
 
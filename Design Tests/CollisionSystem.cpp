@@ -1,18 +1,134 @@
 #include "CollisionSystem.h"
+#include "EntityID.h"
 #include "CollisionMessage.h"
+#include "MoveMessage.h"
 #include "EntityDestroyMessage.h"
+#include "EntitySystem.h"
 #include "Vector2D.h"
 #include "Rotation.h"
 #include "Rectangle.h"
 #include "Circle.h"
+#include "FixedPoint.h"
 #include <cmath>
+#include <algorithm>
 
-typedef Node<Node<int>*> Cell;
+//=============================================================================
+// SightVisitor
+// Closes each sight line that runs into something. The lines belong to
+// different pairs, so each entity is only checked against the lines of
+// pairs it isn't part of. Collision masks aren't used here. Anything with
+// a shape blocks sight, even things an entity doesn't collide with.
+//=============================================================================
+class CollisionSystem::SightVisitor : public ILineVisitor
+{
+public:
+	SightVisitor(CollisionSystem *system, const Line lines[], const int owners[], unsigned int openLines, const std::vector<SightQuery> &queries)
+		:m_system(system), m_lines(lines), m_owners(owners), m_queries(queries), m_openLines(openLines)
+	{
+	}
+
+	bool visit(int ID, unsigned int lineMask)
+	{
+		CollisionComponent *component = m_system->getCollisionComponent(ID);
+
+		if (!component)
+		{
+			return true;
+		}
+
+		// The broad phase's boxes can be bigger than the shape
+		AABB bounds = shapeBounds(component->shape());
+
+		unsigned int lines = (lineMask & m_openLines);
+
+		for (int i = 0; (lines >> i) != 0; i++)
+		{
+			if ((lines >> i) & 1u)
+			{
+				const SightQuery &query = m_queries[m_owners[i]];
+
+				if (ID != query.m_entityID && ID != query.m_otherEntityID &&
+					lineOverlapsBounds(m_lines[i], bounds) &&
+					m_system->handleCollision(m_lines[i], component->shape()))
+				{
+					m_openLines &= ~(1u << i);
+				}
+			}
+		}
+
+		// Nothing left to see, so stop looking
+		return (m_openLines != 0);
+	}
+
+	unsigned int openLines() { return m_openLines; }
+
+private:
+	CollisionSystem *m_system;
+	const Line *m_lines;
+	const int *m_owners;
+	const std::vector<SightQuery> &m_queries;
+	unsigned int m_openLines;
+};
+
+//=============================================================================
+// SolidLineVisitor
+// Stops at the first solid entity the line runs into.
+//=============================================================================
+class CollisionSystem::SolidLineVisitor : public ILineVisitor
+{
+public:
+	SolidLineVisitor(CollisionSystem *system, const Line line, int entityID)
+		:m_system(system), m_line(line), m_entityID(entityID), m_self(NULL), m_hit(false)
+	{
+		m_self = system->getCollisionComponent(entityID);
+	}
+
+	// There's only the one line, so the line mask is always 1
+	bool visit(int ID, unsigned int)
+	{
+		if (ID != m_entityID)
+		{
+			CollisionComponent *component = m_system->getCollisionComponent(ID);
+
+			if (component && component->isSolid() &&
+				m_system->layersCollide(m_self, component) &&
+				lineOverlapsBounds(m_line, shapeBounds(component->shape())) &&
+				m_system->handleCollision(m_line, component->shape()))
+			{
+				m_hit = true;
+			}
+		}
+
+		return !m_hit;
+	}
+
+	bool hit() { return m_hit; }
 
-CollisionSystem::CollisionSystem(int gridX, int gridY, int width, int height, int cellSize)
-	:m_grid(NULL)
+private:
+	CollisionSystem *m_system;
+	Line m_line;
+	int m_entityID;
+	CollisionComponent *m_self;
+	bool m_hit;
+};
+
+CollisionSystem::CollisionSystem(int gridX, int gridY, int width, int height, int cellSize, BroadPhase::BroadPhaseType broadPhase)
+	:m_broadPhase(NULL), m_broadPhaseValid(false), m_fixedPoint(false)
 {
-	m_grid = new Grid(gridX, gridY, width, height, cellSize);
+	switch (broadPhase)
+	{
+	case BroadPhase::AABB_TREE:
+	{
+		m_broadPhase = new AABBTree();
+		break;
+	}
+	case BroadPhase::GRID:
+	default:
+	{
+		m_broadPhase = new GridBroadPhase(gridX, gridY, width, height, cellSize);
+		break;
+	}
+	}
 }
 
 
@@ -29,18 +145,22 @@ bool CollisionSystem::collisionAtPoint(int ID, int x, int y)
 
 	if (first)
 	{
-		Node<int> *node = m_grid->getCoordinateCell(x, y);
+		collision = m_tiles.pointSolid((float)x, (float)y);
+
+		AABB point{ (float)x, (float)y, (float)x, (float)y };
 
-		// If the node exists, look through it for possible collisions
+		m_queryResults.clear();
+		m_broadPhase->query(expandBounds(point, 1.0f), m_queryResults);
 
-		while (node)
+		// Look through everything near the point for possible collisions
+		for (unsigned int k = 0; k < m_queryResults.size(); k++)
 		{
 			// Make sure we're not checking against the entity requesting
 			// the check.
-			if (node->data() != ID)
-			{
-				CollisionComponent *other = getCollisionComponent(node->data());
+			CollisionComponent *other = getCollisionComponent(m_queryResults[k]);
 
+			if (m_queryResults[k] != ID && other && first->canCollide(other))
+			{
 				pShape otherShape = other->shape();
 
 				switch (otherShape->type())
@@ -49,1007 +169,1517 @@ bool CollisionSystem::collisionAtPoint(int ID, int x, int y)
 				{
 					pRectangle rect = static_cast<pRectangle>(otherShape);
 					collision = (pointInsideRect(rect, x, y) || collision);
+					break;
 				}
 				case Shape::CIRCLE:
 				{
 					pCircle circle = static_cast<pCircle>(otherShape);
 					collision = (pointInsideCircle(circle, x, y) || collision);
+					break;
 				}
 				}
 			}
-
-			node = node->m_next;
 		}
 	}
 
 	return collision;
 }
 
+//=============================================================================
+// Function: bool isColliding(int)
+// Description:
+// Checks the entity against everything its box overlaps and sends a
+// collision message for each one it's touching.
+// Parameters:
+// int ID - The entity to check.
+// Output:
+// bool - Returns true if the entity is inside of something solid.
+//=============================================================================
 bool CollisionSystem::isColliding(int ID)
+{
+	return isColliding(ID, m_workspace);
+}
+
+//=============================================================================
+// Function: bool isColliding(int, CollisionWorkspace&)
+// Description:
+// The same as isColliding, but the messages go through the workspace.
+// Parameters:
+// int ID - The entity to check.
+// CollisionWorkspace &workspace - Where the work is done.
+// Output:
+// bool - Returns true if the entity is inside of something solid.
+//=============================================================================
+bool CollisionSystem::isColliding(int ID, CollisionWorkspace &workspace)
 {
 	bool collision = false;
 
 	CollisionComponent *first = getCollisionComponent(ID);
 
+	// Walls don't send messages, they only make the entity stuck
+	if (first && m_tiles.overlapsSolid(shapeBounds(first->shape())))
+	{
+		collision = true;
+	}
+
+	// Movers already know everything they can hit this frame
+	if (m_broadPhaseValid && !workspace.m_leftSweptBody)
+	{
+		SweptBody *body = getSweptBody(ID);
+
+		if (body)
+		{
+			return (candidateCollision(ID, *body, workspace) || collision);
+		}
+	}
+
 	// If the collision component exists
 	if(first)
 	{
-		pShape firstShape = first->shape();
+		queryBroadPhase(expandBounds(shapeBounds(first->shape()), m_BROAD_PHASE_MARGIN), workspace);
 
-		if(firstShape->type() == Shape::RECTANGLE)
+		if (!workspace.m_queryResults.empty())
 		{
-			// Find out what cells the rectangle is located in
-			pRectangle rect = static_cast<pRectangle>(firstShape);
+			// TODO: Limit message sending. Don't send for every collision.
+			batchCollision(ID, first->shape(), first->center(), &workspace.m_queryResults[0],
+				(int)workspace.m_queryResults.size(), collision, workspace);
+		}
+	}
 
-			Vector2D topLeft = rect->getTopLeft();
-			Vector2D topRight = rect->getTopRight();
-			Vector2D bottomLeft = rect->getBottomLeft();
-			Vector2D bottomRight = rect->getBottomRight();
-			Vector2D center = rect->center();
+	return collision;
+}
+
+//=============================================================================
+// Function: bool hasLineOfSight(int, int)
+// Description:
+// Checks to see if there's an unblocked line of sight between two entities.
+// Parameters:
+// int entityID - The first entity to start with.
+// int otherEntityID - The entity to check for line of sight.
+// Output:
+// bool - Returns true if there is line of sight.
+// Returns false if unsuccessful.
+//=============================================================================
+bool CollisionSystem::hasLineOfSight(int entityID, int otherEntityID)
+{
+	m_sightQueries.clear();
 
-			// Convert the points to cells
-			topLeft = m_grid->convertToCellCoordinates(topLeft);
-			topRight = m_grid->convertToCellCoordinates(topRight);
-			bottomLeft = m_grid->convertToCellCoordinates(bottomLeft);
-			bottomRight = m_grid->convertToCellCoordinates(bottomRight);
-			center = m_grid->convertToCellCoordinates(center);
+	SightQuery query{ entityID, otherEntityID, false };
 
-			Vector2D topLeftDist = absoluteValue(topLeft - center);
-			Vector2D topRightDist = absoluteValue(topRight - center);
-			Vector2D bottomLeftDist = absoluteValue(bottomLeft - center);
-			Vector2D bottomRightDist = absoluteValue(bottomRight - center);
+	m_sightQueries.push_back(query);
 
-			// Find the one with the greatest X distance
-			float tempX = topLeftDist.getX();
+	hasLineOfSight(m_sightQueries);
+
+	return m_sightQueries[0].m_hasSight;
+}
 
-			if (tempX < topRightDist.getX()) { tempX = topRightDist.getX(); }
-			if (tempX < bottomLeftDist.getX()) { tempX = bottomLeftDist.getX(); }
-			if (tempX < bottomRightDist.getX()) { tempX = bottomRightDist.getX(); }
+//=============================================================================
+// Function: void hasLineOfSight(std::vector<SightQuery>&)
+// Description:
+// Checks line of sight for a whole list of entity pairs. Each pair has
+// three lines, and the lines of up to ten pairs share one trip through the
+// broad phase. A trip stops as soon as every one of its lines is blocked.
+// Parameters:
+// std::vector<SightQuery> &queries - The pairs to check. m_hasSight is
+// filled in for each one.
+//=============================================================================
+void CollisionSystem::hasLineOfSight(std::vector<SightQuery> &queries)
+{
+	if ((int)m_sightLines.size() < BroadPhase::MAX_LINES)
+	{
+		Line empty{ Vector2D(0.0f, 0.0f), Vector2D(0.0f, 0.0f) };
 
-			float tempY = topLeftDist.getY();
-			
-			if (tempY < topRightDist.getY()) { tempY = topRightDist.getY(); }
-			if (tempY < bottomLeftDist.getY()) { tempY = bottomLeftDist.getY(); }
-			if (tempY < bottomRightDist.getY()) { tempY = bottomRightDist.getY(); }
+		m_sightLines.resize(BroadPhase::MAX_LINES, empty);
+		m_sightOwners.resize(BroadPhase::MAX_LINES, -1);
+	}
 
-			if (tempX <= 0) { tempX = 1; }
-			if (tempY <= 0) { tempY = 1; }
+	Line *lines = &m_sightLines[0];
+	int *owners = &m_sightOwners[0];
 
-			int distanceX = (int)round(tempX);
-			int distanceY = (int)round(tempY);
+	unsigned int next = 0;
 
-			// Find the starting grid space
-			int startingX = (int)round(center.getX() - tempX);
-			int startingY = (int)round(center.getY() - tempY);
+	while (next < queries.size())
+	{
+		int lineCount = 0;
 
-			int endingX = (int)round(center.getX() + tempX);
-			int endingY = (int)round(center.getY() + tempY);
+		// Fill up the trip with as many pairs as will fit
+		while (next < queries.size() && lineCount + m_SIGHT_LINES <= BroadPhase::MAX_LINES)
+		{
+			SightQuery &query = queries[next];
 
-			// If starting position is off the grid, fix everything
-			if (startingX < 0) 
-			{ 
-				startingX = 0;
-			}
-			if (startingY < 0) 
-			{ 
-				startingY = 0;
-			}
+			query.m_hasSight = sightLines(query.m_entityID, query.m_otherEntityID, &lines[lineCount]);
 
-			for(int y = startingY; y <= endingY; y++)
+			if (query.m_hasSight)
 			{
-				if (y < m_grid->rowCount())
+				for (int i = 0; i < m_SIGHT_LINES; i++)
 				{
-					for (int x = startingX; x <= endingX; x++)
-					{
-						if (x < m_grid->columnCount())
-						{
-							collision = collisionInCell(ID, x, y) || collision;
-						}
-						// We can't check anymore X, so break.
-						else { break; }
-					}
+					owners[lineCount + i] = (int)next;
 				}
-				// We're unable to check any more, so exit the check.
-				else { break; }
+
+				lineCount += m_SIGHT_LINES;
 			}
 
-	}
-		else if(firstShape->type() == Shape::CIRCLE)
+			next++;
+		}
+
+		if (0 < lineCount)
 		{
-			pCircle circle = static_cast<pCircle>(firstShape);
-
-			// Find the farthest point away
-			float radius = (float)circle->radius();
-			
-			Vector2D center = circle->center();
-			Vector2D topPoint{ center.getX(), center.getY() - radius };
-			Vector2D bottomPoint{ center.getX(), center.getY() + radius };
-			Vector2D leftPoint{ center.getX() - radius, center.getY() };
-			Vector2D rightPoint{ center.getX() + radius, center.getY() };
-
-			// Convert those points to the grid
-			center = m_grid->convertToCellCoordinates(center);
-			topPoint = m_grid->convertToCellCoordinates(topPoint);
-			bottomPoint = m_grid->convertToCellCoordinates(bottomPoint);
-			leftPoint = m_grid->convertToCellCoordinates(leftPoint);
-			rightPoint = m_grid->convertToCellCoordinates(rightPoint);
-
-			Vector2D topPointDist = absoluteValue(topPoint - center);
-			Vector2D bottomPointDist = absoluteValue(bottomPoint - center);
-			Vector2D leftPointDist = absoluteValue(leftPoint - center);
-			Vector2D rightPointDist = absoluteValue(rightPoint - center);
-
-			float tempX = leftPointDist.getX();
-			// We only have to check the left and right for X
-			if (tempX < rightPointDist.getX()) { tempX = rightPointDist.getX(); }
-
-			float tempY = topPointDist.getY();
-			// We only have to check the top and bottom for Y
-			if (tempY < bottomPointDist.getY()) { tempY = bottomPointDist.getY(); }
-
-			// If we're only checking one area for some reason, check more!
-			if (tempX <= 0) { tempX = 1; }
-			if (tempY <= 0) { tempY = 1; }
-
-			int distanceX = (int)round(tempX);
-			int distanceY = (int)round(tempY);
-
-			int totalXDistance = distanceX * 2;
-			int totalYDistance = distanceY * 2;
-
-			int startingX = (int)round(center.getX() - tempX);
-			int startingY = (int)round(center.getY() - tempY);
-
-			// If starting position is off the grid, fix everything
-			if (startingX < 0)
+			// Lines that run into a wall don't need to go through the broad phase
+			unsigned int openLines = 0;
+
+			for (int i = 0; i < lineCount; i++)
 			{
-				totalXDistance -= startingX;
-				startingX = 0;
+				if (!m_tiles.lineSolid(lines[i]))
+				{
+					openLines |= (1u << i);
+				}
 			}
-			if (startingY < 0)
+
+			SightVisitor visitor(this, lines, owners, openLines, queries);
+
+			if (openLines != 0)
 			{
-				totalYDistance -= startingY;
-				startingY = 0;
+				m_broadPhase->queryLines(lines, lineCount, visitor);
 			}
 
-			for(int y = startingY; y < totalYDistance; y++)
+			// A pair can see each other if any one of its lines got through
+			for (int i = 0; i < lineCount; i += m_SIGHT_LINES)
 			{
-				if (y < m_grid->rowCount())
-				{
-					for (int x = startingX; x < totalXDistance; x++)
-					{
-						if (x < m_grid->columnCount())
-						{
-							collision = collisionInCell(ID, x, y) || collision;
-						}
-						// We can't check anymore X, so break.
-						else { break; }
-					}
-				}
-				// We're unable to check any more, so exit the check.
-				else { break; }
+				unsigned int pairLines = (visitor.openLines() >> i) & ((1u << m_SIGHT_LINES) - 1);
+
+				queries[owners[i]].m_hasSight = (pairLines != 0);
 			}
 		}
 	}
-
-	return collision;
 }
 
 //=============================================================================
-// Function: bool hasLineOfSight(int, int)
+// Function: bool collisionOnLine(int, Line)
 // Description:
-// Checks to see if there's an unblocked line of sight between two entities.
+// Checks to see if the line runs into anything solid.
 // Parameters:
-// int entityID - The first entity to start with.
-// int otherEntityID - The entity to check for line of sight.
+// int entityID - The entity the line belongs to. It's skipped.
+// Line line - The line to check.
 // Output:
-// bool - Returns true if there is line of sight.
-// Returns false if unsuccessful.
+// bool - Returns true if the line hits something solid.
 //=============================================================================
-bool CollisionSystem::hasLineOfSight(int entityID, int otherEntityID)
+bool CollisionSystem::collisionOnLine(int entityID, Line line)
 {
-	bool hasSight = false;
-
-	CollisionComponent *first = getCollisionComponent(entityID);
-	CollisionComponent *second = getCollisionComponent(otherEntityID);
-
-	if (first && second)
+	if (m_tiles.lineSolid(line))
 	{
-		hasSight = true;
+		return true;
+	}
 
-		// Find the top and bottom line of sight
-		Vector2D top{ 0.0f, 0.0f };
-		Vector2D bottom{ 0.0f, 0.0f };
+	if (m_broadPhaseValid)
+	{
+		SweptBody *body = getSweptBody(entityID);
 
-		if (second->shape()->type() == Shape::RECTANGLE)
+		// The candidates only cover the swept area, so anything
+		// past it still has to go through the broad phase.
+		if (body && boundsContain(body->m_bounds, lineBounds(line)))
 		{
-			pRectangle rect = static_cast<pRectangle>(second->shape());
-
-			bool onLeftSide = false;
-
-			if (rect->center().getX() < first->center().getX())
-			{
-				onLeftSide = true;
-			}
-
+			return candidateCollisionOnLine(entityID, *body, line);
+		}
+	}
 
-			// If the rectangle is rotated, we have to find the right points
-			// to look for.
-			if (rect->rotation() != 0.0f)
-			{
-				// Find the two points with the furthest distance on the
-				// Y axis from the center.
-				Vector2D center = rect->center();
+	SolidLineVisitor visitor(this, line, entityID);
 
-				Vector2D topLeft = rect->getTopLeft();
-				Vector2D topRight = rect->getTopRight();
-				Vector2D bottomLeft = rect->getBottomLeft();
-				Vector2D bottomRight = rect->getBottomRight();
+	m_broadPhase->queryLines(&line, 1, visitor);
 
-				Vector2D currentTop = topLeft;
-				Vector2D currentBottom = bottomRight;
+	return visitor.hit();
+}
 
-				float tl_yDist = topLeft.getY() - center.getY();
-				float tr_yDist = topRight.getY() - center.getY();
+//=============================================================================
+// Function: bool sweepCollision(int, Vector2D, SweepHit&)
+// Description:
+// Finds the first wall or solid entity the entity's box runs into if it
+// moves by the displacement. Sends a collision message if it was an entity,
+// since the mover will stop against it instead of ending up inside of it.
+// Parameters:
+// int ID - The entity that's moving.
+// Vector2D displacement - How far the entity is going to move.
+// SweepHit &hit - Gets when and where the entity hit something.
+// Output:
+// bool - Returns true if the entity hits something solid along the way.
+//=============================================================================
+bool CollisionSystem::sweepCollision(int ID, Vector2D displacement, SweepHit &hit)
+{
+	return sweepCollision(ID, displacement, hit, m_workspace);
+}
 
-				if (abs(tl_yDist) < abs(tr_yDist))
-				{
-					currentTop = topRight;
-					currentBottom = bottomLeft;
-				}
-				else if (abs(tl_yDist) == abs(tr_yDist))
-				{
-					if (topRight.getY() < topLeft.getY() && onLeftSide)
-					{
-						currentTop = bottomRight;
-						currentBottom = bottomLeft;
-					}
-					else if (topLeft.getY() < topRight.getY() && !onLeftSide)
-					{
-						currentTop = bottomLeft;
-						currentBottom = bottomRight;
-					}
-				}
+//=============================================================================
+// Function: bool sweepCollision(int, Vector2D, SweepHit&, CollisionWorkspace&)
+// Description:
+// The same as sweepCollision, but the message goes through the workspace.
+// Parameters:
+// int ID - The entity that's moving.
+// Vector2D displacement - How far the entity is going to move.
+// SweepHit &hit - Gets when and where the entity hit something.
+// CollisionWorkspace &workspace - Where the work is done.
+// Output:
+// bool - Returns true if the entity hits something solid along the way.
+//=============================================================================
+bool CollisionSystem::sweepCollision(int ID, Vector2D displacement, SweepHit &hit, CollisionWorkspace &workspace)
+{
+	CollisionComponent *component = getCollisionComponent(ID);
 
-				top = currentTop;
-				bottom = currentBottom;
-			}
-			else
-			{
-				if (onLeftSide)
-				{
-					top = rect->getTopRight();
-					bottom = rect->getBottomRight();
-				}
-				else
-				{
-					top = rect->getTopLeft();
-					bottom = rect->getBottomLeft();
-				}
-			}
-		}
-		else if (second->shape()->type() == Shape::CIRCLE)
-		{
-			pCircle circle = static_cast<pCircle>(second->shape());
+	if (!component)
+	{
+		return false;
+	}
 
-			top.setX(circle->center().getX());
-			top.setY(circle->center().getY() - (float)circle->radius());
+	AABB moving = shapeBounds(component->shape());
+	AABB swept = expandBounds(combineBounds(moving, translateBounds(moving, displacement)), m_BROAD_PHASE_MARGIN);
 
-			bottom.setX(circle->center().getX());
-			bottom.setY(circle->center().getY() - (float)circle->radius());
-		}
+	hit.m_time = 2.0f;
+	hit.m_normal = Vector2D(0.0f, 0.0f);
+	hit.m_entityID = -1;
 
-		Line lineToTop{ first->center(), top };
-		Line lineToBottom{ first->center(), bottom };
+	float wallTime = 0.0f;
+	Vector2D wallNormal{ 0.0f, 0.0f };
 
-		Line lineOfSight{ first->center(), second->center() };
+	bool wallHit = false;
 
-		Vector2D gridStart = lineOfSight.start;
-		Vector2D gridEnd = lineOfSight.end;
+	if (m_fixedPoint)
+	{
+		Fixed fixedWallTime = 0;
 
-		gridStart = m_grid->convertToCellCoordinates(gridStart);
-		gridEnd = m_grid->convertToCellCoordinates(gridEnd);
+		wallHit = m_tiles.sweep(fixedShapeBounds(component->shape()), toFixed(displacement), fixedWallTime, wallNormal);
+		wallTime = toFloat(fixedWallTime);
+	}
+	else
+	{
+		wallHit = m_tiles.sweep(moving, displacement, wallTime, wallNormal);
+	}
 
-		int xStart = (int)round(gridStart.getX());
-		int yStart = (int)round(gridStart.getY());
-		int xEnd = (int)round(gridEnd.getX());
-		int yEnd = (int)round(gridEnd.getY());
+	if (wallHit)
+	{
+		hit.m_time = wallTime;
+		hit.m_normal = wallNormal;
+	}
 
-		bool topSeen = true;
-		bool bottomSeen = true;
-		bool centerSeen = true;
+	SweptBody *body = (m_broadPhaseValid && !workspace.m_leftSweptBody ? getSweptBody(ID) : NULL);
 
-		if (gridEnd.getX() < gridStart.getX())
+	// Movers already know everything they can hit as long as they stay
+	// inside of the box they said they'd move through.
+	if (body && boundsContain(body->m_bounds, swept))
+	{
+		if (0 < body->m_candidateCount)
 		{
-			xStart = xEnd;
-			xEnd = (int)round(gridStart.getX());
+			sweepAgainst(ID, moving, displacement, &m_candidates[body->m_firstCandidate], body->m_candidateCount, hit);
 		}
+	}
+	else
+	{
+		queryBroadPhase(swept, workspace);
 
-		if (gridEnd.getY() < gridStart.getY())
+		if (!workspace.m_queryResults.empty())
 		{
-			yStart = yEnd;
-			yEnd = (int)round(gridStart.getY());
+			sweepAgainst(ID, moving, displacement, &workspace.m_queryResults[0], (int)workspace.m_queryResults.size(), hit);
 		}
+	}
 
-		if (xStart == xEnd || yStart == yEnd)
-		{
-			if (xStart == xEnd && yStart != yEnd)
-			{
-				for (int i = yStart; i < yEnd; i++)
-				{
-					Node<int> *cell = m_grid->getCell(xStart, i);
-
-					while (cell != NULL)
-					{
-						if (cell->data() != entityID && cell->data() != otherEntityID)
-						{
-							CollisionComponent *comp = getCollisionComponent(cell->data());
-
-							if (comp)
-							{
-								if (handleCollision(lineOfSight, comp->shape()))
-								{
-									std::cout << "Collided with entity: " << cell->data() << std::endl;
-									hasSight = false;
-								}
-							}
-						}
-
-						cell = cell->m_next;
-					}
-				}
-			}
-			else if (yStart == yEnd && xStart != xEnd)
-			{
-				for (int i = xStart; i < xEnd; i++)
-				{
-					Node<int> *cell = m_grid->getCell(i, yStart);
-
-					while (cell != NULL)
-					{
-						if (cell->data() != entityID && cell->data() != otherEntityID)
-						{
-							CollisionComponent *comp = getCollisionComponent(cell->data());
-
-							if (comp)
-							{
-								if (handleCollision(lineOfSight, comp->shape()))
-								{
-									centerSeen = false;
-								}
-
-								if (handleCollision(lineToTop, comp->shape()))
-								{
-									topSeen = false;
-								}
-
-								if (handleCollision(lineToBottom, comp->shape()))
-								{
-									bottomSeen = false;
-								}
-							}
-						}
-
-						cell = cell->m_next;
-					}
-				}
-			}
-			else
-			{
-				Node<int> *cell = m_grid->getCell(xStart, yStart);
+	if (1.0f < hit.m_time)
+	{
+		return false;
+	}
 
-				while (cell != NULL)
-				{
-					if (cell->data() != entityID && cell->data() != otherEntityID)
-					{
-						CollisionComponent *comp = getCollisionComponent(cell->data());
-
-						if (comp)
-						{
-							if (handleCollision(lineOfSight, comp->shape()))
-							{
-								centerSeen = false;
-							}
-
-							if (handleCollision(lineToTop, comp->shape()))
-							{
-								topSeen = false;
-							}
-
-							if (handleCollision(lineToBottom, comp->shape()))
-							{
-								bottomSeen = false;
-							}
-						}
-					}
-
-					cell = cell->m_next;
-				}
-			}
-		}
-		else
+	if (hit.m_entityID == -1)
+	{
+		return true;
+	}
+
+	sendCollisionMessage(ID, hit.m_entityID, component->center() + (displacement * hit.m_time), workspace);
+
+	return true;
+}
+
+//=============================================================================
+// Function: bool circleCollision(int, int)
+// Description:
+// Checks a circle around the entity against everything it overlaps and
+// sends a collision message for each hit.
+// Parameters:
+// int ID - The entity at the center of the circle.
+// int radius - The radius of the circle.
+// Output:
+// bool - Returns true if the circle touches anything.
+//=============================================================================
+bool CollisionSystem::circleCollision(int ID, int radius)
+{
+	bool isColliding = false;
+
+	CollisionComponent *collision = getCollisionComponent(ID);
+
+	if (collision)
+	{
+		Shape::Circle circle(collision->center().getX(), collision->center().getY(), radius);
+
+		pShape shapeA = static_cast<pShape>(&circle);
+
+		m_queryResults.clear();
+		m_broadPhase->query(expandBounds(shapeBounds(shapeA), m_BROAD_PHASE_MARGIN), m_queryResults);
+
+		if (!m_queryResults.empty())
 		{
-			for (int i = xStart; i < xEnd; i++)
-			{
-				if (0 <= i && i < m_grid->columnCount())
-				{
-					for (int j = yStart; j < yEnd; j++)
-					{
-						if (0 <= j && j < m_grid->rowCount())
-						{
-							Node<int> *cell = m_grid->getCell(i, j);
-
-							while (cell != NULL)
-							{
-								if (cell->data() != entityID && cell->data() != otherEntityID)
-								{
-									CollisionComponent *comp = getCollisionComponent(cell->data());
-
-									if (comp)
-									{
-										if (handleCollision(lineOfSight, comp->shape()))
-										{
-											centerSeen = false;
-										}
-
-										if (handleCollision(lineToTop, comp->shape()))
-										{
-											topSeen = false;
-										}
-
-										if (handleCollision(lineToBottom, comp->shape()))
-										{
-											bottomSeen = false;
-										}
-									}
-								}
-
-								cell = cell->m_next;
-							}
-						}
-					}
-				}
-			}
-		}
+			bool solid = false;
 
-		hasSight = (centerSeen || topSeen || bottomSeen);
+			isColliding = (0 < batchCollision(ID, shapeA, circle.center(), &m_queryResults[0], (int)m_queryResults.size(), solid, m_workspace));
+		}
 	}
 
-	return hasSight;
+	return isColliding;
 }
 
-bool CollisionSystem::collisionOnLine(int entityID, Line line)
+//=============================================================================
+// Function: bool squareCollision(int, int, int, int, int)
+// Description:
+// Checks a rectangle against everything it overlaps and sends a collision
+// message from the entity for each hit.
+// Parameters:
+// int ID - The entity doing the check. It's skipped.
+// int centerX - The x center of the rectangle.
+// int centerY - The y center of the rectangle.
+// int width - The width of the rectangle.
+// int height - The height of the rectangle.
+// Output:
+// bool - Returns true if the rectangle touches anything.
+//=============================================================================
+bool CollisionSystem::squareCollision(int ID, int centerX, int centerY, int width, int height)
 {
-	bool collision = false;
+	bool colliding = false;
 
-	Vector2D gridStart = line.start;
-	Vector2D gridEnd = line.end;
+	Shape::Rectangle rect((float)centerX, (float)centerY, width, height);
 
-	int gridMaxX = m_grid->cellSize() * m_grid->columnCount();
-	int gridMaxY = m_grid->cellSize() * m_grid->rowCount();
+	pShape shapeA = static_cast<pShape>(&rect);
 
-	if (gridStart.getX() < 0) { gridStart.setX(0); }
-	else if (gridMaxY < gridStart.getX()) { gridStart.setX((float)gridMaxY); }
+	m_queryResults.clear();
+	m_broadPhase->query(expandBounds(shapeBounds(shapeA), m_BROAD_PHASE_MARGIN), m_queryResults);
 
-	if (gridStart.getY() < 0) { gridStart.setY(0); }
-	else if (gridMaxY < gridStart.getY()) { gridStart.setY((float)gridMaxY); }
-	
-	if (gridEnd.getX() < 0) { gridEnd.setX(0); }
-	else if (gridMaxX < gridEnd.getX()) { gridEnd.setX((float)gridMaxX); }
-	
-	if (gridEnd.getY() < 0) { gridEnd.setY(0); }
-	else if (gridMaxY < gridEnd.getY()) { gridEnd.setY((float)gridMaxY); }
+	if (!m_queryResults.empty())
+	{
+		bool solid = false;
 
-	gridStart = m_grid->convertToCellCoordinates(gridStart);
-	gridEnd = m_grid->convertToCellCoordinates(gridEnd);
+		colliding = (0 < batchCollision(ID, shapeA, Vector2D((float)centerX, (float)centerY), &m_queryResults[0],
+			(int)m_queryResults.size(), solid, m_workspace));
+	}
+
+	return colliding;
+}
+
+//=============================================================================
+// Function: int queryRadius(Vector2D, float, std::vector<int>&, int)
+// Description:
+// Finds every entity whose shape touches the circle.
+// Parameters:
+// Vector2D center - The center of the circle.
+// float radius - The radius of the circle.
+// std::vector<int> &results - Gets the entities that were found.
+// int ignoreID - An entity to leave out, usually the one asking.
+// Output:
+// int - How many entities were found.
+//=============================================================================
+int CollisionSystem::queryRadius(Vector2D center, float radius, std::vector<int> &results, int ignoreID)
+{
+	results.clear();
+
+	Shape::Circle circle(center.getX(), center.getY(), (int)radius);
+
+	pShape shape = static_cast<pShape>(&circle);
+
+	m_queryResults.clear();
+	m_broadPhase->query(expandBounds(shapeBounds(shape), m_BROAD_PHASE_MARGIN), m_queryResults);
+
+	NarrowPhaseBatch &narrowPhase = m_workspace.m_narrowPhase;
+	std::vector<int> &batchEntities = m_workspace.m_batchEntities;
+
+	narrowPhase.clear();
+	narrowPhase.setFixedPoint(m_fixedPoint);
+	batchEntities.clear();
+
+	for (unsigned int i = 0; i < m_queryResults.size(); i++)
+	{
+		if (m_queryResults[i] != ignoreID)
+		{
+			CollisionComponent *component = getCollisionComponent(m_queryResults[i]);
+
+			if (component)
+			{
+				narrowPhase.addPair(shape, component->shape());
+				batchEntities.push_back(m_queryResults[i]);
+			}
+		}
+	}
+
+	narrowPhase.run();
+
+	for (int i = 0; i < narrowPhase.size(); i++)
+	{
+		if (narrowPhase.result(i))
+		{
+			results.push_back(batchEntities[i]);
+		}
+	}
+
+	return (int)results.size();
+}
+
+//=============================================================================
+// Function: int queryBounds(const AABB, std::vector<int>&, int)
+// Description:
+// Finds every entity whose bounding box overlaps the box.
+// Parameters:
+// const AABB bounds - The box to look in.
+// std::vector<int> &results - Gets the entities that were found.
+// int ignoreID - An entity to leave out, usually the one asking.
+// Output:
+// int - How many entities were found.
+//=============================================================================
+int CollisionSystem::queryBounds(const AABB bounds, std::vector<int> &results, int ignoreID)
+{
+	results.clear();
+
+	m_queryResults.clear();
+	m_broadPhase->query(bounds, m_queryResults);
+
+	for (unsigned int i = 0; i < m_queryResults.size(); i++)
+	{
+		if (m_queryResults[i] != ignoreID)
+		{
+			CollisionComponent *component = getCollisionComponent(m_queryResults[i]);
+
+			// The tree's boxes are bigger than the shapes in them
+			if (component && boundsOverlap(bounds, shapeBounds(component->shape())))
+			{
+				results.push_back(m_queryResults[i]);
+			}
+		}
+	}
+
+	return (int)results.size();
+}
+
+//=============================================================================
+// Function: int queryNearest(Vector2D, float, int, std::vector<int>&, int)
+// Description:
+// Finds the entities touching the circle whose centers are closest to the
+// circle's center, closest first.
+// Parameters:
+// Vector2D center - The center of the circle.
+// float radius - The radius of the circle.
+// int count - The most entities to find.
+// std::vector<int> &results - Gets the entities that were found.
+// int ignoreID - An entity to leave out, usually the one asking.
+// Output:
+// int - How many entities were found.
+//=============================================================================
+int CollisionSystem::queryNearest(Vector2D center, float radius, int count, std::vector<int> &results, int ignoreID)
+{
+	queryRadius(center, radius, m_nearbyIDs, ignoreID);
+
+	sortByDistance(center, m_nearbyIDs);
+
+	results.clear();
+
+	for (int i = 0; i < count && i < (int)m_nearby.size(); i++)
+	{
+		results.push_back(m_nearby[i].m_entityID);
+	}
+
+	return (int)results.size();
+}
+
+//=============================================================================
+// Function: int nearestOfType(Vector2D, float, const std::string&, int)
+// Description:
+// Finds the closest entity of a type that's touching the circle.
+// Parameters:
+// Vector2D center - The center of the circle.
+// float radius - The radius of the circle.
+// const std::string &type - The type of entity to look for. EX: Player
+// int ignoreID - An entity to leave out, usually the one asking.
+// Output:
+// int - The closest entity of the type.
+// Returns -1 if there isn't one.
+//=============================================================================
+int CollisionSystem::nearestOfType(Vector2D center, float radius, const std::string &type, int ignoreID)
+{
+	queryRadius(center, radius, m_nearbyIDs, ignoreID);
+
+	EntitySystem *sysEntity = EntitySystem::instance();
+
+	int nearest = -1;
+	float nearestDistance = 0.0f;
+
+	for (unsigned int i = 0; i < m_nearbyIDs.size(); i++)
+	{
+		int ID = m_nearbyIDs[i];
+
+		if (sysEntity->entityType(ID) == type)
+		{
+			Vector2D offset = getCollisionComponent(ID)->center() - center;
+
+			float distance = (offset.getX() * offset.getX()) + (offset.getY() * offset.getY());
+
+			if (nearest == -1 || distance < nearestDistance || (distance == nearestDistance && ID < nearest))
+			{
+				nearest = ID;
+				nearestDistance = distance;
+			}
+		}
+	}
+
+	return nearest;
+}
+
+CollisionComponent* CollisionSystem::getCollisionComponent(int ID)
+{
+	CollisionComponent *component = NULL;
+
+	auto mit = m_components.find(ID);
+
+	if (mit != m_components.end())
+	{
+		component = mit->second;
+	}
+
+	return component;
+}
+
+CollisionComponent* CollisionSystem::createCollisionComponent(
+	int ID,
+	Shape::ShapeType shape,
+	float centerX,
+	float centerY)
+{
+	CollisionComponent *component = NULL;
+
+	auto mit = m_components.find(ID);
+
+	// If the component doesn't already exist create it
+	if (mit == m_components.end())
+	{
+		pShape shapeToCreate = NULL;
+
+		// Decide which shape to create
+		switch (shape)
+		{
+		case Shape::RECTANGLE:
+		{
+			shapeToCreate = new Shape::Rectangle();
+			break;
+		}
+		case Shape::CIRCLE:
+		{
+			shapeToCreate = new Shape::Circle();
+			break;
+		}
+		}
+
+		// Make sure the shape was properly created before continuing
+		if (shapeToCreate)
+		{
+			shapeToCreate->setCenter(centerX, centerY);
+
+			component = new CollisionComponent(shapeToCreate);
+
+			// Add the object to the broad phase
+			m_broadPhase->add(ID, shapeBounds(shapeToCreate));
+
+			m_components.insert(std::make_pair(ID, component));
+
+			// The new component isn't in anyone's candidate list
+			m_broadPhaseValid = false;
+		}
+	}
+	// Otherwise, return the existing collision component
+	else
+	{
+		component = mit->second;
+	}
+
+	return component;
+}
+
+void CollisionSystem::updatePosition(int ID, float movedX, float movedY)
+{
+	updatePosition(ID, movedX, movedY, m_workspace);
+}
+
+//=============================================================================
+// Function: void updatePosition(int, float, float, CollisionWorkspace&)
+// Description:
+// Moves the entity's shape. A deferred workspace holds on to the broad
+// phase update until it's flushed, so nothing shared is written to.
+// Parameters:
+// int ID - The entity to move.
+// float movedX - The new x center.
+// float movedY - The new y center.
+// CollisionWorkspace &workspace - Where the work is done.
+//=============================================================================
+void CollisionSystem::updatePosition(int ID, float movedX, float movedY, CollisionWorkspace &workspace)
+{
+	CollisionComponent *component = getCollisionComponent(ID);
+	
+	// Make sure there's a component to move before moving it
+	if (component)
+	{
+		pShape shape = component->shape();
+
+		// Actually move it
+		shape->setCenter(movedX, movedY);
+
+		// Move its location in the broad phase
+		if (workspace.m_deferred)
+		{
+			if (workspace.m_moved.empty() || workspace.m_moved.back() != ID)
+			{
+				workspace.m_moved.push_back(ID);
+			}
+		}
+		else
+		{
+			m_broadPhase->update(ID, shapeBounds(shape));
+		}
+
+		// Anything that moves outside of its swept box could hit
+		// something the candidate pairs don't know about.
+		if (m_broadPhaseValid)
+		{
+			SweptBody *body = getSweptBody(ID);
+
+			if (!body || !boundsContain(body->m_bounds, shapeBounds(shape)))
+			{
+				if (workspace.m_deferred)
+				{
+					workspace.m_leftSweptBody = true;
+				}
+				else
+				{
+					m_broadPhaseValid = false;
+				}
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: void flushWorkspace(CollisionWorkspace&)
+// Description:
+// Updates the broad phase for everything the workspace moved and sends
+// its messages in the order they were made.
+// Parameters:
+// CollisionWorkspace &workspace - The workspace to flush.
+//=============================================================================
+void CollisionSystem::flushWorkspace(CollisionWorkspace &workspace)
+{
+	for (unsigned int i = 0; i < workspace.m_moved.size(); i++)
+	{
+		CollisionComponent *component = getCollisionComponent(workspace.m_moved[i]);
+
+		if (component)
+		{
+			m_broadPhase->update(workspace.m_moved[i], shapeBounds(component->shape()));
+		}
+	}
+
+	if (workspace.m_leftSweptBody)
+	{
+		m_broadPhaseValid = false;
+	}
+
+	for (unsigned int i = 0; i < workspace.m_messages.size(); i++)
+	{
+		DeferredMessage &deferred = workspace.m_messages[i];
+
+		IMessage *message = NULL;
+
+		if (deferred.m_type == IMessage::MOVE)
+		{
+			message = new MoveMessage(deferred.m_entityID, deferred.m_from, deferred.m_to);
+		}
+		else
+		{
+			message = new CollisionMessage(deferred.m_entityID, deferred.m_otherID, deferred.m_from);
+
+			recordContact(deferred.m_entityID, deferred.m_otherID, deferred.m_from);
+		}
+
+		MessageSystem::instance()->pushMessage(message);
+	}
+
+	workspace.m_moved.clear();
+	workspace.m_messages.clear();
+	workspace.m_leftSweptBody = false;
+}
+
+//=============================================================================
+// Function: void queryBroadPhase(const AABB, CollisionWorkspace&)
+// Description:
+// Fills the workspace's query results with everything in the broad phase
+// near the bounds. The broad phase doesn't know where a deferred workspace
+// moved things yet, so those are checked against the bounds here.
+// Parameters:
+// const AABB bounds - The area to look in.
+// CollisionWorkspace &workspace - Where the results go.
+//=============================================================================
+void CollisionSystem::queryBroadPhase(const AABB bounds, CollisionWorkspace &workspace)
+{
+	std::vector<int> &results = workspace.m_queryResults;
+
+	results.clear();
+	m_broadPhase->query(bounds, results);
+
+	for (unsigned int i = 0; i < workspace.m_moved.size(); i++)
+	{
+		int movedID = workspace.m_moved[i];
+
+		CollisionComponent *component = getCollisionComponent(movedID);
+
+		if (component && boundsOverlap(shapeBounds(component->shape()), bounds) &&
+			std::find(results.begin(), results.end(), movedID) == results.end())
+		{
+			results.push_back(movedID);
+		}
+	}
+}
+
+//=============================================================================
+// Function: void updateBounds(int)
+// Description:
+// Lets the broad phase know the entity's shape changed size or rotated.
+// Call this after changing a collision shape without moving it.
+// Parameters:
+// int ID - The entity whose shape changed.
+//=============================================================================
+void CollisionSystem::updateBounds(int ID)
+{
+	CollisionComponent *component = getCollisionComponent(ID);
+
+	if (component)
+	{
+		m_broadPhase->update(ID, shapeBounds(component->shape()));
+
+		m_broadPhaseValid = false;
+	}
+}
+
+//=============================================================================
+// Function: void processMessage(IMessage*)
+// Description:
+// Processes the messages passed to it.
+// Parameters:
+// IMessage *message - The message to process.
+//=============================================================================
+void CollisionSystem::processMessage(IMessage *message)
+{
+	switch(message->type())
+	{
+	case IMessage::ENTITY_DESTROY:
+	{
+		EntityDestroyMessage *destroy = static_cast<EntityDestroyMessage*>(message);
+
+		removeCollisionComponent(destroy->m_entityID);
+
+		break;
+	}
+	}
+}
+
+//=============================================================================
+// Function: void beginBroadPhase()
+// Description:
+// Clears out the last frame's broad phase so the new movers can be added.
+// Until buildCandidatePairs is called, every query walks the grid.
+//=============================================================================
+void CollisionSystem::beginBroadPhase()
+{
+	m_sweptBodies.clear();
+	m_pairs.clear();
+	m_candidates.clear();
+
+	m_broadPhaseValid = false;
+}
+
+//=============================================================================
+// Function: void addSweptBody(int, Vector2D)
+// Description:
+// Registers an entity that's going to move this frame. Its box covers
+// everywhere it can be between its current and its final position.
+// Parameters:
+// int ID - The entity that's moving.
+// Vector2D displacement - How far the entity will move this frame.
+//=============================================================================
+void CollisionSystem::addSweptBody(int ID, Vector2D displacement)
+{
+	CollisionComponent *component = getCollisionComponent(ID);
+
+	if (component)
+	{
+		AABB start = shapeBounds(component->shape());
+		AABB end = translateBounds(start, displacement);
+
+		SweptBody body{ expandBounds(combineBounds(start, end), m_BROAD_PHASE_MARGIN), 0, 0 };
+
+		m_sweptBodies[ID] = body;
+	}
+}
+
+//=============================================================================
+// Function: void buildCandidatePairs()
+// Description:
+// Finds every pair of overlapping boxes that has at least one mover in it.
+// Each pair is only stored once, then every mover gets a list of the
+// entities it can possibly collide with this frame.
+//=============================================================================
+void CollisionSystem::buildCandidatePairs()
+{
+	m_pairs.clear();
+	m_candidates.clear();
+
+	auto sit = m_sweptBodies.begin();
+
+	while (sit != m_sweptBodies.end())
+	{
+		findSweptPairs(sit->first, sit->second);
+		sit++;
+	}
+
+	findMoverPairs();
+
+	// Keep the pairs in ID order so the messages they cause come out in the
+	// same order every frame, and make sure no pair got stored twice.
+	std::sort(m_pairs.begin(), m_pairs.end(), [](const CollisionPair &a, const CollisionPair &b)
+	{
+		return (a.m_entityA < b.m_entityA) ||
+			(a.m_entityA == b.m_entityA && a.m_entityB < b.m_entityB);
+	});
+
+	auto last = std::unique(m_pairs.begin(), m_pairs.end(), [](const CollisionPair &a, const CollisionPair &b)
+	{
+		return (a.m_entityA == b.m_entityA && a.m_entityB == b.m_entityB);
+	});
+
+	m_pairs.erase(last, m_pairs.end());
+
+	// Count how many candidates each mover has
+	for (unsigned int i = 0; i < m_pairs.size(); i++)
+	{
+		SweptBody *bodyA = getSweptBody(m_pairs[i].m_entityA);
+		SweptBody *bodyB = getSweptBody(m_pairs[i].m_entityB);
+
+		if (bodyA) { bodyA->m_candidateCount++; }
+		if (bodyB) { bodyB->m_candidateCount++; }
+	}
+
+	// Give each mover its own range in the candidate list
+	int offset = 0;
+
+	sit = m_sweptBodies.begin();
+
+	while (sit != m_sweptBodies.end())
+	{
+		sit->second.m_firstCandidate = offset;
+		offset += sit->second.m_candidateCount;
+		sit->second.m_candidateCount = 0;
+
+		sit++;
+	}
+
+	m_candidates.resize(offset);
+
+	for (unsigned int i = 0; i < m_pairs.size(); i++)
+	{
+		SweptBody *bodyA = getSweptBody(m_pairs[i].m_entityA);
+		SweptBody *bodyB = getSweptBody(m_pairs[i].m_entityB);
+
+		if (bodyA)
+		{
+			m_candidates[bodyA->m_firstCandidate + bodyA->m_candidateCount] = m_pairs[i].m_entityB;
+			bodyA->m_candidateCount++;
+		}
+
+		if (bodyB)
+		{
+			m_candidates[bodyB->m_firstCandidate + bodyB->m_candidateCount] = m_pairs[i].m_entityA;
+			bodyB->m_candidateCount++;
+		}
+	}
+
+	m_broadPhaseValid = true;
+}
+
+//=============================================================================
+// Function: void endBroadPhase()
+// Description:
+// Stops queries from using the candidate pairs. The pairs are kept around
+// until the next beginBroadPhase so they can still be looked at.
+//=============================================================================
+void CollisionSystem::endBroadPhase()
+{
+	m_broadPhaseValid = false;
+}
+
+//=============================================================================
+// Function: void publishContacts()
+// Description:
+// Replaces the contact lists with the collisions recorded since the last
+// publish. They're counted and placed by entity, so each entity's contacts
+// stay in the order they were found. Then each entity's list is packed
+// down, combining repeats of the same contact and keeping the latest
+// position, the same as collision messages are combined. Contacts of
+// entities deleted since they were recorded are dropped, so they don't end
+// up with whatever takes the slot next.
+//=============================================================================
+void CollisionSystem::publishContacts()
+{
+	EntitySystem *sysEntity = EntitySystem::instance();
+
+	int maxSlot = -1;
+	unsigned int kept = 0;
+
+	for (unsigned int i = 0; i < m_recordedContacts.size(); i++)
+	{
+		int entityID = m_recordedContacts[i].m_entityID;
+
+		if (0 <= entityID && sysEntity->entityExists(entityID))
+		{
+			if (maxSlot < entitySlot(entityID))
+			{
+				maxSlot = entitySlot(entityID);
+			}
+
+			m_recordedContacts[kept] = m_recordedContacts[i];
+			kept++;
+		}
+	}
+
+	m_recordedContacts.erase(m_recordedContacts.begin() + kept, m_recordedContacts.end());
+
+	m_contactStart.assign(maxSlot + 2, 0);
+	m_contactOwners.assign(maxSlot + 1, -1);
+
+	// Only one entity can be alive in a slot, so every kept record for a
+	// slot has the same owner
+	for (unsigned int i = 0; i < m_recordedContacts.size(); i++)
+	{
+		int slot = entitySlot(m_recordedContacts[i].m_entityID);
+
+		m_contactStart[slot + 1]++;
+		m_contactOwners[slot] = m_recordedContacts[i].m_entityID;
+	}
+
+	for (int i = 0; i <= maxSlot; i++)
+	{
+		m_contactStart[i + 1] += m_contactStart[i];
+	}
+
+	Contact empty{ -1, Vector2D(0.0f, 0.0f), false };
+
+	m_contacts.assign(m_contactStart[maxSlot + 1], empty);
+	m_contactFill.assign(m_contactStart.begin(), m_contactStart.end());
+
+	for (unsigned int i = 0; i < m_recordedContacts.size(); i++)
+	{
+		int slot = entitySlot(m_recordedContacts[i].m_entityID);
+
+		m_contacts[m_contactFill[slot]++] = m_recordedContacts[i].m_contact;
+	}
+
+	m_recordedContacts.clear();
+
+	// Packing only ever moves contacts down, so it can be done in place
+	int packed = 0;
+
+	for (int slot = 0; slot <= maxSlot; slot++)
+	{
+		int end = m_contactStart[slot + 1];
+		int start = m_contactStart[slot];
+
+		m_contactStart[slot] = packed;
+
+		for (int i = start; i < end; i++)
+		{
+			Contact &contact = m_contacts[i];
+
+			int repeat = m_contactStart[slot];
+
+			while (repeat < packed && (m_contacts[repeat].m_otherID != contact.m_otherID ||
+				m_contacts[repeat].m_checked != contact.m_checked))
+			{
+				repeat++;
+			}
+
+			if (repeat < packed)
+			{
+				m_contacts[repeat].m_position = contact.m_position;
+			}
+			else
+			{
+				m_contacts[packed] = contact;
+				packed++;
+			}
+		}
+	}
+
+	m_contactStart[maxSlot + 1] = packed;
+	m_contacts.erase(m_contacts.begin() + packed, m_contacts.end());
+}
+
+//=============================================================================
+// Function: int contacts(int, const Contact*&)
+// Description:
+// Gets an entity's contacts from the last publish. An old ID for a slot
+// that's been reused gets none.
+// Parameters:
+// int entityID - The entity to get the contacts of.
+// const Contact *& first - Gets the first contact. NULL if there are none.
+// Output:
+// int - How many contacts there are.
+//=============================================================================
+int CollisionSystem::contacts(int entityID, const Contact *& first)
+{
+	first = NULL;
+
+	int slot = entitySlot(entityID);
+
+	if (entityID < 0 || (int)m_contactStart.size() <= slot + 1 || m_contactOwners[slot] != entityID)
+	{
+		return 0;
+	}
+
+	int count = m_contactStart[slot + 1] - m_contactStart[slot];
+
+	if (0 < count)
+	{
+		first = &m_contacts[m_contactStart[slot]];
+	}
+
+	return count;
+}
+
+// Private Functions
+//=============================================================================
+// Function: bool sightLines(int, int, Line[])
+// Description:
+// Builds the three lines used for line of sight. One goes to the other
+// entity's center and the other two go to its top and bottom edges.
+// Parameters:
+// int entityID - The entity looking.
+// int otherEntityID - The entity being looked for.
+// Line lines[] - Where the three lines are stored.
+// Output:
+// bool - Returns false if either entity doesn't have a collision component.
+//=============================================================================
+bool CollisionSystem::sightLines(int entityID, int otherEntityID, Line lines[])
+{
+	CollisionComponent *first = getCollisionComponent(entityID);
+	CollisionComponent *second = getCollisionComponent(otherEntityID);
+
+	if (!first || !second)
+	{
+		return false;
+	}
+
+	// Find the top and bottom line of sight
+	Vector2D top{ 0.0f, 0.0f };
+	Vector2D bottom{ 0.0f, 0.0f };
+
+	if (second->shape()->type() == Shape::RECTANGLE)
+	{
+		pRectangle rect = static_cast<pRectangle>(second->shape());
+
+		bool onLeftSide = false;
+
+		if (rect->center().getX() < first->center().getX())
+		{
+			onLeftSide = true;
+		}
+
+
+		// If the rectangle is rotated, we have to find the right points
+		// to look for.
+		if (rect->rotation() != 0.0f)
+		{
+			// Find the two points with the furthest distance on the
+			// Y axis from the center.
+			Vector2D center = rect->center();
 
-	int xStart = (int)round(gridStart.getX());
-	int yStart = (int)round(gridStart.getY());
-	int xEnd = (int)round(gridEnd.getX());
-	int yEnd = (int)round(gridEnd.getY());
+			Vector2D topLeft = rect->getTopLeft();
+			Vector2D topRight = rect->getTopRight();
+			Vector2D bottomLeft = rect->getBottomLeft();
+			Vector2D bottomRight = rect->getBottomRight();
 
-	if (gridEnd.getX() < gridStart.getX())
-	{
-		xStart = xEnd;
-		xEnd = (int)round(gridStart.getX());
-	}
+			Vector2D currentTop = topLeft;
+			Vector2D currentBottom = bottomRight;
 
-	if (gridEnd.getY() < gridStart.getY())
-	{
-		yStart = yEnd;
-		yEnd = (int)round(gridStart.getY());
-	}
+			float tl_yDist = topLeft.getY() - center.getY();
+			float tr_yDist = topRight.getY() - center.getY();
 
-	if (xStart == xEnd || yStart == yEnd)
-	{
-		if (xStart == xEnd && yStart != yEnd)
-		{
-			for (int i = yStart; i < yEnd; i++)
+			if (abs(tl_yDist) < abs(tr_yDist))
 			{
-				Node<int> *cell = m_grid->getCell(xStart, i);
-
-				while (cell != NULL)
-				{
-					if (cell->data() != entityID)
-					{
-						CollisionComponent *comp = getCollisionComponent(cell->data());
-
-						if (comp)
-						{
-							if (handleCollision(line, comp->shape()))
-							{
-								if (comp->isSolid())
-								{
-									collision = true;
-								}
-							}
-						}
-					}
-
-					cell = cell->m_next;
-				}
+				currentTop = topRight;
+				currentBottom = bottomLeft;
 			}
-		}
-		else if (yStart == yEnd && xStart != xEnd)
-		{
-			for (int i = xStart; i < xEnd; i++)
+			else if (abs(tl_yDist) == abs(tr_yDist))
 			{
-				Node<int> *cell = m_grid->getCell(i, yStart);
-
-				while (cell != NULL)
+				if (topRight.getY() < topLeft.getY() && onLeftSide)
 				{
-					if (cell->data() != entityID)
-					{
-						CollisionComponent *comp = getCollisionComponent(cell->data());
-
-						if (comp)
-						{
-							if (handleCollision(line, comp->shape()))
-							{
-								if (comp->isSolid())
-								{
-									collision = true;
-								}
-							}
-						}
-					}
-
-					cell = cell->m_next;
+					currentTop = bottomRight;
+					currentBottom = bottomLeft;
+				}
+				else if (topLeft.getY() < topRight.getY() && !onLeftSide)
+				{
+					currentTop = bottomLeft;
+					currentBottom = bottomRight;
 				}
 			}
+
+			top = currentTop;
+			bottom = currentBottom;
 		}
 		else
 		{
-			Node<int> *cell = m_grid->getCell(xStart, yStart);
-
-			while (cell != NULL)
+			if (onLeftSide)
 			{
-				if (cell->data() != entityID)
-				{
-					CollisionComponent *comp = getCollisionComponent(cell->data());
-
-					if (comp)
-					{
-						if (handleCollision(line, comp->shape()))
-						{
-							if (comp->isSolid())
-							{
-								collision = true;
-							}
-						}
-					}
-				}
-
-				cell = cell->m_next;
+				top = rect->getTopRight();
+				bottom = rect->getBottomRight();
 			}
-		}
-	}
-	else
-	{
-		for (int i = xStart; i < xEnd; i++)
-		{
-			if (0 <= i && i < m_grid->columnCount())
+			else
 			{
-				for (int j = yStart; j < yEnd; j++)
-				{
-					if (0 <= j && j < m_grid->rowCount())
-					{
-						Node<int> *cell = m_grid->getCell(i, j);
-
-						while (cell != NULL)
-						{
-							if (cell->data() != entityID)
-							{
-								CollisionComponent *comp = getCollisionComponent(cell->data());
-
-								if (comp)
-								{
-									if (handleCollision(line, comp->shape()))
-									{
-										if (comp->isSolid())
-										{
-											collision = true;
-										}
-									}
-								}
-							}
-
-							cell = cell->m_next;
-						}
-					}
-				}
+				top = rect->getTopLeft();
+				bottom = rect->getBottomLeft();
 			}
 		}
 	}
-
-	return collision;
-}
-
-bool CollisionSystem::circleCollision(int ID, int radius)
-{
-	bool isColliding = false;
-
-	CollisionComponent *collision = getCollisionComponent(ID);
-
-	if (collision)
+	else if (second->shape()->type() == Shape::CIRCLE)
 	{
-		Shape::Circle circle(collision->center().getX(), collision->center().getY(), radius);
+		pCircle circle = static_cast<pCircle>(second->shape());
 
-		// Find the farthest point away
-		float radius = (float)circle.radius();
+		top.setX(circle->center().getX());
+		top.setY(circle->center().getY() - (float)circle->radius());
 
-		Vector2D center = circle.center();
-		Vector2D topPoint{ center.getX(), center.getY() - radius };
-		Vector2D bottomPoint{ center.getX(), center.getY() + radius };
-		Vector2D leftPoint{ center.getX() - radius, center.getY() };
-		Vector2D rightPoint{ center.getX() + radius, center.getY() };
+		bottom.setX(circle->center().getX());
+		bottom.setY(circle->center().getY() + (float)circle->radius());
+	}
 
-		// Convert those points to the grid
-		center = m_grid->convertToCellCoordinates(center);
-		topPoint = m_grid->convertToCellCoordinates(topPoint);
-		bottomPoint = m_grid->convertToCellCoordinates(bottomPoint);
-		leftPoint = m_grid->convertToCellCoordinates(leftPoint);
-		rightPoint = m_grid->convertToCellCoordinates(rightPoint);
+	lines[0] = Line{ first->center(), second->center() };
+	lines[1] = Line{ first->center(), top };
+	lines[2] = Line{ first->center(), bottom };
 
-		Vector2D topPointDist = absoluteValue(topPoint - center);
-		Vector2D bottomPointDist = absoluteValue(bottomPoint - center);
-		Vector2D leftPointDist = absoluteValue(leftPoint - center);
-		Vector2D rightPointDist = absoluteValue(rightPoint - center);
+	return true;
+}
 
-		float tempX = leftPointDist.getX();
-		// We only have to check the left and right for X
-		if (tempX < rightPointDist.getX()) { tempX = rightPointDist.getX(); }
+//=============================================================================
+// Function: SweptBody* getSweptBody(int)
+// Description:
+// Gets the swept body for a mover.
+// Parameters:
+// int ID - The entity to get the swept body for.
+// Output:
+// Returns the swept body on success.
+// Returns NULL if the entity isn't moving this frame.
+//=============================================================================
+CollisionSystem::SweptBody* CollisionSystem::getSweptBody(int ID)
+{
+	SweptBody *body = NULL;
 
-		float tempY = topPointDist.getY();
-		// We only have to check the top and bottom for Y
-		if (tempY < bottomPointDist.getY()) { tempY = bottomPointDist.getY(); }
+	auto sit = m_sweptBodies.find(ID);
 
-		// If we're only checking one area for some reason, check more!
-		if (tempX <= 0) { tempX = 1; }
-		if (tempY <= 0) { tempY = 1; }
+	if (sit != m_sweptBodies.end())
+	{
+		body = &sit->second;
+	}
 
-		int distanceX = (int)round(tempX);
-		int distanceY = (int)round(tempY);
+	return body;
+}
 
-		int totalXDistance = distanceX * 2;
-		int totalYDistance = distanceY * 2;
+//=============================================================================
+// Function: void findSweptPairs(int, const SweptBody&)
+// Description:
+// Asks the broad phase for everything under the swept box and stores a pair
+// for each entity that isn't moving. Pairs of movers are found separately.
+// Parameters:
+// int ID - The mover to find pairs for.
+// const SweptBody &body - The mover's swept body.
+//=============================================================================
+void CollisionSystem::findSweptPairs(int ID, const SweptBody &body)
+{
+	m_queryResults.clear();
+	m_broadPhase->query(body.m_bounds, m_queryResults);
 
-		int startingX = (int)round(center.getX() - tempX);
-		int startingY = (int)round(center.getY() - tempY);
+	CollisionComponent *self = getCollisionComponent(ID);
 
-		// If starting position is off the grid, fix everything
-		if (startingX < 0)
-		{
-			totalXDistance -= startingX;
-			startingX = 0;
-		}
-		if (startingY < 0)
-		{
-			totalYDistance -= startingY;
-			startingY = 0;
-		}
+	for (unsigned int k = 0; k < m_queryResults.size(); k++)
+	{
+		int other = m_queryResults[k];
 
-		for (int y = startingY; y < totalYDistance; y++)
+		if (other != ID && !getSweptBody(other))
 		{
-			if (y < m_grid->rowCount())
+			CollisionComponent *component = getCollisionComponent(other);
+
+			if (component && layersCollide(self, component) &&
+				boundsOverlap(body.m_bounds, shapeBounds(component->shape())))
 			{
-				for (int x = startingX; x < totalXDistance; x++)
-				{
-					if (x < m_grid->rowCount())
-					{
-						Node<int> *cell = m_grid->getCell(x, y);
-
-						while(cell != NULL)
-						{
-							if(cell->data() != ID)
-							{
-								pShape shapeA = static_cast<pShape>(&circle);
-								CollisionComponent *componentB = getCollisionComponent(cell->data());
-
-								if (componentB)
-								{
-									if (handleCollision(shapeA, componentB->shape()))
-									{
-										isColliding = true;
-
-										sendCollisionMessage(ID, cell->data(), circle.center());
-									}
-								}
-							}
-
-							cell = cell->m_next;
-						}
-					}
-					// We can't check anymore X, so break.
-					else { break; }
-				}
+				CollisionPair pair{ std::min(ID, other), std::max(ID, other) };
+
+				m_pairs.push_back(pair);
 			}
-			// We're unable to check any more, so exit the check.
-			else { break; }
 		}
-
 	}
-
-	return isColliding;
 }
 
-bool CollisionSystem::squareCollision(int ID, int centerX, int centerY, int width, int height)
+//=============================================================================
+// Function: void findMoverPairs()
+// Description:
+// Stores a pair for every two movers whose swept boxes overlap. Two movers
+// can pass each other without either one's box touching where the other
+// started, so the broad phase can't be used for these. The movers are
+// sorted along x and swept instead.
+//=============================================================================
+void CollisionSystem::findMoverPairs()
 {
-	bool colliding = false;
-
-	// Find out what cells the rectangle is located in
-	Shape::Rectangle rect((float)centerX, (float)centerY, width, height);
+	m_sweepOrder.clear();
 
-	Vector2D topLeft = rect.getTopLeft();
-	Vector2D topRight = rect.getTopRight();
-	Vector2D bottomLeft = rect.getBottomLeft();
-	Vector2D bottomRight = rect.getBottomRight();
-	Vector2D center = rect.center();
+	auto sit = m_sweptBodies.begin();
 
-	// Convert the points to cells
-	topLeft = m_grid->convertToCellCoordinates(topLeft);
-	topRight = m_grid->convertToCellCoordinates(topRight);
-	bottomLeft = m_grid->convertToCellCoordinates(bottomLeft);
-	bottomRight = m_grid->convertToCellCoordinates(bottomRight);
-	center = m_grid->convertToCellCoordinates(center);
+	while (sit != m_sweptBodies.end())
+	{
+		m_sweepOrder.push_back(sit->first);
+		sit++;
+	}
 
-	Vector2D topLeftDist = absoluteValue(topLeft - center);
-	Vector2D topRightDist = absoluteValue(topRight - center);
-	Vector2D bottomLeftDist = absoluteValue(bottomLeft - center);
-	Vector2D bottomRightDist = absoluteValue(bottomRight - center);
+	std::sort(m_sweepOrder.begin(), m_sweepOrder.end(), [this](int a, int b)
+	{
+		return m_sweptBodies[a].m_bounds.minX < m_sweptBodies[b].m_bounds.minX;
+	});
 
-	// Find the one with the greatest X distance
-	float tempX = topLeftDist.getX();
+	for (unsigned int i = 0; i < m_sweepOrder.size(); i++)
+	{
+		AABB first = m_sweptBodies[m_sweepOrder[i]].m_bounds;
 
-	if (tempX < topRightDist.getX()) { tempX = topRightDist.getX(); }
-	if (tempX < bottomLeftDist.getX()) { tempX = bottomLeftDist.getX(); }
-	if (tempX < bottomRightDist.getX()) { tempX = bottomRightDist.getX(); }
+		for (unsigned int j = i + 1; j < m_sweepOrder.size(); j++)
+		{
+			AABB second = m_sweptBodies[m_sweepOrder[j]].m_bounds;
 
-	float tempY = topLeftDist.getY();
+			// Everything after this starts past the end of the first box
+			if (first.maxX <= second.minX)
+			{
+				break;
+			}
 
-	if (tempY < topRightDist.getY()) { tempY = topRightDist.getY(); }
-	if (tempY < bottomLeftDist.getY()) { tempY = bottomLeftDist.getY(); }
-	if (tempY < bottomRightDist.getY()) { tempY = bottomRightDist.getY(); }
+			int a = m_sweepOrder[i];
+			int b = m_sweepOrder[j];
 
-	if (tempX <= 0) { tempX = 1; }
-	if (tempY <= 0) { tempY = 1; }
+			if (boundsOverlap(first, second) &&
+				layersCollide(getCollisionComponent(a), getCollisionComponent(b)))
+			{
+				CollisionPair pair{ std::min(a, b), std::max(a, b) };
 
-	int distanceX = (int)round(tempX);
-	int distanceY = (int)round(tempY);
+				m_pairs.push_back(pair);
+			}
+		}
+	}
+}
 
-	int totalXDistance = distanceX * 2;
-	int totalYDistance = distanceY * 2;
+//=============================================================================
+// Function: bool candidateCollision(int, const SweptBody&)
+// Description:
+// Checks the mover against its candidates and sends a collision message
+// for every one it's touching.
+// Parameters:
+// int ID - The mover to check.
+// const SweptBody &body - The mover's swept body.
+// Output:
+// bool - Returns true if the mover is inside of something solid.
+//=============================================================================
+bool CollisionSystem::candidateCollision(int ID, const SweptBody &body, CollisionWorkspace &workspace)
+{
+	bool collision = false;
 
-	// Find the starting grid space
-	int startingX = (int)round(center.getX() - tempX);
-	int startingY = (int)round(center.getY() - tempY);
+	CollisionComponent *a = getCollisionComponent(ID);
 
-	// If starting position is off the grid, fix everything
-	if (startingX < 0)
-	{
-		totalXDistance -= startingX;
-		startingX = 0;
-	}
-	if (startingY < 0)
+	if (a && 0 < body.m_candidateCount)
 	{
-		totalYDistance -= startingY;
-		startingY = 0;
+		batchCollision(ID, a->shape(), a->center(), &m_candidates[body.m_firstCandidate], body.m_candidateCount, collision, workspace);
 	}
 
-	for (int y = startingY; y < totalYDistance; y++)
+	return collision;
+}
+
+//=============================================================================
+// Function: int batchCollision(int, pShape, Vector2D, const int*, int, bool&, CollisionWorkspace&)
+// Description:
+// Tests the shape against a list of entities in one batch, then sends a
+// collision message for each one it's touching.
+// Parameters:
+// int ID - The entity doing the check. It's skipped if it's in the list.
+// pShape shape - The shape to test with.
+// Vector2D position - Where the collision messages say the hit was.
+// const int *others - The entities to test against.
+// int count - How many entities are in the list.
+// bool &solid - Set to true if anything that was hit is solid.
+// CollisionWorkspace &workspace - Where the work is done.
+// Output:
+// int - How many entities the shape is touching.
+//=============================================================================
+int CollisionSystem::batchCollision(int ID, pShape shape, Vector2D position, const int *others, int count, bool &solid,
+	CollisionWorkspace &workspace)
+{
+	int hits = 0;
+
+	NarrowPhaseBatch &narrowPhase = workspace.m_narrowPhase;
+	std::vector<int> &batchEntities = workspace.m_batchEntities;
+
+	narrowPhase.clear();
+	narrowPhase.setFixedPoint(m_fixedPoint);
+	batchEntities.clear();
+
+	CollisionComponent *self = getCollisionComponent(ID);
+
+	for (int i = 0; i < count; i++)
 	{
-		if (y < m_grid->rowCount())
+		if (others[i] != ID)
 		{
-			for (int x = startingX; x < totalXDistance; x++)
+			CollisionComponent *component = getCollisionComponent(others[i]);
+
+			if (component && layersCollide(self, component))
 			{
-				if (x < m_grid->columnCount())
-				{
-					Node<int> *cell = m_grid->getCell(x, y);
-
-					while (cell != NULL)
-					{
-						if (cell->data() != ID)
-						{
-							pShape shapeA = static_cast<pShape>(&rect);
-							CollisionComponent *componentB = getCollisionComponent(cell->data());
-
-							if (componentB)
-							{
-								if (handleCollision(shapeA, componentB->shape()))
-								{
-									colliding = true;
-
-									sendCollisionMessage(ID, cell->data(), Vector2D((float)centerX, (float)centerY));
-								}
-							}
-						}
-
-						cell = cell->m_next;
-					}
-				}
-				// We can't check anymore X, so break.
-				else { break; }
+				narrowPhase.addPair(shape, component->shape());
+				batchEntities.push_back(others[i]);
 			}
 		}
-		// We're unable to check any more, so exit the check.
-		else { break; }
 	}
 
-	return colliding;
-}
+	narrowPhase.run();
 
-CollisionComponent* CollisionSystem::getCollisionComponent(int ID)
-{
-	CollisionComponent *component = NULL;
+	for (int i = 0; i < narrowPhase.size(); i++)
+	{
+		if (narrowPhase.result(i))
+		{
+			hits++;
 
-	auto mit = m_components.find(ID);
+			sendCollisionMessage(ID, batchEntities[i], position, workspace);
 
-	if (mit != m_components.end())
-	{
-		component = mit->second;
+			if (getCollisionComponent(batchEntities[i])->isSolid())
+			{
+				solid = true;
+			}
+		}
 	}
 
-	return component;
+	return hits;
 }
 
-CollisionComponent* CollisionSystem::createCollisionComponent(
-	int ID,
-	Shape::ShapeType shape,
-	float centerX,
-	float centerY)
+//=============================================================================
+// Function: void sweepAgainst(int, AABB, Vector2D, const int*, int, SweepHit&)
+// Description:
+// Sweeps the box against the solid entities in the list and keeps the
+// earliest hit. Ties go to the lowest ID so the result doesn't depend on
+// what order the broad phase handed them back in.
+// Parameters:
+// int ID - The entity that's moving. It's skipped if it's in the list.
+// AABB moving - The box that's moving.
+// Vector2D displacement - How far the box is going to move.
+// const int *others - The entities to sweep against.
+// int count - How many entities are in the list.
+// SweepHit &hit - Updated if something is hit earlier than it says.
+//=============================================================================
+void CollisionSystem::sweepAgainst(int ID, AABB moving, Vector2D displacement, const int *others, int count, SweepHit &hit)
 {
-	CollisionComponent *component = NULL;
+	CollisionComponent *self = getCollisionComponent(ID);
 
-	auto mit = m_components.find(ID);
+	// Times from the fixed point sweep are never more than 1, so they fit
+	// in a float exactly.
+	FixedBounds fixedMoving = fixedShapeBounds(self ? self->shape() : NULL);
+	FixedVector fixedDisplacement = toFixed(displacement);
 
-	// If the component doesn't already exist create it
-	if (mit == m_components.end())
+	for (int i = 0; i < count; i++)
 	{
-		pShape shapeToCreate = NULL;
-
-		// Decide which shape to create
-		switch (shape)
-		{
-		case Shape::RECTANGLE:
-		{
-			shapeToCreate = new Shape::Rectangle();
-			break;
-		}
-		case Shape::CIRCLE:
-		{
-			shapeToCreate = new Shape::Circle();
-			break;
-		}
-		}
+		CollisionComponent *component = (others[i] != ID ? getCollisionComponent(others[i]) : NULL);
 
-		// Make sure the shape was properly created before continuing
-		if (shapeToCreate)
+		if (component && component->isSolid() && layersCollide(self, component))
 		{
-			shapeToCreate->setCenter(centerX, centerY);
+			float time = 0.0f;
+			Vector2D normal{ 0.0f, 0.0f };
 
-			component = new CollisionComponent(shapeToCreate);
+			bool touched = false;
 
-			// Add the object to the grid
-			int gridX = (int)(round(centerX));
-			int gridY = (int)(round(centerY));
+			if (m_fixedPoint)
+			{
+				Fixed fixedTime = 0;
 
-//			std::cout << "adding object to grid!\n";
-			m_grid->add(ID, gridX, gridY);
+				touched = sweepFixedBounds(fixedMoving, fixedDisplacement, fixedShapeBounds(component->shape()), fixedTime, normal);
+				time = toFloat(fixedTime);
+			}
+			else
+			{
+				touched = sweepBounds(moving, displacement, shapeBounds(component->shape()), time, normal);
+			}
 
-			m_components.insert(std::make_pair(ID, component));
+			if (touched)
+			{
+				if (time < hit.m_time || (time == hit.m_time && others[i] < hit.m_entityID))
+				{
+					hit.m_time = time;
+					hit.m_normal = normal;
+					hit.m_entityID = others[i];
+				}
+			}
 		}
 	}
-	// Otherwise, return the existing collision component
-	else
-	{
-		component = mit->second;
-	}
-
-	return component;
 }
 
-void CollisionSystem::updatePosition(int ID, float movedX, float movedY)
+// Fills m_nearby with the entities and how far their centers are from the
+// point, closest first. Ties go to the lowest ID.
+void CollisionSystem::sortByDistance(Vector2D center, const std::vector<int> &entities)
 {
-	CollisionComponent *component = getCollisionComponent(ID);
-	
-	// Make sure there's a component to move before moving it
-	if (component)
-	{
-		pShape shape = component->shape();
-		Vector2D shapeCenter{ shape->center() };
+	m_nearby.clear();
 
-		int oldX = (int)(round(shapeCenter.getX()));
-		int oldY = (int)(round(shapeCenter.getY()));
+	for (unsigned int i = 0; i < entities.size(); i++)
+	{
+		Vector2D offset = getCollisionComponent(entities[i])->center() - center;
 
-		// Move its location on the grid
-		m_grid->move(ID, oldX, oldY, (int)round(movedX), (int)round(movedY));
+		NearbyEntity nearby{ (offset.getX() * offset.getX()) + (offset.getY() * offset.getY()), entities[i] };
 
-		// Actually move it
-		shape->setCenter(movedX, movedY);
+		m_nearby.push_back(nearby);
 	}
+
+	std::sort(m_nearby.begin(), m_nearby.end(), [](const NearbyEntity &a, const NearbyEntity &b)
+	{
+		return (a.m_distance < b.m_distance) ||
+			(a.m_distance == b.m_distance && a.m_entityID < b.m_entityID);
+	});
 }
 
 //=============================================================================
-// Function: void processMessage(IMessage*)
+// Function: bool candidateCollisionOnLine(int, const SweptBody&, Line)
 // Description:
-// Processes the messages passed to it.
+// Checks if the line runs into any of the mover's solid candidates.
 // Parameters:
-// IMessage *message - The message to process.
+// int ID - The mover the line belongs to.
+// const SweptBody &body - The mover's swept body.
+// Line line - The line to check. It has to be inside of the swept box.
+// Output:
+// bool - Returns true if the line hits something solid.
 //=============================================================================
-void CollisionSystem::processMessage(IMessage *message)
-{
-	switch(message->type())
-	{
-	case IMessage::ENTITY_DESTROY:
-	{
-		EntityDestroyMessage *destroy = static_cast<EntityDestroyMessage*>(message);
-
-		removeCollisionComponent(destroy->m_entityID);
-
-		break;
-	}
-	}
-}
-
-// Private Functions
-bool CollisionSystem::collisionInCell(int ID, int x, int y)
+bool CollisionSystem::candidateCollisionOnLine(int ID, const SweptBody &body, Line line)
 {
 	bool collision = false;
 
-	Node<int> *node = m_grid->getCell(x, y);
+	CollisionComponent *self = getCollisionComponent(ID);
 
-	while(node != NULL)
+	for (int i = 0; i < body.m_candidateCount && !collision; i++)
 	{
-		if(node->data() != ID)
-		{
-			// Check for a collision
-			CollisionComponent *a = getCollisionComponent(ID);
-			CollisionComponent *b = getCollisionComponent(node->data());
-
-			if (b)
-			{
-				if (handleCollision(a->shape(), b->shape()) == true)
-				{
-					//Get the center point
-					Vector2D centerPoint(a->center());
-
-					// TODO: Limit message sending. Don't send for every collision.
-					sendCollisionMessage(ID, node->data(), centerPoint);
+		CollisionComponent *component = getCollisionComponent(m_candidates[body.m_firstCandidate + i]);
 
-					if (b->isSolid())
-					{
-						collision = true;
-						return collision;
-					}
-				}
-			}
-			else
+		if (component && component->isSolid() && layersCollide(self, component))
+		{
+			if (handleCollision(line, component->shape()))
 			{
-				collision = false;
+				collision = true;
 			}
 		}
-
-		node = node->m_next;
 	}
 
 	return collision;
@@ -1170,25 +1800,19 @@ bool CollisionSystem::circleInsideRectangle(pCircle a, pRectangle b)
 {
 	bool inside = true;
 
-	int circleTop, circleBottom, circleLeft, circleRight;
-	int rectTop, rectBottom, rectLeft, rectRight;
-
-	Vector2D centerA{ a->center() };
-	Vector2D centerB{ b->center() };
+	// Put the circle in the rectangle's space, centered on the rectangle
+	Vector2D centerA{ b->toLocal(a->center()) };
 
-	// Rotate the circle around the point
-	centerA = rotatePoint(centerA, centerB, b->rotation() * -1);
+	float cX = centerA.getX();
+	float cY = centerA.getY();
 
-	int cX = (int)round(centerA.getX());
-	int cY = (int)round(centerA.getY());
+	float rectRightX = (float)b->width() * 0.5f;
+	float rectLeftX = -rectRightX;
+	float rectBottomY = (float)b->height() * 0.5f;
+	float rectTopY = -rectBottomY;
 
-	int rectLeftX = (int)round(centerB.getX() - (b->width() / 2));
-	int rectRightX = (int)round(centerB.getX() + (b->width() / 2));
-	int rectTopY = (int)round(centerB.getY() - (b->height() / 2));
-	int rectBottomY = (int)round(centerB.getY() + (b->height() / 2));
-
-	int closestX = 0;
-	int closestY = 0;
+	float closestX = 0.0f;
+	float closestY = 0.0f;
 
 	//Find the closest X point
 	if (cX < rectLeftX) { closestX = rectLeftX; }
@@ -1249,85 +1873,7 @@ bool CollisionSystem::rectInsideRect(pRectangle a, pRectangle b)
 	}
 	else
 	{
-		inside = false;
-
-		// Set up all of the corners with their rotation
-		Vector2D centerA{ a->center() };
-		Vector2D topLeftA = a->getTopLeft();
-		Vector2D topRightA = a->getTopRight();
-		Vector2D bottomLeftA = a->getBottomLeft();
-		Vector2D bottomRightA = a->getBottomRight();
-
-		Vector2D centerB{ b->center() };
-		Vector2D topLeftB = b->getTopLeft();
-		Vector2D topRightB = b->getTopRight();
-		Vector2D bottomLeftB = b->getBottomLeft();
-		Vector2D bottomRightB = b->getBottomRight();
-
-		// Check the distance between all the points and the center
-		// of the other rectangle's center.
-		const int RECT_POINTS = 4;
-
-		Vector2D pointsA[RECT_POINTS]{ topLeftA, topRightA, bottomRightA, bottomLeftA };
-		Vector2D pointsB[RECT_POINTS]{ topLeftB, topRightB, bottomRightB, bottomLeftB };
-	
-		float aDistances[RECT_POINTS];
-		float bDistances[RECT_POINTS];
-
-		for(int i = 0; i < RECT_POINTS; i++)
-		{
-			aDistances[i] = totalDistance(pointsA[i], centerB);
-			bDistances[i] = totalDistance(pointsB[i], centerA);
-		}
-
-		float smallestDistanceA = aDistances[0];
-		float smallestDistanceB = bDistances[0];
-		int indexA = 0;
-		int indexB = 0;
-
-		// Find the smallest distance for both rects
-		for(int i = 0; i < RECT_POINTS; i++)
-		{
-			if(aDistances[i] < smallestDistanceA)
-			{
-				smallestDistanceA = aDistances[i];
-				indexA = i;
-			}
-
-			if(bDistances[i] < smallestDistanceB)
-			{
-				smallestDistanceB = bDistances[i];
-				indexB = i;
-			}
-		}
-
-		// Determine which points to use for checking
-		int prevPointA = indexA - 1;
-		int nextPointA = indexA + 1;
-		
-		// Make sure the points are within range
-		if (indexA == 0) { prevPointA = RECT_POINTS - 1; }
-		if (indexA == RECT_POINTS - 1) { nextPointA = 0; }
-		
-		// Do the same for B
-		int prevPointB = indexB - 1;
-		int nextPointB = indexB + 1;
-
-		if (indexB == 0) { prevPointB = RECT_POINTS - 1; }
-		if (indexB == RECT_POINTS - 1) { nextPointB = 0; }
-
-		Line lineA1{ pointsA[indexA], pointsA[prevPointA] };
-		Line lineA2{ pointsA[indexA], pointsA[nextPointA] };
-		Line lineB1{ pointsB[indexB], pointsB[prevPointB] };
-		Line lineB2{ pointsB[indexB], pointsB[nextPointB] };
-
-		if(linesIntersect(lineA1, lineB1) || linesIntersect(lineA1, lineB2) ||
-		   linesIntersect(lineA2, lineB1) || linesIntersect(lineA2, lineB2))
-		{
-			// Figure out why the collision is firing from so far away.
-			// Also clean up this function with my new functionality
-			inside = true;
-		}
+		inside = rotatedRectsOverlap(a, b);
 	}
 
 	return inside;
@@ -1358,33 +1904,30 @@ bool CollisionSystem::pointInsideRect(pRectangle rect, int x, int y)
 {
 	bool inside = true;
 
-	Vector2D rectCenter{ rect->center() };
-	Vector2D point((float)x, (float)y);
-
-	// Rotate the point to normalize it around the rect
-	point = rotatePoint(point, rectCenter, rect->rotation() * -1);
+	// Put the point in the rectangle's space, centered on the rectangle
+	Vector2D point = rect->toLocal(Vector2D((float)x, (float)y));
 
-	int leftX =(int)round(rectCenter.getX() - (rect->width() / 2));
-	int topY = (int)round(rectCenter.getY() - (rect->height() / 2));
-	int rightX = (int)round(rectCenter.getX() + (rect->width() / 2));
-	int bottomY = (int)round(rectCenter.getY() + (rect->height() / 2));
+	float rightX = (float)rect->width() * 0.5f;
+	float leftX = -rightX;
+	float bottomY = (float)rect->height() * 0.5f;
+	float topY = -bottomY;
 
 	// If the x is to the left or right of the rect, it's not inside
-	if(x < leftX)
+	if(point.getX() < leftX)
 	{
 		inside = false;
 	}
-	else if (rightX < x)
+	else if (rightX < point.getX())
 	{
 		inside = false;
 	}
 	
 	// If the y is above or below the rect, it's not inside
-	if(y < topY)
+	if(point.getY() < topY)
 	{
 		inside = false;
 	}
-	else if(bottomY < y)
+	else if(bottomY < point.getY())
 	{
 		inside = false;
 	}
@@ -1480,19 +2023,41 @@ bool CollisionSystem::lineInsideRect(Line line, pRectangle rect)
 }
 
 //=============================================================================
-// Function: void sendCollisionMessage(int, int, Vector2D)
+// Function: void sendCollisionMessage(int, int, Vector2D, CollisionWorkspace&)
 // Description:
-// Sends a collision message to the message system.
+// Sends a collision message to the message system, or holds on to it if
+// the workspace is deferred.
 // Parameters:
 // int entityID - The entity that's being checked.
 // int collidingEntityID - The ID of the entity that the first entity collides with.
 // Vector2D position - The position of the collision.
+// CollisionWorkspace &workspace - Where the work is done.
 //=============================================================================
-void CollisionSystem::sendCollisionMessage(int entityID, int collidingEntityID, Vector2D position)
+void CollisionSystem::sendCollisionMessage(int entityID, int collidingEntityID, Vector2D position, CollisionWorkspace &workspace)
+{
+	if (workspace.m_deferred)
+	{
+		DeferredMessage deferred{ IMessage::COLLISION, entityID, collidingEntityID, position, position };
+
+		workspace.m_messages.push_back(deferred);
+	}
+	else
+	{
+		MessageSystem::instance()->pushMessage(new CollisionMessage(entityID, collidingEntityID, position));
+
+		recordContact(entityID, collidingEntityID, position);
+	}
+}
+
+// Only called on the main thread. Deferred collisions are recorded when
+// their workspace is flushed.
+void CollisionSystem::recordContact(int entityID, int collidingEntityID, Vector2D position)
 {
-	CollisionMessage *message = new CollisionMessage(entityID, collidingEntityID, position);
+	RecordedContact checked{ entityID, Contact{ collidingEntityID, position, true } };
+	RecordedContact hit{ collidingEntityID, Contact{ entityID, position, false } };
 
-	MessageSystem::instance()->pushMessage(message);
+	m_recordedContacts.push_back(checked);
+	m_recordedContacts.push_back(hit);
 }
 
 //=============================================================================
@@ -1508,10 +2073,7 @@ void CollisionSystem::removeCollisionComponent(int entityID)
 
 	if(mit != m_components.end())
 	{
-		int gridX = (int)round(mit->second->center().getX());
-		int gridY = (int)round(mit->second->center().getY());
-		
-		m_grid->remove(mit->first, gridX, gridY);
+		m_broadPhase->remove(mit->first);
 
 		delete mit->second;
 		mit = m_components.erase(mit);
@@ -1535,5 +2097,6 @@ void CollisionSystem::cleanup()
 		}
 	}
 
-	delete m_grid;
+	delete m_broadPhase;
+	m_broadPhase = NULL;
 }
\ No newline at end of file
@@ -7,32 +7,153 @@
 // Handles all collisions for the program.
 //==========================================================================================
 #include <map>
+#include <vector>
+#include <unordered_map>
+#include <string>
 #include "MessageSystem.h"
 #include "CollisionComponent.h"
 #include "Line.h"
-#include "Grid.h"
+#include "AABB.h"
+#include "IBroadPhase.h"
+#include "GridBroadPhase.h"
+#include "AABBTree.h"
+#include "NarrowPhase.h"
+#include "TileCollisionLayer.h"
+
+struct CollisionPair
+{
+	int m_entityA;
+	int m_entityB;
+};
+
+struct SightQuery
+{
+	int m_entityID;
+	int m_otherEntityID;
+	bool m_hasSight;
+};
+
+struct SweepHit
+{
+	// How far along the move the hit happened, from 0 to 1
+	float m_time;
+	// The side of the entity that was hit
+	Vector2D m_normal;
+	// -1 if a wall tile was hit
+	int m_entityID;
+};
+
+// A collision as one of the entities in it sees it
+struct Contact
+{
+	// The entity on the other side
+	int m_otherID;
+	Vector2D m_position;
+	// True if this entity was the one being checked, false if it was hit.
+	// The same as being the first or second entity in a collision message.
+	bool m_checked;
+};
+
+// A message held by a deferred workspace. Messages can only be made on the
+// main thread, so it's kept as plain data until the workspace is flushed.
+struct DeferredMessage
+{
+	IMessage::MessageType m_type;
+	int m_entityID;
+	// The entity that was hit, for collisions
+	int m_otherID;
+	// Where a move started, or where a collision happened
+	Vector2D m_from;
+	// Where a move ended
+	Vector2D m_to;
+};
+
+// Everything the collision system writes to while bodies are being moved.
+// Each physics worker gets its own, so several of them can move bodies at
+// the same time. A deferred workspace holds on to its messages and broad
+// phase updates until it's flushed.
+struct CollisionWorkspace
+{
+	bool m_deferred = false;
+
+	std::vector<DeferredMessage> m_messages;
+	// Bodies that moved and still need to be updated in the broad phase
+	std::vector<int> m_moved;
+	// Whether anything moved outside of its swept box
+	bool m_leftSweptBody = false;
+
+	std::vector<int> m_queryResults;
+	NarrowPhaseBatch m_narrowPhase;
+	std::vector<int> m_batchEntities;
+};
 
 class CollisionSystem
 {
 public:
-	CollisionSystem(int gridX, int gridY, int width, int height, int cellSize);
+	CollisionSystem(int gridX, int gridY, int width, int height, int cellSize,
+		BroadPhase::BroadPhaseType broadPhase = BroadPhase::GRID);
 	~CollisionSystem();
 
 	bool collisionAtPoint(int ID, int x, int y);
 	bool isColliding(int ID);
 	bool hasLineOfSight(int entityID, int otherEntityID);
+	void hasLineOfSight(std::vector<SightQuery> &queries);
 	bool collisionOnLine(int entityID, Line line);
+	bool sweepCollision(int ID, Vector2D displacement, SweepHit &hit);
+
+	// The same checks, but writing to the workspace instead of the system.
+	// During the physics update, these can be used from several threads at
+	// once as long as the bodies being moved are far enough apart.
+	bool isColliding(int ID, CollisionWorkspace &workspace);
+	bool sweepCollision(int ID, Vector2D displacement, SweepHit &hit, CollisionWorkspace &workspace);
+	void updatePosition(int ID, float movedX, float movedY, CollisionWorkspace &workspace);
+	void flushWorkspace(CollisionWorkspace &workspace);
 
 	bool circleCollision(int ID, int radius);
 	bool squareCollision(int ID, int centerX, int centerY, int width, int height);
 
+	// Spatial queries. These don't send collision messages. The results are
+	// cleared and then filled, so callers can keep one around and reuse it.
+	int queryRadius(Vector2D center, float radius, std::vector<int> &results, int ignoreID = -1);
+	int queryBounds(const AABB bounds, std::vector<int> &results, int ignoreID = -1);
+	int queryNearest(Vector2D center, float radius, int count, std::vector<int> &results, int ignoreID = -1);
+	int nearestOfType(Vector2D center, float radius, const std::string &type, int ignoreID = -1);
+
 	CollisionComponent* getCollisionComponent(int ID);
 	CollisionComponent* createCollisionComponent(int ID, Shape::ShapeType shape, float centerX, float centerY);
 
 	void updatePosition(int ID, float movedX, float movedY);
+	void updateBounds(int ID);
 
 	void processMessage(IMessage *message);
 
+	// Broad phase. Movers are registered with how far they'll travel this
+	// frame, then every candidate pair is found once for the whole frame.
+	void beginBroadPhase();
+	void addSweptBody(int ID, Vector2D displacement);
+	void buildCandidatePairs();
+	void endBroadPhase();
+
+	const std::vector<CollisionPair>& candidatePairs() { return m_pairs; }
+
+	// Contact lists. Every collision is written down for both entities,
+	// and publishContacts packs them into one array sorted by entity, with
+	// repeats of a pair combined. They can be read until the next publish.
+	void publishContacts();
+	int contacts(int entityID, const Contact *& first);
+
+	BroadPhase::BroadPhaseType broadPhaseType() { return m_broadPhase->type(); }
+
+	// Fixed point mode does the sweeps and the overlap tests for everything
+	// but turned rectangles with integer math, so they come out the same on
+	// every machine.
+	void setFixedPoint(bool fixedPoint) { m_fixedPoint = fixedPoint; }
+	bool fixedPoint() { return m_fixedPoint; }
+
+	// The dungeon's walls. They're checked by every query but never go in
+	// the broad phase.
+	TileCollisionLayer* tileLayer() { return &m_tiles; }
+
 	bool rectInsideRect(pRectangle a, pRectangle b);
 	bool lineInsideRect(Line line, pRectangle rect);
 
@@ -44,17 +165,92 @@ public:
 	bool pointInsideRect(pRectangle rect, int x, int y);
 
 private:
+	// How far the swept boxes are grown so rounding in the narrow phase
+	// can't find a collision the broad phase missed.
+	const float m_BROAD_PHASE_MARGIN = 1.0f;
+
+	// Center, top, and bottom
+	static const int m_SIGHT_LINES = 3;
+
+	class SightVisitor;
+	class SolidLineVisitor;
+
+	struct NearbyEntity
+	{
+		float m_distance;
+		int m_entityID;
+	};
+
+	struct SweptBody
+	{
+		AABB m_bounds;
+		int m_firstCandidate;
+		int m_candidateCount;
+	};
+
 	std::map<int, CollisionComponent*> m_components;
-	Grid *m_grid;
+	IBroadPhase *m_broadPhase;
+	TileCollisionLayer m_tiles;
+
+	std::unordered_map<int, SweptBody> m_sweptBodies;
+	std::vector<CollisionPair> m_pairs;
+	std::vector<int> m_candidates;
+	bool m_broadPhaseValid;
+	bool m_fixedPoint;
+
+	// Scratch space so queries don't allocate
+	std::vector<int> m_queryResults;
+	std::vector<int> m_sweepOrder;
+	std::vector<int> m_nearbyIDs;
+	std::vector<NearbyEntity> m_nearby;
+
+	// Used by everything that isn't handed a workspace
+	CollisionWorkspace m_workspace;
+
+	struct RecordedContact
+	{
+		int m_entityID;
+		Contact m_contact;
+	};
+
+	// Collisions found since the last publish, in the order they were found
+	std::vector<RecordedContact> m_recordedContacts;
+	// The contacts of the entity in slot i run from
+	// m_contacts[m_contactStart[i]] up to m_contacts[m_contactStart[i + 1]].
+	std::vector<Contact> m_contacts;
+	std::vector<int> m_contactStart;
+	std::vector<int> m_contactFill;
+	// The ID of the entity each slot's contacts belong to
+	std::vector<int> m_contactOwners;
+
+	std::vector<SightQuery> m_sightQueries;
+	std::vector<Line> m_sightLines;
+	std::vector<int> m_sightOwners;
+
+	// Entities without a collision component, like attack hitboxes, check
+	// against everything.
+	bool layersCollide(CollisionComponent *self, CollisionComponent *other)
+	{
+		return (!self || self->canCollide(other));
+	}
 
-	// Checks the specific grid cell for a collision
-	bool collisionInCell(int ID, int x, int y);
+	SweptBody* getSweptBody(int ID);
+	void findSweptPairs(int ID, const SweptBody &body);
+	void findMoverPairs();
+	bool candidateCollision(int ID, const SweptBody &body, CollisionWorkspace &workspace);
+	bool candidateCollisionOnLine(int ID, const SweptBody &body, Line line);
+	bool sightLines(int entityID, int otherEntityID, Line lines[]);
+	int batchCollision(int ID, pShape shape, Vector2D position, const int *others, int count, bool &solid, CollisionWorkspace &workspace);
+	void sortByDistance(Vector2D center, const std::vector<int> &entities);
+	void sweepAgainst(int ID, AABB moving, Vector2D displacement, const int *others, int count, SweepHit &hit);
+	void queryBroadPhase(const AABB bounds, CollisionWorkspace &workspace);
 
 	// Specific Collision Handling
 	bool handleCollision(pShape shapeA, pShape shapeB);
 	bool handleCollision(Line line, pShape shape);
 
-	void sendCollisionMessage(int entityID, int collidingEntityID, Vector2D position);
+	void sendCollisionMessage(int entityID, int collidingEntityID, Vector2D position, CollisionWorkspace &workspace);
+	void recordContact(int entityID, int collidingEntityID, Vector2D position);
 	
 	void removeCollisionComponent(int entityID);
 
@@ -1,5 +1,4 @@
 #include "DoorLogicComponent.h"
-#include "CollisionMessage.h"
 #include "Room.h"
 #include "EntitySystem.h"
 #include "RenderSystem.h"
@@ -32,52 +31,20 @@ void DoorLogicComponent::update()
 		{
 		case DOOR_CLOSED:
 		{
-			break;
-		}
-		case DOOR_LOCKED:
-		{
-			break;
-		}
-		default:
-		{
-			// Do nothing.
-			break;
-		}
-		}
-	}
-}
+			const Contact *contacts = NULL;
 
-void DoorLogicComponent::processMessage(IMessage *message)
-{
-	if(m_door)
-	{
-		switch (m_currentState)
-		{
-		case DOOR_CLOSED:
-		{
-			switch(message->type())
-			{
-			case IMessage::COLLISION:
-			{
-				CollisionMessage *collision = static_cast<CollisionMessage*>(message);
+			int contactCount = PhysicsSystem::instance()->collisionSystem()->contacts(m_entityID, contacts);
 
-				// If one of the entities is the door
-				if(collision->m_entityID == m_entityID || collision->m_collidingID == m_entityID)
+			// Open up if a player touched the door
+			for (int i = 0; i < contactCount; i++)
+			{
+				if (EntitySystem::instance()->entityType(contacts[i].m_otherID) == "Player")
 				{
-					// Check if the other is a player
-				
-					EntitySystem *sysEntity = EntitySystem::instance();
-
-					if(sysEntity->entityType(collision->m_entityID) == "Player" ||
-						sysEntity->entityType(collision->m_collidingID) == "Player")
-					{
-						openDoor();
-					}
+					openDoor();
+					break;
 				}
-
-				break;
-			}
 			}
+
 			break;
 		}
 		case DOOR_LOCKED:
@@ -86,13 +53,18 @@ void DoorLogicComponent::processMessage(IMessage *message)
 		}
 		default:
 		{
-			// By default, do nothing.
+			// Do nothing.
 			break;
 		}
 		}
 	}
 }
 
+void DoorLogicComponent::processMessage(IMessage *message)
+{
+	// Collisions are read from the contact lists in update
+}
+
 void DoorLogicComponent::setDoor(Door *door)
 {
 	if(door)
@@ -197,6 +197,11 @@ void EnemyAttackState::update()
 {
 	int currentSecond = (int)m_timer.currentSeconds();
 
+	if (m_currentAttack != -1 && !EntitySystem::instance()->entityExists(m_currentAttack))
+	{
+		m_currentAttack = -1;
+	}
+
 	if (m_currentAttack != -1)
 	{
 		int key = EntitySystem::instance()->getEntityKey(m_currentAttack);
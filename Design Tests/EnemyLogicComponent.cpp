@@ -1,5 +1,6 @@
 #include "EnemyLogicComponent.h"
 #include "EnemyTargetState.h"
+#include "EntitySystem.h"
 
 EnemyLogicComponent::EnemyLogicComponent(int entityID)
 	:LogicComponent(LOGIC_ENEMY, entityID), m_currentState(NULL), m_currentStateName(""), m_currentTarget(-1), m_behavior(EnemyState::BEHAVIOR_NORMAL)
@@ -157,6 +158,12 @@ void EnemyLogicComponent::update()
 	int it = 0;
 	bool stateEntered = false;
 
+	// Don't hand the states a target that's gone, its ID could be reused
+	if (m_currentTarget != -1 && !EntitySystem::instance()->entityExists(m_currentTarget))
+	{
+		m_currentTarget = -1;
+	}
+
 	if (m_states.size() != 0)
 	{
 		std::string name = m_statesByValue[it];
@@ -1,5 +1,4 @@
 #include "EnemyTargetState.h"
-#include "CollisionMessage.h"
 
 
 EnemyTargetState::EnemyTargetState(int entityID, float weight, bool lineOfSight, std::string targetType, int range)
@@ -45,6 +44,13 @@ void EnemyTargetState::enter()
 
 void EnemyTargetState::update()
 {
+	// The target may have been destroyed and its slot handed to something new
+	if (m_currentTarget != -1 && !EntitySystem::instance()->entityExists(m_currentTarget))
+	{
+		std::cout << "Entity: " << m_entityID << " Target destroyed!\n";
+		m_currentTarget = -1;
+	}
+
 	if(m_currentTarget != -1)
 	{
 		CollisionComponent *target = PhysicsSystem::instance()->getCollisionComponent(m_currentTarget);
@@ -66,82 +72,75 @@ void EnemyTargetState::update()
 	}
 	else
 	{
-		if (PhysicsSystem::instance()->collisionSystem()->circleCollision(m_entityID, m_range))
+		CollisionComponent *self = PhysicsSystem::instance()->getCollisionComponent(m_entityID);
+
+		if (self)
 		{
-			IMessage *message = NULL;
+			CollisionSystem *sysCollision = PhysicsSystem::instance()->collisionSystem();
 
 			bool targetFound = false;
 
-			for(int i = 0; i < MessageSystem::instance()->messageCount(); i++)
+			if (m_lineOfSight)
 			{
-				if (MessageSystem::instance()->peekMessage(message, i))
+				// Gather up everything we could target first, so line of sight
+				// can be checked for all of them at once.
+				m_targets.clear();
+
+				sysCollision->queryRadius(self->center(), (float)m_range, m_nearby, m_entityID);
+
+				for (unsigned int i = 0; i < m_nearby.size(); i++)
 				{
-					if (message->type() == IMessage::COLLISION)
+					if (EntitySystem::instance()->entityType(m_nearby[i]) == m_targetType)
 					{
-						CollisionMessage *collision = static_cast<CollisionMessage*>(message);
+						SightQuery target{ m_entityID, m_nearby[i], true };
+
+						m_targets.push_back(target);
+					}
+				}
 
-						if (EntitySystem::instance()->entityType(collision->m_collidingID) == m_targetType)
+				if (!m_targets.empty())
+				{
+					PhysicsSystem::instance()->hasLineOfSight(m_targets);
+				}
+
+				// Go after the closest one we can see
+				float closest = 0.0f;
+
+				for (unsigned int i = 0; i < m_targets.size(); i++)
+				{
+					if (m_targets[i].m_hasSight)
+					{
+						CollisionComponent *target = PhysicsSystem::instance()->getCollisionComponent(m_targets[i].m_otherEntityID);
+
+						float distance = totalDistance(self->center(), target->center());
+
+						if (!targetFound || distance < closest)
 						{
-							if (m_currentTarget == -1)
-							{
-								if (m_lineOfSight)
-								{
-									if (PhysicsSystem::instance()->hasLineOfSight(m_entityID, collision->m_collidingID))
-									{
-										m_currentTarget = collision->m_collidingID;
-										targetFound = true;
-									}
-								}
-								else
-								{
-									CollisionComponent *target = PhysicsSystem::instance()->getCollisionComponent(collision->m_collidingID);
-									CollisionComponent *self = PhysicsSystem::instance()->getCollisionComponent(m_entityID);
-
-									if (target && self)
-									{
-										if (totalDistance(target->center(), self->center()) <= m_range)
-										{
-											m_currentTarget = collision->m_collidingID;
-											targetFound = true;
-										}
-									}
-								}
-							}
-							else
-							{
-								CollisionComponent *compA = PhysicsSystem::instance()->getCollisionComponent(m_entityID);
-								CollisionComponent *compB = PhysicsSystem::instance()->getCollisionComponent(m_currentTarget);
-								CollisionComponent *compC = PhysicsSystem::instance()->getCollisionComponent(collision->m_collidingID);
-
-								if (totalDistance(compA->center(), compC->center()) < totalDistance(compA->center(), compB->center()))
-								{
-									if (m_lineOfSight)
-									{
-										if (PhysicsSystem::instance()->hasLineOfSight(m_entityID, collision->m_collidingID))
-										{
-											targetFound = true;
-											m_currentTarget = collision->m_collidingID;
-										}
-									}
-									else
-									{
-										targetFound = true;
-										m_currentTarget = collision->m_collidingID;
-									}
-								}
-							}
+							m_currentTarget = m_targets[i].m_otherEntityID;
+							closest = distance;
+							targetFound = true;
 						}
 					}
 				}
 			}
-
-			if (!targetFound)
+			else
 			{
-				if(m_currentTarget != -1)
+				int targetID = sysCollision->nearestOfType(self->center(), (float)m_range, m_targetType, m_entityID);
+
+				if (targetID != -1)
 				{
-					std::cout << "Entity: " << m_entityID << "Target lost!\n";
+					CollisionComponent *target = PhysicsSystem::instance()->getCollisionComponent(targetID);
+
+					if (totalDistance(target->center(), self->center()) <= m_range)
+					{
+						m_currentTarget = targetID;
+						targetFound = true;
+					}
 				}
+			}
 
+			if (!targetFound)
+			{
 				m_currentTarget = -1;
 			}
 			else
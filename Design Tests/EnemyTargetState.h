@@ -27,5 +27,9 @@ private:
 	int m_range;
 	int m_currentTarget;
 	bool m_lineOfSight;
+
+	// Kept around so checking targets doesn't allocate every update
+	std::vector<SightQuery> m_targets;
+	std::vector<int> m_nearby;
 };
 
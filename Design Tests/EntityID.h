@@ -0,0 +1,32 @@
+#pragma once
+//==========================================================================================
+// File Name: EntityID.h
+// Author: Brian Blackmon
+// Date Created: 9/23/2019
+// Purpose: 
+// How entity IDs are put together. The low bits are the entity's slot and
+// the bits above them are the slot's generation, which goes up every time
+// the slot is reused. Anything that keeps entities in arrays indexes them
+// by slot, and an old ID for a reused slot won't match the new entity's.
+// A slot's first entity has generation 0, so its ID is just the slot.
+//==========================================================================================
+
+const int ENTITY_SLOT_BITS = 20;
+const int ENTITY_SLOT_MASK = (1 << ENTITY_SLOT_BITS) - 1;
+// Generations wrap before reaching the sign bit, so IDs are never negative
+const int ENTITY_GENERATION_MASK = (1 << (31 - ENTITY_SLOT_BITS)) - 1;
+
+inline int entitySlot(int entityID)
+{
+	return entityID & ENTITY_SLOT_MASK;
+}
+
+inline int entityGeneration(int entityID)
+{
+	return (entityID >> ENTITY_SLOT_BITS) & ENTITY_GENERATION_MASK;
+}
+
+inline int makeEntityID(int slot, int generation)
+{
+	return ((generation & ENTITY_GENERATION_MASK) << ENTITY_SLOT_BITS) | slot;
+}
@@ -0,0 +1,67 @@
+#pragma once
+//==========================================================================================
+// File Name: EntityPrototype.h
+// Author: Brian Blackmon
+// Date Created: 9/24/2019
+// Purpose: 
+// Everything an entity's data file says about it, read once when the
+// entity system starts. Creating an entity copies from here instead of
+// searching the file for each setting.
+//==========================================================================================
+#include "IShape.h"
+#include <string>
+#include <vector>
+
+struct AnimationPrototype
+{
+	std::string m_name;
+	bool m_loop;
+	float m_speed;
+	int m_directionCount;
+
+	// -1 keeps going from where the last animation's frames ended
+	int m_startX;
+	int m_startY;
+	int m_width;
+	int m_height;
+	int m_frames;
+};
+
+struct EntityPrototype
+{
+	EntityPrototype()
+		:m_type(""), m_velocity(false), m_collision(false), m_shape(Shape::NONE),
+		m_rectWidth(0), m_rectHeight(0), m_circleRadius(0), m_solid(false),
+		m_hasCategory(false), m_category(0), m_hasMask(false), m_mask(0),
+		m_sprite(false), m_spriteTexture(""), m_hasAnchor(false), m_anchorX(0), m_anchorY(0),
+		m_animation(false), m_startingAnimation("")
+	{
+	}
+
+	std::string m_type;
+
+	// Physics
+	bool m_velocity;
+	bool m_collision;
+	Shape::ShapeType m_shape;
+	int m_rectWidth;
+	int m_rectHeight;
+	int m_circleRadius;
+	bool m_solid;
+	bool m_hasCategory;
+	unsigned int m_category;
+	bool m_hasMask;
+	unsigned int m_mask;
+
+	// Rendering
+	bool m_sprite;
+	std::string m_spriteTexture;
+	bool m_hasAnchor;
+	int m_anchorX;
+	int m_anchorY;
+	bool m_animation;
+	std::string m_startingAnimation;
+	// Where the frames are depends on the texture's width, so they're laid
+	// out when the sprite is made.
+	std::vector<AnimationPrototype> m_animations;
+};
@@ -44,51 +44,14 @@ void EntitySystem::initialize(std::string entityDataPath)
 //=============================================================================
 int EntitySystem::createEntity(entityKey key)
 {
-	if (m_initialized)
-	{
-		// Make sure we can actually load an entity.
-		if (m_settingsManager.isOpen())
-		{
-			m_settingsManager.close();
-		}
-
-		auto mit = m_entityData.find(key);
-
-		if (mit != m_entityData.end())
-		{
-			int entityID = findNextAvailableID();
-
-			m_settingsManager.open(mit->second, SettingIO::READ);
-
-			if (m_settingsManager.isOpen())
-			{
-				if (entityType(entityID) == "")
-				{
-					std::string type = m_settingsManager.loadSetting("Type");
-
-					if (type != "")
-					{
-						m_entityType.insert(std::make_pair(entityID, type));
-					}
-				}
-
-				loadComponents(entityID, Vector2D(0,0));
-
-				m_entityList[entityID] = true;
-				m_entityKeys.insert(std::make_pair(entityID, key));
-
-				return entityID;
-			}
-		}
-	}
-
-	return -1;
+	return createEntity(key, Vector2D(0, 0));
 }
 
 //=============================================================================
 // Function: int createEntity(entityKey, Vector2D)
 // Description:
-// Creates a new entity based on the information in the entity data.
+// Creates a new entity from the prototype that was read for its key when
+// the system was initialized. Nothing is read from the data file here.
 // Parameters:
 // entityKey key - The data ID of the entity to load.
 // Vector2D position - The position of the entity.
@@ -100,39 +63,30 @@ int EntitySystem::createEntity(entityKey key, Vector2D position)
 {
 	if (m_initialized)
 	{
-		// Make sure we can actually load an entity.
-		if (m_settingsManager.isOpen())
-		{
-			m_settingsManager.close();
-		}
+		auto mit = m_prototypes.find(key);
 
-		auto mit = m_entityData.find(key);
-
-		if (mit != m_entityData.end())
+		if (mit != m_prototypes.end())
 		{
-			int entityID = findNextAvailableID();
+			const EntityPrototype &prototype = mit->second;
 
-			m_settingsManager.open(mit->second, SettingIO::READ);
+			int entityID = allocateEntityID();
 
-			if (m_settingsManager.isOpen())
+			if (entityID == -1)
 			{
-				if(entityType(entityID) == "")
-				{
-					std::string type = m_settingsManager.loadSetting("Type");
+				std::cout << "Out of entity IDs!\n";
+				return -1;
+			}
 
-					if (type != "")
-					{
-						m_entityType.insert(std::make_pair(entityID, type));
-					}
-				}
+			if (prototype.m_type != "")
+			{
+				m_entityType.insert(std::make_pair(entityID, prototype.m_type));
+			}
 
-				loadComponents(entityID, position);
+			loadComponents(entityID, prototype, position);
 
-				m_entityList[entityID] = true;
-				m_entityKeys.insert(std::make_pair(entityID, key));
+			m_entityKeys.insert(std::make_pair(entityID, key));
 
-				return entityID;
-			}
+			return entityID;
 		}
 	}
 
@@ -155,13 +109,20 @@ int EntitySystem::createEntity()
 
 	if(m_initialized)
 	{
-		entityID = findNextAvailableID();
-		m_entityList[entityID] = true;
+		entityID = allocateEntityID();
 	}
 
 	return entityID;
 }
 
+bool EntitySystem::entityExists(int entityID)
+{
+	int slot = entitySlot(entityID);
+
+	return (0 <= entityID && slot < (int)m_slotsInUse.size() && m_slotsInUse[slot] &&
+		m_generations[slot] == entityGeneration(entityID));
+}
+
 //=============================================================================
 // Function: entityKey getEntityKey(int entityID)
 // Description:
@@ -199,7 +160,7 @@ std::string EntitySystem::entityType(int entityID)
 {
 	std::string type = "";
 
-	if(m_entityList[entityID] == true)
+	if(entityExists(entityID))
 	{
 		auto mit = m_entityType.find(entityID);
 
@@ -259,327 +220,394 @@ void EntitySystem::processMessage(IMessage *message)
 }
 
 //=============================================================================
-// Function: int findNextAvaliableID()
+// Function: int allocateEntityID()
 // Description:
-// Looks through the current IDs and finds the first one that hasn't
-// been initialized. If there isn't one currently available, then it adds one.
+// Takes the slot that's been free the longest, or adds a new one if none
+// are free, and builds the ID from the slot and its generation.
 // Output:
-// int - The ID number that is available.
+// int - The new entity's ID. Returns -1 if every slot the IDs have room
+// for is in use.
 //=============================================================================
-int EntitySystem::findNextAvailableID()
+int EntitySystem::allocateEntityID()
 {
-	int ID = -1;
-
-	auto mit = std::next(m_entityList.begin(), m_currentEntityID);
+	int slot = -1;
 
-	while(mit != m_entityList.end())
+	if (m_freeSlots.empty())
 	{
-		m_currentEntityID++;
-
-		if(mit->second == false)
+		// Another slot would spill into the generation bits
+		if (ENTITY_SLOT_MASK < (int)m_generations.size())
 		{
-			ID = mit->first;
-			break;
+			return -1;
 		}
 
-		mit++;
-	}
+		slot = (int)m_generations.size();
 
-	if(mit == m_entityList.end())
+		m_generations.push_back(0);
+		m_slotsInUse.push_back(true);
+	}
+	else
 	{
-		if(m_currentEntityID == 0)
-		{
-			m_entityList.insert(std::make_pair(m_currentEntityID, true));
-			ID = m_currentEntityID;
+		slot = m_freeSlots.front();
+		m_freeSlots.pop_front();
 
-			m_currentEntityID++;
-		}
-		else
-		{
-			m_entityList.insert(std::make_pair((m_currentEntityID + 1), true));
-			m_currentEntityID += 1;
-			ID = m_currentEntityID;
-		}
+		m_slotsInUse[slot] = true;
 	}
 
-	return ID;
+	return makeEntityID(slot, m_generations[slot]);
 }
 
 //=============================================================================
-// Function: void loadComponents(int, Vector2D)
+// Function: void loadComponents(int, const EntityPrototype&, Vector2D)
 // Description:
-// Loads the components for the entity based off of the entity data.
+// Loads the components for the entity based off of its prototype.
 // Parameters:
 // int entityID - The entity ID to create components for.
+// const EntityPrototype &prototype - What the entity is made of.
 // Vector2D position - The position of the entity.
 //=============================================================================
-void EntitySystem::loadComponents(int entityID, Vector2D position)
+void EntitySystem::loadComponents(int entityID, const EntityPrototype &prototype, Vector2D position)
 {
-	loadPhysicsComponents(entityID, position);
-	loadRenderComponents(entityID, position);
+	loadPhysicsComponents(entityID, prototype, position);
+	loadRenderComponents(entityID, prototype, position);
 }
 
 //=============================================================================
-// Function: void loadPhysicsComponents(int, Vector2D)
+// Function: void loadPhysicsComponents(int, const EntityPrototype&, Vector2D)
 // Description:
 // Loads all of the physics components for the entity.
 // Parameters:
 // int entityID - The entity to load components for.
+// const EntityPrototype &prototype - What the entity is made of.
 // Vector2D position - The position of the entity.
 //=============================================================================
-void EntitySystem::loadPhysicsComponents(int entityID, Vector2D position)
+void EntitySystem::loadPhysicsComponents(int entityID, const EntityPrototype &prototype, Vector2D position)
 {
-	if(m_settingsManager.isOpen())
+	PhysicsSystem *phys = PhysicsSystem::instance();
+
+	if(prototype.m_velocity)
 	{
-		PhysicsSystem *phys = PhysicsSystem::instance();
+		phys->addVelocity(entityID);
+	}
 
-		if(m_settingsManager.settingExists("VelocityComponent"))
-		{
-			VelocityComponent *vel = phys->getVelocityComponent(entityID);
-		}
+	if (prototype.m_collision)
+	{
+		CollisionComponent *collision = phys->createCollisionComponent(entityID, prototype.m_shape, (int)position.getX(), (int)position.getY());
 
-		if (m_settingsManager.settingExists("CollisionComponent"))
+		if (collision)
 		{
-			Shape::ShapeType shape = Shape::NONE;
-
-			std::string shapeSetting = "";
-
-			if(m_settingsManager.settingExists("Shape"))
+			// Setup the shape information
+			if (prototype.m_shape == Shape::RECTANGLE)
 			{
-				shapeSetting = m_settingsManager.loadSetting("Shape");
+				pRectangle rect = dynamic_cast<pRectangle>(collision->shape());
 
-				if (shapeSetting == "Rectangle")
-				{
-					shape = Shape::RECTANGLE;
-				}
-				else if(shapeSetting == "Circle")
+				if (rect)
 				{
-					shape = Shape::CIRCLE;
+					rect->setWidth(prototype.m_rectWidth);
+					rect->setHeight(prototype.m_rectHeight);
 				}
 			}
-
-			CollisionComponent *collision = phys->createCollisionComponent(entityID, shape, (int)position.getX(), (int)position.getY());
-
-			if (collision)
+			else if (prototype.m_shape == Shape::CIRCLE)
 			{
-				// Setup the shape information
-				if (shape == Shape::RECTANGLE)
-				{
-					pRectangle rect = dynamic_cast<pRectangle>(collision->shape());
-
-					if (rect)
-					{
-						int width = 0;
-						int height = 0;
-
-						std::string strWidth = m_settingsManager.loadSetting("RectWidth");
-						std::string strHeight = m_settingsManager.loadSetting("RectHeight");
-
-						if (strWidth != "") { width = stoi(strWidth); }
-						if (strHeight != "") { height = stoi(strHeight); }
-
-						rect->setWidth(width);
-						rect->setHeight(height);
-					}
-				}
-				else if (shape == Shape::CIRCLE)
-				{
-					pCircle circle = dynamic_cast<pCircle>(collision->shape());
+				pCircle circle = dynamic_cast<pCircle>(collision->shape());
 
-					int radius = 0;
+				circle->setRadius(prototype.m_circleRadius);
+			}
 
-					std::string strRadius = m_settingsManager.loadSetting("CircleRadius");
+			// The shape was made at its default size
+			phys->collisionSystem()->updateBounds(entityID);
 
-					if (strRadius != "") { radius = stoi(strRadius); }
+			if (prototype.m_solid)
+			{
+				collision->setSolid(true);
+			}
 
-					circle->setRadius(radius);
-				}
+			if (prototype.m_hasCategory)
+			{
+				collision->setCategory(prototype.m_category);
+			}
 
-				if (m_settingsManager.settingExists("Solid"))
-				{
-					if (m_settingsManager.loadSetting("Solid") == "1")
-					{
-						collision->setSolid(true);
-					}
-				}
+			if (prototype.m_hasMask)
+			{
+				collision->setMask(prototype.m_mask);
 			}
 		}
 	}
 }
 
 //=============================================================================
-// Function: void loadRenderComponents(int, Vector2D)
+// Function: void loadRenderComponents(int, const EntityPrototype&, Vector2D)
 // Description:
-// Loads all of the render components for the specified entity.
-// TODO: If there are too many components in the future, separate it into
-// individual functions.
+// Loads all of the render components for the specified entity. The
+// animation frames are laid out here, since they wrap at the edge of the
+// sprite's texture.
 // Parameters:
 // int entityID - The entity to load components for.
+// const EntityPrototype &prototype - What the entity is made of.
 // Vector2D position - The position to load the entity at.
 //=============================================================================
-void EntitySystem::loadRenderComponents(int entityID, Vector2D position)
+void EntitySystem::loadRenderComponents(int entityID, const EntityPrototype &prototype, Vector2D position)
 {
 	RenderSystem *render = RenderSystem::instance();
 
-	if(m_settingsManager.settingExists("SpriteComponent"))
+	if(prototype.m_sprite && prototype.m_spriteTexture != "")
 	{
-		std::string texturePath = m_settingsManager.loadSetting("SpriteTexture");
+		SpriteComponent *sprite = render->createSprite(entityID, prototype.m_spriteTexture, position);
 
-		if(texturePath != "")
+		if (sprite)
 		{
-			SpriteComponent *sprite = render->createSprite(entityID, texturePath, position);
-
-			if (sprite)
+			if (prototype.m_hasAnchor)
 			{
-				if (m_settingsManager.settingExists("SpriteAnchorX") &&
-					m_settingsManager.settingExists("SpriteAnchorY"))
-				{
-					int anchorX = 0;
-					int anchorY = 0;
+				Vector2D anchor((float)prototype.m_anchorX, (float)prototype.m_anchorY);
 
-					std::string strAnchorX = m_settingsManager.loadSetting("SpriteAnchorX");
-					std::string strAnchorY = m_settingsManager.loadSetting("SpriteAnchorY");
-
-					if (strAnchorX != "") { anchorX = stoi(strAnchorX); }
-					if (strAnchorY != "") { anchorY = stoi(strAnchorY); }
-
-					Vector2D anchor((float)anchorX, (float)anchorY);
+				sprite->setAnchor(anchor);
+			}
 
-					sprite->setAnchor(anchor);
-				}
+			// Now load the animations.
+			if (prototype.m_animation)
+			{
+				AnimationComponent *animation = render->createAnimationComponent(entityID);
 
-				// Now load the animations.
-				if (m_settingsManager.settingExists("AnimationComponent"))
+				if (animation)
 				{
-					AnimationComponent *animation = render->createAnimationComponent(entityID);
+					int currentX = 0;
+					int currentY = 0;
+					int totalWidth = sprite->width();
 
-					if (animation)
+					for (unsigned int i = 0; i < prototype.m_animations.size(); i++)
 					{
-						std::string s_Count = m_settingsManager.loadSetting("Animation_Count");
+						const AnimationPrototype &info = prototype.m_animations[i];
 
-						if (s_Count != "")
-						{
-							int animationCount = stoi(s_Count);
+						if (info.m_startX != -1) { currentX = info.m_startX; }
+						if (info.m_startY != -1) { currentY = info.m_startY; }
 
-							int currentX = 0;
-							int currentY = 0;
-							int totalWidth = sprite->width();
-							int totalHeight = sprite->height();
-							int currentDirection = 0;
-							int directionCount = 4;
+						animation->addAnimation(info.m_name, info.m_loop, info.m_speed, info.m_directionCount);
 
-							for (int i = 0; i < animationCount; i++)
+						for (int k = 0; k < info.m_directionCount; k++)
+						{
+							int startingX = currentX;
+							int startingY = currentY;
+
+							for (int j = 0; j < info.m_frames; j++)
 							{
-								std::string currentAnimation = "Animation_" + std::to_string(i);
-								std::string name = m_settingsManager.loadSetting(currentAnimation);
+								SDL_Rect rect{ currentX, currentY, info.m_width, info.m_height };
+								AnimationComponent::Direction dir = AnimationComponent::DIR_NONE;
 
-								if (name != "")
+								switch(k)
 								{
-									std::string s_startX = m_settingsManager.loadSetting(name + "_StartX");
-									std::string s_startY = m_settingsManager.loadSetting(name + "_StartY");
-									std::string s_width = m_settingsManager.loadSetting(name + "_Width");
-									std::string s_height = m_settingsManager.loadSetting(name + "_Height");
-									std::string s_frames = m_settingsManager.loadSetting(name + "_Frames");
-									std::string s_loop = m_settingsManager.loadSetting(name + "_Loop");
-									std::string s_speed = m_settingsManager.loadSetting(name + "_Speed");
-									std::string s_directionCount = m_settingsManager.loadSetting(name + "_DirectionCount");
-
-									if (s_width != "" && s_height != "" && s_frames != "")
-									{
-										bool loop = true;
-
-										if (s_loop == "")
-										{
-											loop = false;
-										}
-										else if (s_loop == "0")
-										{
-											loop = false;
-										}
-
-										float speed = 0.0f;
-
-										if (s_speed != "")
-										{
-											speed = stof(s_speed);
-										}
-
-										if(s_startX != "")
-										{
-											currentX = stoi(s_startX);
-										}
-
-										if(s_startY != "")
-										{
-											currentY = stoi(s_startY);
-										}
-
-										if(s_directionCount != "")
-										{
-											directionCount = std::stoi(s_directionCount);
-										}
-
-										int width = stoi(s_width);
-										int height = stoi(s_height);
-										int frames = stoi(s_frames);
-
-										animation->addAnimation(name, loop, speed, directionCount);
-
-										for (int k = 0; k < directionCount; k++)
-										{
-											int startingX = currentX;
-											int startingY = currentY; 
-
-											for (int j = 0; j < frames; j++)
-											{
-												SDL_Rect rect{ currentX, currentY, width, height };
-												AnimationComponent::Direction dir = AnimationComponent::DIR_NONE;
-
-												switch(k)
-												{
-												case 0:
-													dir = AnimationComponent::DIR_DOWN;
-													break;
-												case 1:
-													dir = AnimationComponent::DIR_RIGHT;
-													break;
-												case 2:
-													dir = AnimationComponent::DIR_UP;
-													break;
-												case 3:
-													dir = AnimationComponent::DIR_LEFT;
-													break;
-												}
-
-												animation->addFrame(name, dir, rect);
-
-												currentX += width;
-
-												if (totalWidth <= currentX)
-												{
-													currentX = 0;
-													currentY += height;
-												}
-											}
-											
-											currentX = startingX;
-											currentY = startingY + height;
-										}
-
-										if (i == 0)
-										{
-											animation->setAnimation(name);
-										}
-									}
+								case 0:
+									dir = AnimationComponent::DIR_DOWN;
+									break;
+								case 1:
+									dir = AnimationComponent::DIR_RIGHT;
+									break;
+								case 2:
+									dir = AnimationComponent::DIR_UP;
+									break;
+								case 3:
+									dir = AnimationComponent::DIR_LEFT;
+									break;
+								}
+
+								animation->addFrame(info.m_name, dir, rect);
+
+								currentX += info.m_width;
+
+								if (totalWidth <= currentX)
+								{
+									currentX = 0;
+									currentY += info.m_height;
 								}
 							}
+
+							currentX = startingX;
+							currentY = startingY + info.m_height;
 						}
 					}
+
+					if (prototype.m_startingAnimation != "")
+					{
+						animation->setAnimation(prototype.m_startingAnimation);
+					}
 				}
 			}
-			else
+		}
+		else
+		{
+			std::cout << "Error creating sprite!\n";
+		}
+	}
+}
+
+//=============================================================================
+// Function: void loadPrototype(entityKey)
+// Description:
+// Reads everything needed to make an entity out of its data file, so
+// making one later doesn't have to search the file again.
+// Parameters:
+// entityKey key - The entity key to read the prototype for.
+//=============================================================================
+void EntitySystem::loadPrototype(entityKey key)
+{
+	m_settingsManager.close();
+
+	auto mit = m_entityData.find(key);
+
+	if(mit != m_entityData.end())
+	{
+		m_settingsManager.open(mit->second, SettingIO::READ);
+
+		if (m_settingsManager.isOpen())
+		{
+			EntityPrototype prototype;
+
+			prototype.m_type = m_settingsManager.loadSetting("Type");
+
+			loadPhysicsPrototype(prototype);
+			loadRenderPrototype(prototype);
+
+			m_prototypes.insert(std::make_pair(key, prototype));
+		}
+	}
+}
+
+//=============================================================================
+// Function: void loadPhysicsPrototype(EntityPrototype&)
+// Description:
+// Reads the physics settings from the open data file.
+// Parameters:
+// EntityPrototype &prototype - Gets the settings.
+//=============================================================================
+void EntitySystem::loadPhysicsPrototype(EntityPrototype &prototype)
+{
+	prototype.m_velocity = m_settingsManager.settingExists("VelocityComponent");
+	prototype.m_collision = m_settingsManager.settingExists("CollisionComponent");
+
+	if (prototype.m_collision)
+	{
+		std::string shapeSetting = m_settingsManager.loadSetting("Shape");
+
+		if (shapeSetting == "Rectangle")
+		{
+			prototype.m_shape = Shape::RECTANGLE;
+
+			std::string strWidth = m_settingsManager.loadSetting("RectWidth");
+			std::string strHeight = m_settingsManager.loadSetting("RectHeight");
+
+			if (strWidth != "") { prototype.m_rectWidth = stoi(strWidth); }
+			if (strHeight != "") { prototype.m_rectHeight = stoi(strHeight); }
+		}
+		else if(shapeSetting == "Circle")
+		{
+			prototype.m_shape = Shape::CIRCLE;
+
+			std::string strRadius = m_settingsManager.loadSetting("CircleRadius");
+
+			if (strRadius != "") { prototype.m_circleRadius = stoi(strRadius); }
+		}
+
+		prototype.m_solid = (m_settingsManager.loadSetting("Solid") == "1");
+
+		// What the entity is, and what it's allowed to run into.
+		// EX: CollisionMask Player|Door
+		if (m_settingsManager.settingExists("CollisionCategory"))
+		{
+			prototype.m_hasCategory = true;
+			prototype.m_category = CollisionLayer::parseLayers(m_settingsManager.loadSetting("CollisionCategory"));
+		}
+
+		if (m_settingsManager.settingExists("CollisionMask"))
+		{
+			prototype.m_hasMask = true;
+			prototype.m_mask = CollisionLayer::parseLayers(m_settingsManager.loadSetting("CollisionMask"));
+		}
+	}
+}
+
+//=============================================================================
+// Function: void loadRenderPrototype(EntityPrototype&)
+// Description:
+// Reads the sprite and animation settings from the open data file.
+// Animations missing their size or frame count are skipped.
+// Parameters:
+// EntityPrototype &prototype - Gets the settings.
+//=============================================================================
+void EntitySystem::loadRenderPrototype(EntityPrototype &prototype)
+{
+	prototype.m_sprite = m_settingsManager.settingExists("SpriteComponent");
+
+	if (!prototype.m_sprite)
+	{
+		return;
+	}
+
+	prototype.m_spriteTexture = m_settingsManager.loadSetting("SpriteTexture");
+
+	if (m_settingsManager.settingExists("SpriteAnchorX") &&
+		m_settingsManager.settingExists("SpriteAnchorY"))
+	{
+		std::string strAnchorX = m_settingsManager.loadSetting("SpriteAnchorX");
+		std::string strAnchorY = m_settingsManager.loadSetting("SpriteAnchorY");
+
+		prototype.m_hasAnchor = true;
+
+		if (strAnchorX != "") { prototype.m_anchorX = stoi(strAnchorX); }
+		if (strAnchorY != "") { prototype.m_anchorY = stoi(strAnchorY); }
+	}
+
+	prototype.m_animation = m_settingsManager.settingExists("AnimationComponent");
+
+	std::string s_Count = m_settingsManager.loadSetting("Animation_Count");
+
+	if (!prototype.m_animation || s_Count == "")
+	{
+		return;
+	}
+
+	int animationCount = stoi(s_Count);
+
+	// Animations without a direction count use the last one given
+	int directionCount = 4;
+
+	for (int i = 0; i < animationCount; i++)
+	{
+		std::string name = m_settingsManager.loadSetting("Animation_" + std::to_string(i));
+
+		if (name != "")
+		{
+			std::string s_startX = m_settingsManager.loadSetting(name + "_StartX");
+			std::string s_startY = m_settingsManager.loadSetting(name + "_StartY");
+			std::string s_width = m_settingsManager.loadSetting(name + "_Width");
+			std::string s_height = m_settingsManager.loadSetting(name + "_Height");
+			std::string s_frames = m_settingsManager.loadSetting(name + "_Frames");
+			std::string s_loop = m_settingsManager.loadSetting(name + "_Loop");
+			std::string s_speed = m_settingsManager.loadSetting(name + "_Speed");
+			std::string s_directionCount = m_settingsManager.loadSetting(name + "_DirectionCount");
+
+			if (s_width != "" && s_height != "" && s_frames != "")
 			{
-				std::cout << "Error creating sprite!\n";
+				if(s_directionCount != "")
+				{
+					directionCount = std::stoi(s_directionCount);
+				}
+
+				AnimationPrototype animation;
+
+				animation.m_name = name;
+				animation.m_loop = (s_loop != "" && s_loop != "0");
+				animation.m_speed = (s_speed != "" ? stof(s_speed) : 0.0f);
+				animation.m_directionCount = directionCount;
+				animation.m_startX = (s_startX != "" ? stoi(s_startX) : -1);
+				animation.m_startY = (s_startY != "" ? stoi(s_startY) : -1);
+				animation.m_width = stoi(s_width);
+				animation.m_height = stoi(s_height);
+				animation.m_frames = stoi(s_frames);
+
+				prototype.m_animations.push_back(animation);
+
+				if (i == 0)
+				{
+					prototype.m_startingAnimation = name;
+				}
 			}
 		}
 	}
@@ -694,7 +722,8 @@ void EntitySystem::loadAttackInfo(entityKey key)
 //=============================================================================
 // Function: void loadEntityData()
 // Description:
-// Loads in all of the entity data inside the data file.
+// Loads in all of the entity data inside the data file, then reads the
+// prototype and attacks for each entity.
 //=============================================================================
 void EntitySystem::loadEntityData()
 {
@@ -718,6 +747,7 @@ void EntitySystem::loadEntityData()
 
 	while(mit != m_entityData.end())
 	{
+		loadPrototype(mit->first);
 		loadAttackInfo(mit->first);
 		mit++;
 	}
@@ -732,25 +762,21 @@ void EntitySystem::loadEntityData()
 //=============================================================================
 void EntitySystem::deleteEntity(int entityID)
 {
-	auto mit = m_entityList.find(entityID);
-
 	//std::cout << "Deleting entity: " << entityID << std::endl;
 
-	if(mit != m_entityList.end())
-	{
-		mit->second = false;
-		
-		if(mit->first < m_currentEntityID)
-		{
-			m_currentEntityID = mit->first;
-		}
-	}
-
-	if(m_entityList.find(entityID)->second != false)
+	if(!entityExists(entityID))
 	{
 		std::cout << "Failed to delete entity: " << entityID << std::endl;
+		return;
 	}
 
+	int slot = entitySlot(entityID);
+
+	// Every ID handed out for this slot so far stops matching
+	m_slotsInUse[slot] = false;
+	m_generations[slot] = (m_generations[slot] + 1) & ENTITY_GENERATION_MASK;
+	m_freeSlots.push_back(slot);
+
 	auto typeMit = m_entityType.find(entityID);
 
 	if(typeMit != m_entityType.end())
@@ -9,13 +9,17 @@
 #include "SettingIO.h"
 #include "Vector2D.h"
 #include "AttackInfo.h"
+#include "EntityPrototype.h"
+#include "IMessageHandler.h"
+#include "EntityID.h"
 #include <map>
 #include <unordered_map>
+#include <vector>
+#include <deque>
 
 typedef int entityKey;
-class IMessage;
 
-class EntitySystem
+class EntitySystem : public IMessageHandler
 {
 public:
 	~EntitySystem();
@@ -32,6 +36,10 @@ public:
 	int createEntity(entityKey key, Vector2D position);
 	int createEntity();
 
+	// False for IDs of entities that were deleted, even once their slot
+	// has been reused.
+	bool entityExists(int entityID);
+
 	entityKey getEntityKey(int entityID);
 	std::string entityType(int entityID);
 	AttackInfo* entityAttack(entityKey key);
@@ -40,27 +48,35 @@ public:
 
 private:
 	EntitySystem()
-		:m_currentEntityID(0), m_initialized(false)
+		:m_initialized(false)
 	{
 	}
 
-	int m_currentEntityID;
 	bool m_initialized;
 	SettingIO m_settingsManager;
 	std::string m_entityDataPath;
 
 	std::map<entityKey, std::string> m_entityData;
-	std::map<int, bool> m_entityList;
+	// The generation of each slot and whether an entity is in it. Deleted
+	// slots are reused oldest first, so old IDs take as long as possible to
+	// come back around.
+	std::vector<int> m_generations;
+	std::vector<bool> m_slotsInUse;
+	std::deque<int> m_freeSlots;
 	std::map<int, std::string> m_entityType;
 	std::map<int, entityKey> m_entityKeys;
 	std::map<entityKey, AttackInfo*> m_entityAttacks;
+	std::map<entityKey, EntityPrototype> m_prototypes;
 
-	int findNextAvailableID();
+	int allocateEntityID();
 
-	void loadComponents(int entityID, Vector2D position);
-	void loadPhysicsComponents(int entityID, Vector2D position);
-	void loadRenderComponents(int entityID, Vector2D position);
+	void loadComponents(int entityID, const EntityPrototype &prototype, Vector2D position);
+	void loadPhysicsComponents(int entityID, const EntityPrototype &prototype, Vector2D position);
+	void loadRenderComponents(int entityID, const EntityPrototype &prototype, Vector2D position);
 	void loadLogicComponents(int entityID);
+	void loadPrototype(entityKey key);
+	void loadPhysicsPrototype(EntityPrototype &prototype);
+	void loadRenderPrototype(EntityPrototype &prototype);
 	void loadAttackInfo(entityKey key);
 	void loadEntityData();
 
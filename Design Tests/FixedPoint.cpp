@@ -0,0 +1,314 @@
+#include "FixedPoint.h"
+#include "AABB.h"
+#include "Rectangle.h"
+#include "Circle.h"
+#include <cmath>
+#include <climits>
+#include <cstdlib>
+
+// Rounds to the closest step. Doubles hold every float times 2^16 exactly,
+// so the only rounding is the one done here.
+Fixed toFixed(float value)
+{
+	return (Fixed)floor(((double)value * FIXED_ONE) + 0.5);
+}
+
+Fixed toFixed(int value)
+{
+	return value * FIXED_ONE;
+}
+
+// Floats hold Q16.16 values exactly up to 256. Past that, the conversion
+// rounds to the closest float, which is the same on every machine.
+float toFloat(Fixed value)
+{
+	return (float)value / (float)FIXED_ONE;
+}
+
+FixedVector toFixed(Vector2D vector)
+{
+	FixedVector fixed{ toFixed(vector.getX()), toFixed(vector.getY()) };
+
+	return fixed;
+}
+
+Vector2D toFloat(FixedVector vector)
+{
+	return Vector2D(toFloat(vector.x), toFloat(vector.y));
+}
+
+// Both multiplying and dividing round towards 0, so a fraction of a move
+// never comes out longer than the move.
+Fixed fixedMultiply(Fixed a, Fixed b)
+{
+	return (Fixed)(((long long)a * b) / FIXED_ONE);
+}
+
+//=============================================================================
+// Function: Fixed fixedDivide(Fixed, Fixed)
+// Description:
+// Divides two fixed point numbers. Results too big to hold are clamped,
+// which only happens when dividing by something tiny.
+// Parameters:
+// Fixed a - The number to divide.
+// Fixed b - The number to divide by. Can't be 0.
+// Output:
+// Fixed - a divided by b.
+//=============================================================================
+Fixed fixedDivide(Fixed a, Fixed b)
+{
+	long long quotient = ((long long)a * FIXED_ONE) / b;
+
+	if (quotient < INT_MIN) { quotient = INT_MIN; }
+	if (INT_MAX < quotient) { quotient = INT_MAX; }
+
+	return (Fixed)quotient;
+}
+
+Fixed fixedAbs(Fixed value)
+{
+	return (value < 0 ? -value : value);
+}
+
+//=============================================================================
+// Function: FixedBounds fixedShapeBounds(IShape*)
+// Description:
+// Gets the smallest box that holds the whole shape. Boxes for circles and
+// rectangles that aren't turned are built from the center and size, so
+// they're exact. Turned rectangles use their float corners.
+// Parameters:
+// IShape *shape - The shape to get the box for.
+// Output:
+// FixedBounds - The shape's box.
+//=============================================================================
+FixedBounds fixedShapeBounds(Shape::IShape *shape)
+{
+	FixedBounds box{ 0, 0, 0, 0 };
+
+	if (!shape)
+	{
+		return box;
+	}
+
+	FixedVector center = toFixed(shape->center());
+
+	Fixed halfWidth = 0;
+	Fixed halfHeight = 0;
+
+	switch (shape->type())
+	{
+	case Shape::RECTANGLE:
+	{
+		Shape::Rectangle *rect = static_cast<Shape::Rectangle*>(shape);
+
+		if (rect->rotation() != 0.0f)
+		{
+			AABB bounds = rect->bounds();
+
+			FixedBounds turned{ toFixed(bounds.minX), toFixed(bounds.minY), toFixed(bounds.maxX), toFixed(bounds.maxY) };
+
+			return turned;
+		}
+
+		halfWidth = toFixed(rect->width()) / 2;
+		halfHeight = toFixed(rect->height()) / 2;
+
+		break;
+	}
+	case Shape::CIRCLE:
+	{
+		Shape::Circle *circle = static_cast<Shape::Circle*>(shape);
+
+		halfWidth = toFixed(circle->radius());
+		halfHeight = halfWidth;
+
+		break;
+	}
+	default:
+		break;
+	}
+
+	box.minX = center.x - halfWidth;
+	box.minY = center.y - halfHeight;
+	box.maxX = center.x + halfWidth;
+	box.maxY = center.y + halfHeight;
+
+	return box;
+}
+
+FixedBounds translateFixedBounds(const FixedBounds box, FixedVector offset)
+{
+	FixedBounds moved{ box.minX + offset.x, box.minY + offset.y, box.maxX + offset.x, box.maxY + offset.y };
+
+	return moved;
+}
+
+// Touching edges don't count, the same as boundsOverlap.
+bool fixedBoundsOverlap(const FixedBounds a, const FixedBounds b)
+{
+	return (a.minX < b.maxX && b.minX < a.maxX && a.minY < b.maxY && b.minY < a.maxY);
+}
+
+//=============================================================================
+// Function: bool fixedShapesOverlap(IShape*, IShape*)
+// Description:
+// Tests two shapes with integer math. Handles rectangles that aren't
+// turned and circles. Turned rectangles need trig, so they're left to the
+// float tests. Distances are checked on each axis before they're squared,
+// so the squares always fit.
+// Parameters:
+// IShape *a - The first shape.
+// IShape *b - The second shape.
+// Output:
+// bool - Returns true if the shapes overlap.
+//=============================================================================
+bool fixedShapesOverlap(Shape::IShape *a, Shape::IShape *b)
+{
+	if (!a || !b)
+	{
+		return false;
+	}
+
+	if (a->type() == Shape::RECTANGLE && b->type() == Shape::RECTANGLE)
+	{
+		return fixedBoundsOverlap(fixedShapeBounds(a), fixedShapeBounds(b));
+	}
+
+	if (a->type() == Shape::RECTANGLE)
+	{
+		Shape::IShape *swap = a;
+		a = b;
+		b = swap;
+	}
+
+	if (a->type() != Shape::CIRCLE)
+	{
+		return false;
+	}
+
+	FixedVector center = toFixed(a->center());
+	Fixed radius = toFixed(static_cast<Shape::Circle*>(a)->radius());
+
+	long long dx = 0;
+	long long dy = 0;
+	long long reach = 0;
+
+	if (b->type() == Shape::CIRCLE)
+	{
+		FixedVector other = toFixed(b->center());
+
+		dx = (long long)other.x - center.x;
+		dy = (long long)other.y - center.y;
+		reach = (long long)radius + toFixed(static_cast<Shape::Circle*>(b)->radius());
+
+		if (reach <= llabs(dx) || reach <= llabs(dy))
+		{
+			return false;
+		}
+
+		return ((dx * dx) + (dy * dy) < reach * reach);
+	}
+
+	// A circle touches a box when the closest point in the box is inside it
+	FixedBounds box = fixedShapeBounds(b);
+
+	Fixed closestX = center.x;
+	Fixed closestY = center.y;
+
+	if (closestX < box.minX) { closestX = box.minX; }
+	if (box.maxX < closestX) { closestX = box.maxX; }
+	if (closestY < box.minY) { closestY = box.minY; }
+	if (box.maxY < closestY) { closestY = box.maxY; }
+
+	dx = (long long)center.x - closestX;
+	dy = (long long)center.y - closestY;
+	reach = radius;
+
+	if (reach < llabs(dx) || reach < llabs(dy))
+	{
+		return false;
+	}
+
+	return ((dx * dx) + (dy * dy) <= reach * reach);
+}
+
+//=============================================================================
+// Function: bool sweepFixedBounds(const FixedBounds, FixedVector, const FixedBounds, Fixed&, Vector2D&)
+// Description:
+// The integer version of sweepBounds. Finds how far along the
+// displacement the moving box first touches the target box.
+// Parameters:
+// const FixedBounds moving - The box that's moving.
+// FixedVector displacement - How far the box moves.
+// const FixedBounds target - The box that's standing still.
+// Fixed &time - Gets the part of the displacement moved before touching.
+// Vector2D &normal - Gets the direction of the side that was hit.
+// Output:
+// bool - Returns true if the boxes touch before the end of the move.
+//=============================================================================
+bool sweepFixedBounds(const FixedBounds moving, FixedVector displacement, const FixedBounds target, Fixed &time, Vector2D &normal)
+{
+	Fixed enterTime = -FIXED_ONE;
+	Fixed exitTime = 2 * FIXED_ONE;
+	int enterAxis = -1;
+
+	Fixed direction[2]{ displacement.x, displacement.y };
+	Fixed movingMin[2]{ moving.minX, moving.minY };
+	Fixed movingMax[2]{ moving.maxX, moving.maxY };
+	Fixed targetMin[2]{ target.minX, target.minY };
+	Fixed targetMax[2]{ target.maxX, target.maxY };
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (direction[axis] == 0)
+		{
+			// Not moving on this axis, so they have to already line up on it
+			if (movingMax[axis] <= targetMin[axis] || targetMax[axis] <= movingMin[axis])
+			{
+				return false;
+			}
+		}
+		else
+		{
+			Fixed enter = 0;
+			Fixed exit = 0;
+
+			if (0 < direction[axis])
+			{
+				enter = fixedDivide(targetMin[axis] - movingMax[axis], direction[axis]);
+				exit = fixedDivide(targetMax[axis] - movingMin[axis], direction[axis]);
+			}
+			else
+			{
+				enter = fixedDivide(targetMax[axis] - movingMin[axis], direction[axis]);
+				exit = fixedDivide(targetMin[axis] - movingMax[axis], direction[axis]);
+			}
+
+			if (enterTime < enter)
+			{
+				enterTime = enter;
+				enterAxis = axis;
+			}
+
+			if (exit < exitTime) { exitTime = exit; }
+		}
+	}
+
+	if (enterAxis == -1 || enterTime < 0 || FIXED_ONE < enterTime || exitTime <= enterTime)
+	{
+		return false;
+	}
+
+	time = enterTime;
+
+	if (enterAxis == 0)
+	{
+		normal = Vector2D(0 < direction[0] ? -1.0f : 1.0f, 0.0f);
+	}
+	else
+	{
+		normal = Vector2D(0.0f, 0 < direction[1] ? -1.0f : 1.0f);
+	}
+
+	return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+//==========================================================================================
+// File Name: FixedPoint.h
+// Author: Brian Blackmon
+// Date Created: 9/18/2019
+// Purpose: 
+// Q16.16 fixed point numbers for the physics. Everything done with them is
+// integer math, so the same inputs give the same bits on every machine and
+// compiler. Floats go in and come out at the edges, and the conversions
+// round the same way everywhere.
+//==========================================================================================
+#include "Vector2D.h"
+#include "IShape.h"
+
+typedef int Fixed;
+
+const int FIXED_FRACTION_BITS = 16;
+const Fixed FIXED_ONE = 1 << FIXED_FRACTION_BITS;
+
+struct FixedVector
+{
+	Fixed x;
+	Fixed y;
+};
+
+struct FixedBounds
+{
+	Fixed minX;
+	Fixed minY;
+	Fixed maxX;
+	Fixed maxY;
+};
+
+Fixed toFixed(float value);
+Fixed toFixed(int value);
+float toFloat(Fixed value);
+FixedVector toFixed(Vector2D vector);
+Vector2D toFloat(FixedVector vector);
+
+Fixed fixedMultiply(Fixed a, Fixed b);
+Fixed fixedDivide(Fixed a, Fixed b);
+Fixed fixedAbs(Fixed value);
+
+FixedBounds fixedShapeBounds(Shape::IShape *shape);
+FixedBounds translateFixedBounds(const FixedBounds box, FixedVector offset);
+bool fixedBoundsOverlap(const FixedBounds a, const FixedBounds b);
+bool fixedShapesOverlap(Shape::IShape *a, Shape::IShape *b);
+bool sweepFixedBounds(const FixedBounds moving, FixedVector displacement, const FixedBounds target, Fixed &time, Vector2D &normal);
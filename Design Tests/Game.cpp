@@ -28,7 +28,11 @@ Game::Game()
 	m_initialized(false), 
 	m_currentState(GS_EXIT),
 	m_resource(NULL), 
-	m_menu(NULL)
+	m_menu(NULL),
+	m_tickLength(1.0 / 60.0),
+	m_accumulator(0.0),
+	m_previousTime(0.0),
+	m_tickCount(0)
 {
 	m_world = new World("Resources/rooms.dat");
 }
@@ -43,6 +47,11 @@ Game::~Game()
 	m_inputSys = NULL;
 	m_logicSys = NULL;
 
+	if (m_menu)
+	{
+		MessageSystem::instance()->unsubscribe(m_menu);
+	}
+
 	delete m_menu;
 	m_menu = NULL;
 
@@ -103,6 +112,31 @@ bool Game::init(std::string gamePath)
 
 				if (m_physicsSys && m_renderSys && m_messageSys && m_logicSys && m_inputSys)
 				{
+					// A replay makes the world from the seed it was recorded
+					// with, so the entities in it end up the same.
+					unsigned int seed = (unsigned int)SDL_GetTicks();
+					int tickRate = GameInitSystem::instance()->tickRate();
+
+					std::string replayPath = GameInitSystem::instance()->replayJournal();
+					std::string recordPath = GameInitSystem::instance()->recordJournal();
+
+					if (replayPath != "")
+					{
+						if (!m_messageSys->startReplay(replayPath, seed, tickRate))
+						{
+							std::cout << "Failed to open the replay journal: " << replayPath << std::endl;
+						}
+					}
+					else if (recordPath != "")
+					{
+						if (!m_messageSys->startRecording(recordPath, seed, tickRate))
+						{
+							std::cout << "Failed to open the message journal: " << recordPath << std::endl;
+						}
+					}
+
+					m_world->setSeed(seed);
+
 					while (!m_world->exists())
 					{
 						m_world->dungeon();
@@ -196,6 +230,8 @@ bool Game::init(std::string gamePath)
 					m_menu->setVisible(false);
 					m_menu->setActive(false);
 
+					subscribeSystems();
+
 					m_renderSys->setCameraTarget(player);
 					m_renderSys->camera()->setBoundingBoxSize(ResourceManager::instance()->window()->width() / 4, ResourceManager::instance()->window()->height() / 4);
 					m_renderSys->setSpriteLayer(player, RenderSystem::RENDER_FOREGROUND1);
@@ -226,8 +262,18 @@ bool Game::init(std::string gamePath)
 
 					m_initialized = true;
 					success = true;
+					setTickRate(tickRate);
+
 					m_timer.start();
+					m_previousTime = m_timer.preciseSeconds();
+					m_accumulator = 0.0;
+					m_tickCount = 0;
 					m_currentState = GS_RUNNING;
+
+					if (replayPath != "")
+					{
+						m_currentState = GS_REPLAYING;
+					}
 				}
 			}
 		}
@@ -239,47 +285,159 @@ bool Game::init(std::string gamePath)
 //=============================================================================
 // Function: void loop()
 // Description:
-// Handles the game update loop. 
+// Handles the game update loop. The logic and physics are run in fixed
+// ticks, as many as the time since the last frame covers. Whatever time is
+// left over is used to draw the sprites part of the way between the last
+// two ticks. When a journal is being replayed, it's played instead.
 //=============================================================================
 void Game::loop()
 {
 	if (m_currentState == GS_RUNNING)
 	{
-		static float startTime = m_timer.currentSeconds();
-		static float prevTime = 0;
-		static int counter = 0;
+		double currentTime = m_timer.preciseSeconds();
+		double frameTime = currentTime - m_previousTime;
 
-		clearRenderer();
+		m_previousTime = currentTime;
 
-		processMessages();
+		if (m_MAX_FRAME_TIME < frameTime)
+		{
+			frameTime = m_MAX_FRAME_TIME;
+		}
 
-		float deltaTime = m_timer.currentSeconds() - startTime;
+		m_accumulator += frameTime;
 
-		processInput();
-		processLogic(deltaTime);
-		processPhysics(deltaTime);
+		clearRenderer();
 
-		m_menu->update(deltaTime);
+		processInput();
 
-		m_world->renderRooms();
+		int ticks = 0;
 
-		prevTime = m_timer.currentSeconds() - startTime;
-		startTime = m_timer.currentSeconds();
+		while (m_tickLength <= m_accumulator && ticks < m_MAX_TICKS_PER_FRAME)
+		{
+			runTick();
 
-		updateRenderer(deltaTime);
+			m_accumulator -= m_tickLength;
+			ticks++;
+		}
 
-		if(counter % 10 == 0)
+		if (0 < ticks)
 		{
-			static float renderTime = 0;
+			// Drop whatever time couldn't be caught up on this frame
+			if (m_tickLength <= m_accumulator)
+			{
+				m_accumulator = fmod(m_accumulator, m_tickLength);
+			}
 
-			renderTime = m_timer.currentSeconds() - startTime;
-			std::cout << "Render time: " << renderTime << ", Prev time: " << prevTime << std::endl;
+			// Hand the last tick's moves to the sprites before drawing
+			m_renderSys->settleSprites();
+			processMessages();
 		}
 
-		counter++;
+		m_renderSys->setInterpolation((float)(m_accumulator / m_tickLength));
+
+		m_menu->update((float)frameTime);
+
+		m_world->renderRooms();
+
+		updateRenderer((float)frameTime);
+	}
+	else if (m_currentState == GS_REPLAYING)
+	{
+		replay();
 	}
 } 
 
+//=============================================================================
+// Function: void setTickRate(int)
+// Description:
+// Sets how many times a second the logic and physics are updated.
+// Parameters:
+// int ticksPerSecond - The number of ticks a second. Anything below 1 is
+// treated as 1.
+//=============================================================================
+void Game::setTickRate(int ticksPerSecond)
+{
+	if (ticksPerSecond < 1)
+	{
+		ticksPerSecond = 1;
+	}
+
+	m_tickLength = 1.0 / (double)ticksPerSecond;
+	m_accumulator = 0.0;
+}
+
+//=============================================================================
+// Function: void runTick()
+// Description:
+// Runs one fixed tick. The messages sent since the last tick are handled,
+// then the logic and physics are updated.
+//=============================================================================
+void Game::runTick()
+{
+	// Each batch of messages holds the moves from one tick, so the
+	// sprites have to forget the tick before it first.
+	m_renderSys->settleSprites();
+
+	m_messageSys->setTick(m_tickCount);
+	processMessages();
+
+	processLogic((float)m_tickLength);
+	processPhysics((float)m_tickLength);
+
+	m_tickCount++;
+}
+
+//=============================================================================
+// Function: void replay()
+// Description:
+// Plays back the journal from the ReplayJournal setting as fast as it can.
+// Each tick gets the input that was recorded for it and runs the same as
+// a frame with one tick would, so the logic and physics do all of the
+// work they did when it was recorded. Nothing is drawn and no input is
+// read. When the journal runs out, the time it took is printed, the
+// message stats are written, and the game exits.
+//=============================================================================
+void Game::replay()
+{
+	if (!m_messageSys->replaying())
+	{
+		m_currentState = GS_EXIT;
+		return;
+	}
+
+	double start = m_timer.preciseSeconds();
+	int ticks = 0;
+	bool moreTicks = true;
+
+	while (moreTicks)
+	{
+		moreTicks = m_messageSys->replayTick(m_tickCount);
+
+		runTick();
+
+		m_renderSys->settleSprites();
+		processMessages();
+
+		ticks++;
+	}
+
+	double elapsed = m_timer.preciseSeconds() - start;
+
+	m_messageSys->stopReplay();
+
+	std::cout << "Replayed " << ticks << " ticks in " << elapsed << " seconds ("
+		<< (elapsed * 1000.0 / ticks) << " ms a tick)" << std::endl;
+
+	std::string statsPath = GameInitSystem::instance()->replayStats();
+
+	if (!m_messageSys->writeStats(statsPath))
+	{
+		std::cout << "Failed to write the message stats: " << statsPath << std::endl;
+	}
+
+	m_currentState = GS_EXIT;
+}
+
 //=============================================================================
 // Function: void processInput()
 // Description:
@@ -334,28 +492,46 @@ void Game::processInput()
 	}
 }
 
+//=============================================================================
+// Function: void subscribeSystems()
+// Description:
+// Signs each system up for the messages it handles. When more than one
+// system wants a type, they get it in the same order they always have.
+// Logic components read collisions from the physics contact lists instead.
+//=============================================================================
+void Game::subscribeSystems()
+{
+	EntitySystem *entitySys = EntitySystem::instance();
+
+	m_messageSys->subscribe(m_physicsSys, IMessage::MOVE);
+	m_messageSys->subscribe(m_renderSys, IMessage::MOVE);
+	m_messageSys->subscribe(m_menu, IMessage::MOVE);
+
+	m_messageSys->subscribe(m_logicSys, IMessage::STATE_CHANGE);
+	m_messageSys->subscribe(m_physicsSys, IMessage::VELOCITY_INCREASE);
+	m_messageSys->subscribe(m_renderSys, IMessage::ANIMATION_CHANGE);
+
+	m_messageSys->subscribe(entitySys, IMessage::ENTITY_DESTROY);
+	m_messageSys->subscribe(m_logicSys, IMessage::ENTITY_DESTROY);
+	m_messageSys->subscribe(m_physicsSys, IMessage::ENTITY_DESTROY);
+	m_messageSys->subscribe(m_renderSys, IMessage::ENTITY_DESTROY);
+
+	m_messageSys->subscribe(m_menu, IMessage::INPUT);
+	m_messageSys->subscribe(m_menu, IMessage::CAMERA_MOVE);
+}
+
 //=============================================================================
 // Function: void processMessages()
 // Description:
-// Processes the system messages.
+// Hands the system messages to the systems subscribed to them. Only the
+// messages sent before this batch started are handled, anything sent
+// while handling them waits for the next one.
 //=============================================================================
 void Game::processMessages()
 {
 	if (m_initialized)
 	{
-		IMessage *message = NULL;
-
-		while (m_messageSys->pollMessage(message))
-		{
-			if (message)
-			{
-				EntitySystem::instance()->processMessage(message);
-				m_logicSys->processMessage(message);
-				m_physicsSys->processMessage(message);
-				m_renderSys->processMessage(message);
-				m_menu->processMessage(message);
-			}
-		}
+		m_messageSys->dispatchMessages();
 	}
 }
 
@@ -8,6 +8,7 @@
 //==========================================================================================
 #include "Timer.h"
 #include <string>
+#include <cmath>
 
 class TextComponent;
 class ResourceManager;
@@ -27,7 +28,8 @@ public:
 	{
 		GS_EXIT,
 		GS_RUNNING,
-		GS_PAUSED
+		GS_PAUSED,
+		GS_REPLAYING
 	};
 
 	static Game* instance()
@@ -45,9 +47,18 @@ public:
 
 	GameState state() { return m_currentState; }
 
+	// How many times a second the logic and physics are updated
+	void setTickRate(int ticksPerSecond);
+	int tickRate() { return (int)round(1.0 / m_tickLength); }
+
 private:
 	Game();
 
+	// Frames longer than this are cut down to it, so a stall doesn't leave
+	// more ticks to catch up on than the game can ever run.
+	const double m_MAX_FRAME_TIME = 0.25;
+	const int m_MAX_TICKS_PER_FRAME = 5;
+
 	ResourceManager *m_resource;
 	PhysicsSystem *m_physicsSys;
 	RenderSystem *m_renderSys;
@@ -60,10 +71,22 @@ private:
 
 	Timer m_timer;
 
+	// How long each tick simulates, in seconds
+	double m_tickLength;
+	// Time that's passed but hasn't been simulated yet
+	double m_accumulator;
+	double m_previousTime;
+	// Ticks run since the game started. Recorded messages are marked with
+	// the tick they were handled in.
+	int m_tickCount;
+
 	bool m_initialized;
 	GameState m_currentState;
 
+	void runTick();
+	void replay();
 	void processInput();
+	void subscribeSystems();
 	void processMessages();
 	void processLogic(float delta);
 	void processPhysics(float delta);
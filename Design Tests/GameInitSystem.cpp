@@ -34,6 +34,7 @@ bool GameInitSystem::initialize(std::string settingsFile)
 			loadPhysics();
 			loadInput();
 			loadEntity();
+			loadMessages();
 
 			m_initialized = true;
 			success = true;
@@ -108,7 +109,12 @@ void GameInitSystem::loadVideo()
 //=============================================================================
 // Function: void loadPhysics()
 // Description:
-// Loads the physics system and sets up the grid.
+// Loads the physics system and sets up the grid. BroadPhase can be set to
+// AABBTree to use the tree instead of the grid. TickRate sets how many
+// times a second the physics is updated, and defaults to 60.
+// PhysicsThreads sets how many extra threads help move bodies. Without it,
+// there's one for every core but the main one. PhysicsMath can be set to
+// Fixed to move bodies with fixed point math, so runs repeat exactly.
 //=============================================================================
 void GameInitSystem::loadPhysics()
 {
@@ -120,7 +126,32 @@ void GameInitSystem::loadPhysics()
 
 	int cellSize = std::stoi(m_settingsManager.loadSetting("GridCellSize"));
 
-	PhysicsSystem::instance()->initCollisionSystem(originX, originY, width, height, cellSize);
+	BroadPhase::BroadPhaseType broadPhase = BroadPhase::GRID;
+
+	if (m_settingsManager.settingExists("BroadPhase"))
+	{
+		if (m_settingsManager.loadSetting("BroadPhase") == "AABBTree")
+		{
+			broadPhase = BroadPhase::AABB_TREE;
+		}
+	}
+
+	if (m_settingsManager.settingExists("TickRate"))
+	{
+		m_tickRate = std::stoi(m_settingsManager.loadSetting("TickRate"));
+	}
+
+	PhysicsSystem::instance()->initCollisionSystem(originX, originY, width, height, cellSize, broadPhase);
+
+	if (m_settingsManager.settingExists("PhysicsMath"))
+	{
+		PhysicsSystem::instance()->setFixedPoint(m_settingsManager.loadSetting("PhysicsMath") == "Fixed");
+	}
+
+	if (m_settingsManager.settingExists("PhysicsThreads"))
+	{
+		PhysicsSystem::instance()->setWorkerCount(std::stoi(m_settingsManager.loadSetting("PhysicsThreads")));
+	}
 }
 
 //=============================================================================
@@ -146,4 +177,33 @@ void GameInitSystem::loadEntity()
 	{
 		entity->initialize(entityDataPath);
 	}
+}
+
+//=============================================================================
+// Function: void loadMessages()
+// Description:
+// Reads where the message journals go. MessageJournal records the session
+// so it can be replayed later. ReplayJournal plays a recorded session
+// instead of running the game, and writes the message stats to
+// ReplayStats when it's done, or next to the journal if that isn't set.
+// Nothing is recorded during a replay. The game opens the journals once
+// it knows the world's seed.
+// EX: ReplayJournal Resources/session.jnl
+//=============================================================================
+void GameInitSystem::loadMessages()
+{
+	if (m_settingsManager.settingExists("ReplayJournal"))
+	{
+		m_replayJournal = m_settingsManager.loadSetting("ReplayJournal");
+		m_replayStats = m_replayJournal + ".csv";
+
+		if (m_settingsManager.settingExists("ReplayStats"))
+		{
+			m_replayStats = m_settingsManager.loadSetting("ReplayStats");
+		}
+	}
+	else if (m_settingsManager.settingExists("MessageJournal"))
+	{
+		m_recordJournal = m_settingsManager.loadSetting("MessageJournal");
+	}
 }
\ No newline at end of file
@@ -26,19 +26,36 @@ public:
 
 	bool initialize(std::string settingsFile);
 
+	// How many times a second the game wants its logic and physics updated
+	int tickRate() { return m_tickRate; }
+
+	// The journal to record the session to. Empty if nothing is recorded.
+	std::string recordJournal() { return m_recordJournal; }
+	// The journal to play back instead of running the game. Empty if the
+	// game should run normally.
+	std::string replayJournal() { return m_replayJournal; }
+	// Where the message stats go when a replay ends
+	std::string replayStats() { return m_replayStats; }
+
 private:
 	GameInitSystem()
-		:m_initialized(false)
+		:m_initialized(false), m_tickRate(60), m_recordJournal(""), m_replayJournal(""),
+		m_replayStats("")
 	{
 	}
 
 	SettingIO m_settingsManager;
 	bool m_initialized;
+	int m_tickRate;
+	std::string m_recordJournal;
+	std::string m_replayJournal;
+	std::string m_replayStats;
 
 	void loadWindow();
 	void loadVideo();
 	void loadPhysics();
 	void loadInput();
 	void loadEntity();
+	void loadMessages();
 };
 
@@ -1,4 +1,5 @@
 #include "Grid.h"
+#include "EntityID.h"
 #include <math.h>
 #include <cassert>
 #include <iostream>
@@ -10,7 +11,7 @@ Grid::Grid(int originX, int originY, int width, int height, int cellSize)
 	float rowCount = (float)(height) / (float)(cellSize);
 	m_rowCount = (int)ceil(rowCount + 1);
 	m_columnCount = (int)ceil(columnCount + 1);
-	
+
 	assert(0 < m_rowCount && 0 < m_columnCount);
 
 	initializeGrid();
@@ -19,21 +20,9 @@ Grid::Grid(int originX, int originY, int width, int height, int cellSize)
 
 Grid::~Grid()
 {
-	// Clear the grid.
-	for(unsigned int i = 0; i < m_grid.size(); i++)
-	{
-		for(unsigned int j = 0; j < m_grid[i].size(); j++)
-		{
-			delete m_grid[i][j];
-		}
-
-		m_grid[i].empty();
-	}
-
-	m_grid.empty();
 }
 
-Node<int>* Grid::getCoordinateCell(int x, int y)
+GridCell Grid::getCoordinateCell(int x, int y)
 {
 	int workingX = x;
 	int workingY = y;
@@ -43,119 +32,153 @@ Node<int>* Grid::getCoordinateCell(int x, int y)
 
 	convertToGridCoordinates(workingX, workingY);
 
-	return m_grid[workingX][workingY];
+	return getCell(workingX, workingY);
 }
 
-Node<int>* Grid::getCell(int cellX, int cellY)
+GridCell Grid::getCell(int cellX, int cellY)
 {
 	// Make sure we're not trying to use global coordinates
-	Node<int> *cell = NULL;
+	GridCell cell;
 
 	if (0 <= cellX && cellX < m_columnCount &&
 		0 <= cellY && cellY < m_rowCount)
 	{
-		cell = m_grid[cellX][cellY];
+		Bucket &bucket = m_grid[cellX][cellY];
+
+		if (0 < bucket.m_count)
+		{
+			cell = GridCell(&m_slab[bucket.m_offset], bucket.m_count);
+		}
 	}
 
 	return cell;
 }
 
+//=============================================================================
+// Function: void add(int, int, int)
+// Description:
+// Adds the ID to the cell containing the coordinates. An ID can only live
+// in one cell, so adding an ID that's already stored moves it instead.
+// Parameters:
+// int ID - The ID to add.
+// int x - The x coordinate to add the ID at.
+// int y - The y coordinate to add the ID at.
+//=============================================================================
 void Grid::add(int ID, int x, int y)
 {
-	convertToGridCoordinates(x, y);
-
-//	std::cout << "Adding to cell: " << x << ", " << y << std::endl;
-	
-	Node<int> *node = new Node<int>(ID);
+	if (ID < 0)
+	{
+		return;
+	}
 
-	// Make sure to attach the list
-	if(m_grid[x][y])
+	if (contains(ID))
 	{
-		node->m_next = m_grid[x][y];
-		m_grid[x][y]->m_prev = node;
+		move(ID, x, y);
 	}
+	else
+	{
+		convertToGridCoordinates(x, y);
 
-	m_grid[x][y] = node;
+		insert(ID, x, y);
+	}
 }
 
-void Grid::remove(int ID, int x, int y)
+//=============================================================================
+// Function: void remove(int)
+// Description:
+// Removes the ID from the grid. The last ID in the cell is swapped into
+// the removed ID's place, so the cell doesn't need to be searched.
+// Parameters:
+// int ID - The ID to remove.
+//=============================================================================
+void Grid::remove(int ID)
 {
-	convertToGridCoordinates(x, y);
-
-	// Find and remove the ID
-	if(m_grid[x][y])
+	if (contains(ID))
 	{
-		Node<int> *node = m_grid[x][y];
+		Slot &slot = m_slots[entitySlot(ID)];
+		Bucket &bucket = m_grid[slot.m_cellX][slot.m_cellY];
+
+		int lastIndex = bucket.m_count - 1;
 
-		// If the ID is the first node
-		if(node->data() == ID)
+		if (slot.m_index != lastIndex)
 		{
-			// Make the next node the head of the list
-			if(node->m_next)
-			{
-				m_grid[x][y] = node->m_next;
-				m_grid[x][y]->m_prev = NULL;
-			}
-			else
-			{
-				m_grid[x][y] = NULL;
-			}
-
-			delete node;
-			node = NULL;
+			int lastID = m_slab[bucket.m_offset + lastIndex];
+
+			m_slab[bucket.m_offset + slot.m_index] = lastID;
+			m_slots[entitySlot(lastID)].m_index = slot.m_index;
 		}
-		else
+
+		bucket.m_count--;
+
+		// Give empty blocks back so moving entities don't pile up storage
+		if (bucket.m_count == 0)
 		{
-			// Find the node and delete it
-			while (node != NULL)
-			{
-				Node<int> *temp = node->m_next;
-
-				if (temp != NULL)
-				{
-					// Delete the node and connect the list
-					if (temp->data() == ID)
-					{
-						if (temp->m_next != NULL)
-						{
-							// Connect the list
-							node->m_next = temp->m_next;
-							temp->m_next->m_prev = node;
-						}
-						else
-						{
-							node->m_next = NULL;
-						}
-
-						delete temp;
-						temp = NULL;
-					}
-				}
-
-				node = node->m_next;
-			}
+			releaseBlock(bucket.m_offset, bucket.m_capacity);
+
+			bucket.m_offset = -1;
+			bucket.m_capacity = 0;
 		}
+
+		slot.m_index = -1;
 	}
 }
 
-void Grid::move(int ID, int oldX, int oldY, int movedX, int movedY)
+//=============================================================================
+// Function: void move(int, int, int)
+// Description:
+// Moves the ID to the cell containing the new coordinates. Nothing happens
+// if the ID stays inside of the same cell.
+// Parameters:
+// int ID - The ID to move.
+// int movedX - The x coordinate the ID moved to.
+// int movedY - The y coordinate the ID moved to.
+//=============================================================================
+void Grid::move(int ID, int movedX, int movedY)
 {
-	int workingOldX = oldX;
+	if (!contains(ID))
+	{
+		add(ID, movedX, movedY);
+		return;
+	}
+
 	int workingNewX = movedX;
-	int workingOldY = oldY;
 	int workingNewY = movedY;
 
-	convertToGridCoordinates(workingOldX, workingOldY);
 	convertToGridCoordinates(workingNewX, workingNewY);
 
+	Slot &slot = m_slots[entitySlot(ID)];
+
 	// Remove the ID from it's old location
+	if (slot.m_cellX != workingNewX ||
+		slot.m_cellY != workingNewY)
+	{
+		this->remove(ID);
+		insert(ID, workingNewX, workingNewY);
+	}
+}
 
-	if (workingOldX != workingNewX ||
-		workingOldY != workingNewY)
+//=============================================================================
+// Function: bool contains(int)
+// Description:
+// Checks to see if the ID is stored in the grid.
+// Parameters:
+// int ID - The ID to look for.
+// Output:
+// Returns true if the ID is in the grid.
+// Returns false if it isn't.
+//=============================================================================
+bool Grid::contains(int ID)
+{
+	if (ID < 0 || (int)m_slots.size() <= entitySlot(ID))
 	{
-		this->remove(ID, oldX, oldY);
-		this->add(ID, movedX, movedY);
+		return false;
 	}
+
+	Slot &slot = m_slots[entitySlot(ID)];
+
+	// An old ID for a reused slot doesn't match the one stored
+	return (slot.m_index != -1 &&
+		m_slab[m_grid[slot.m_cellX][slot.m_cellY].m_offset + slot.m_index] == ID);
 }
 
 Vector2D Grid::convertToCellCoordinates(Vector2D point)
@@ -170,11 +193,13 @@ Vector2D Grid::convertToCellCoordinates(Vector2D point)
 
 void Grid::initializeGrid()
 {
+	Bucket empty{ -1, 0, 0 };
+
 	m_grid.resize(m_columnCount);
 
 	for(unsigned int i = 0; i < m_grid.size(); i++)
 	{
-		m_grid[i].resize(m_rowCount);
+		m_grid[i].resize(m_rowCount, empty);
 	}
 }
 
@@ -183,13 +208,15 @@ void Grid::convertToGridCoordinates(int& x, int& y)
 	int workingX = x;
 	int workingY = y;
 
-	if (workingX < 0) { 
+	if (workingX < 0) {
 		workingX = 0; }
 	if (workingY < 0) { workingY = 0; }
 
 	workingX = (int)(workingX / m_cellSize);
 	workingY = (int)(workingY / m_cellSize);
 
+	Bucket empty{ -1, 0, 0 };
+
 	// Make sure the coordinates are inside the boundaries
 	if(m_columnCount <= workingX)
 	{
@@ -199,7 +226,7 @@ void Grid::convertToGridCoordinates(int& x, int& y)
 
 		for (int i = 0; i < m_columnCount; i++)
 		{
-			m_grid[i].resize(m_rowCount);
+			m_grid[i].resize(m_rowCount, empty);
 		}
 	}
 
@@ -209,10 +236,149 @@ void Grid::convertToGridCoordinates(int& x, int& y)
 
 		for (int i = 0; i < m_columnCount; i++)
 		{
-			m_grid[i].resize(m_rowCount);
+			m_grid[i].resize(m_rowCount, empty);
 		}
 	}
 
 	x = workingX;
 	y = workingY;
 }
+
+//=============================================================================
+// Function: void insert(int, int, int)
+// Description:
+// Appends the ID to the end of the cell's bucket and records its slot. An
+// old ID still stored in the slot is removed first, so it can't show up in
+// searches.
+// Parameters:
+// int ID - The ID to insert.
+// int cellX - The x position of the cell. DO NOT USE GLOBAL COORDINATES
+// int cellY - The y position of the cell. DO NOT USE GLOBAL COORDINATES
+//=============================================================================
+void Grid::insert(int ID, int cellX, int cellY)
+{
+	int slot = entitySlot(ID);
+
+	if (slot < (int)m_slots.size() && m_slots[slot].m_index != -1)
+	{
+		Slot &stale = m_slots[slot];
+
+		remove(m_slab[m_grid[stale.m_cellX][stale.m_cellY].m_offset + stale.m_index]);
+	}
+
+	Bucket &bucket = m_grid[cellX][cellY];
+
+	if (bucket.m_count == bucket.m_capacity)
+	{
+		growBucket(bucket);
+	}
+
+	m_slab[bucket.m_offset + bucket.m_count] = ID;
+
+	if ((int)m_slots.size() <= slot)
+	{
+		Slot empty{ 0, 0, -1 };
+
+		m_slots.resize(slot + 1, empty);
+	}
+
+	m_slots[slot].m_cellX = cellX;
+	m_slots[slot].m_cellY = cellY;
+	m_slots[slot].m_index = bucket.m_count;
+
+	bucket.m_count++;
+}
+
+//=============================================================================
+// Function: void growBucket(Bucket&)
+// Description:
+// Moves the bucket into a block twice its current size.
+// Parameters:
+// Bucket &bucket - The bucket to grow.
+//=============================================================================
+void Grid::growBucket(Bucket &bucket)
+{
+	int capacity = m_MIN_BUCKET_SIZE;
+
+	if (0 < bucket.m_capacity)
+	{
+		capacity = bucket.m_capacity * 2;
+	}
+
+	int offset = allocateBlock(capacity);
+
+	for (int i = 0; i < bucket.m_count; i++)
+	{
+		m_slab[offset + i] = m_slab[bucket.m_offset + i];
+	}
+
+	if (0 < bucket.m_capacity)
+	{
+		releaseBlock(bucket.m_offset, bucket.m_capacity);
+	}
+
+	bucket.m_offset = offset;
+	bucket.m_capacity = capacity;
+}
+
+//=============================================================================
+// Function: int allocateBlock(int)
+// Description:
+// Gets a block from the free list, or grows the slab if there isn't one.
+// Parameters:
+// int capacity - The size of the block. Must be a bucket size.
+// Output:
+// int - The offset of the block inside of the slab.
+//=============================================================================
+int Grid::allocateBlock(int capacity)
+{
+	int offset = -1;
+	int sizeIndex = sizeClass(capacity);
+
+	if (sizeIndex < (int)m_freeBlocks.size() && !m_freeBlocks[sizeIndex].empty())
+	{
+		offset = m_freeBlocks[sizeIndex].back();
+		m_freeBlocks[sizeIndex].pop_back();
+	}
+	else
+	{
+		offset = (int)m_slab.size();
+		m_slab.resize(m_slab.size() + capacity, -1);
+	}
+
+	return offset;
+}
+
+//=============================================================================
+// Function: void releaseBlock(int, int)
+// Description:
+// Puts the block onto the free list so another cell can reuse it.
+// Parameters:
+// int offset - The offset of the block inside of the slab.
+// int capacity - The size of the block.
+//=============================================================================
+void Grid::releaseBlock(int offset, int capacity)
+{
+	int sizeIndex = sizeClass(capacity);
+
+	if ((int)m_freeBlocks.size() <= sizeIndex)
+	{
+		m_freeBlocks.resize(sizeIndex + 1);
+	}
+
+	m_freeBlocks[sizeIndex].push_back(offset);
+}
+
+int Grid::sizeClass(int capacity)
+{
+	int sizeIndex = 0;
+	int size = m_MIN_BUCKET_SIZE;
+
+	while (size < capacity)
+	{
+		size *= 2;
+		sizeIndex++;
+	}
+
+	return sizeIndex;
+}
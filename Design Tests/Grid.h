@@ -5,10 +5,44 @@
 // Date Created: 3/28/2019
 // Purpose: 
 // Stores a collection of objects in a grid.
+// Each cell owns a contiguous bucket of IDs that's carved out of one shared
+// slab. Buckets grow by doubling and old blocks go back on a free list, so
+// adding, moving, and removing IDs doesn't touch the heap in the common case.
 //==========================================================================================
 #include <vector>
+#include <cstddef>
 #include "Vector2D.h"
-#include "Node.h"
+
+//==========================================================================================
+// GridCell
+// A read only view of the IDs inside a single grid cell. The view is only
+// valid until the grid is changed again.
+//==========================================================================================
+class GridCell
+{
+public:
+	GridCell()
+		:m_data(NULL), m_count(0)
+	{
+	}
+
+	GridCell(const int *data, int count)
+		:m_data(data), m_count(count)
+	{
+	}
+
+	int count() const { return m_count; }
+	bool empty() const { return m_count == 0; }
+
+	int operator[](int index) const { return m_data[index]; }
+
+	const int* begin() const { return m_data; }
+	const int* end() const { return m_data + m_count; }
+
+private:
+	const int *m_data;
+	int m_count;
+};
 
 class Grid
 {
@@ -17,13 +51,15 @@ public:
 	~Grid();
 
 	// Gets the cell the coordinates are in
-	Node<int>* getCoordinateCell(int x, int y);
+	GridCell getCoordinateCell(int x, int y);
 	// Gets the specific cell. DO NOT USE GLOBAL COORDINATES
-	Node<int>* getCell(int cellX, int cellY);
+	GridCell getCell(int cellX, int cellY);
 
 	void add(int ID, int x, int y);
-	void remove(int ID, int x, int y);
-	void move(int ID, int oldX, int oldY, int movedX, int movedY);
+	void remove(int ID);
+	void move(int ID, int movedX, int movedY);
+
+	bool contains(int ID);
 
 	Vector2D convertToCellCoordinates(Vector2D point);
 
@@ -32,15 +68,46 @@ public:
 	int cellSize() { return m_cellSize; }
 
 private:
+	// The smallest block a cell can own. Every bigger block is
+	// a power of two multiple of this.
+	const int m_MIN_BUCKET_SIZE = 4;
+
+	struct Bucket
+	{
+		int m_offset;
+		int m_count;
+		int m_capacity;
+	};
+
+	struct Slot
+	{
+		int m_cellX;
+		int m_cellY;
+		int m_index;
+	};
+
 	int m_originX;
 	int m_originY;
 	int m_cellSize;
 	int m_rowCount;
 	int m_columnCount;
 
-	std::vector< std::vector< Node<int>* > > m_grid;
+	std::vector< std::vector<Bucket> > m_grid;
+
+	// Backing storage for every bucket
+	std::vector<int> m_slab;
+	// Released block offsets, indexed by size class
+	std::vector< std::vector<int> > m_freeBlocks;
+	// Where each ID currently lives, indexed by its entity slot
+	std::vector<Slot> m_slots;
 
 	void initializeGrid();
 	void convertToGridCoordinates(int& x, int& y);
-};
 
+	void insert(int ID, int cellX, int cellY);
+	void growBucket(Bucket &bucket);
+
+	int allocateBlock(int capacity);
+	void releaseBlock(int offset, int capacity);
+	int sizeClass(int capacity);
+};
@@ -0,0 +1,352 @@
+#include "GridBroadPhase.h"
+#include "EntityID.h"
+#include <cmath>
+
+GridBroadPhase::GridBroadPhase(int originX, int originY, int width, int height, int cellSize)
+	:m_grid(NULL), m_maxExtent(0.0f), m_queryMark(0)
+{
+	m_grid = new Grid(originX, originY, width, height, cellSize);
+}
+
+GridBroadPhase::~GridBroadPhase()
+{
+	delete m_grid;
+	m_grid = NULL;
+}
+
+//=============================================================================
+// Function: void add(int, const AABB)
+// Description:
+// Adds the entity to the cell under the center of its box.
+// Parameters:
+// int ID - The entity to add.
+// const AABB bounds - The entity's box.
+//=============================================================================
+void GridBroadPhase::add(int ID, const AABB bounds)
+{
+	if (0 <= ID)
+	{
+		storeBounds(ID, bounds);
+
+		int centerX = (int)round((bounds.minX + bounds.maxX) * 0.5f);
+		int centerY = (int)round((bounds.minY + bounds.maxY) * 0.5f);
+
+		m_grid->add(ID, centerX, centerY);
+	}
+}
+
+//=============================================================================
+// Function: void remove(int)
+// Description:
+// Removes the entity from the grid.
+// Parameters:
+// int ID - The entity to remove.
+//=============================================================================
+void GridBroadPhase::remove(int ID)
+{
+	m_grid->remove(ID);
+}
+
+//=============================================================================
+// Function: void update(int, const AABB)
+// Description:
+// Stores the entity's new box and moves it to a new cell if its center
+// left the old one.
+// Parameters:
+// int ID - The entity that changed.
+// const AABB bounds - The entity's new box.
+//=============================================================================
+void GridBroadPhase::update(int ID, const AABB bounds)
+{
+	if (0 <= ID)
+	{
+		storeBounds(ID, bounds);
+
+		int centerX = (int)round((bounds.minX + bounds.maxX) * 0.5f);
+		int centerY = (int)round((bounds.minY + bounds.maxY) * 0.5f);
+
+		m_grid->move(ID, centerX, centerY);
+	}
+}
+
+bool GridBroadPhase::contains(int ID)
+{
+	return m_grid->contains(ID);
+}
+
+//=============================================================================
+// Function: void query(const AABB, std::vector<int>&)
+// Description:
+// Walks every cell that could hold the center of a box touching the bounds
+// and adds the entities whose boxes actually overlap.
+// Parameters:
+// const AABB bounds - The area to look in.
+// std::vector<int> &results - Where the overlapping entities are added.
+//=============================================================================
+void GridBroadPhase::query(const AABB bounds, std::vector<int> &results)
+{
+	AABB search = expandBounds(bounds, m_maxExtent);
+
+	int startingX = clampCell(search.minX, m_grid->columnCount());
+	int startingY = clampCell(search.minY, m_grid->rowCount());
+	int endingX = clampCell(search.maxX, m_grid->columnCount());
+	int endingY = clampCell(search.maxY, m_grid->rowCount());
+
+	for (int x = startingX; x <= endingX; x++)
+	{
+		for (int y = startingY; y <= endingY; y++)
+		{
+			GridCell cell = m_grid->getCell(x, y);
+
+			for (int k = 0; k < cell.count(); k++)
+			{
+				if (boundsOverlap(bounds, m_bounds[entitySlot(cell[k])]))
+				{
+					results.push_back(cell[k]);
+				}
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: void queryLines(const Line[], int, ILineVisitor&)
+// Description:
+// Steps along each line one cell at a time, only looking in the cells the
+// line actually crosses plus enough of a border to catch boxes that hang
+// over from the cells next to them. Cells the lines share are only looked
+// in once, and everything in them is checked against all of the lines.
+// Parameters:
+// const Line lines[] - The lines to check. No more than MAX_LINES.
+// int lineCount - How many lines there are.
+// ILineVisitor &visitor - Gets each entity the lines pass through.
+//=============================================================================
+void GridBroadPhase::queryLines(const Line lines[], int lineCount, ILineVisitor &visitor)
+{
+	if (lineCount <= 0)
+	{
+		return;
+	}
+
+	if (BroadPhase::MAX_LINES < lineCount)
+	{
+		lineCount = BroadPhase::MAX_LINES;
+	}
+
+	unsigned int allLines = (lineCount == BroadPhase::MAX_LINES ? 0xFFFFFFFFu : ((1u << lineCount) - 1));
+
+	int cellCount = m_grid->columnCount() * m_grid->rowCount();
+
+	if ((int)m_cellMarks.size() != cellCount)
+	{
+		m_cellMarks.assign(cellCount, m_queryMark);
+	}
+
+	m_queryMark++;
+
+	// How many cells out a box can reach past the cell its center is in
+	int reach = (int)ceil(m_maxExtent / (float)m_grid->cellSize());
+
+	for (int i = 0; i < lineCount; i++)
+	{
+		if (!traverseLine(lines[i], lines, allLines, reach, visitor))
+		{
+			return;
+		}
+	}
+}
+
+void GridBroadPhase::storeBounds(int ID, const AABB bounds)
+{
+	int slot = entitySlot(ID);
+
+	if ((int)m_bounds.size() <= slot)
+	{
+		AABB empty{ 0.0f, 0.0f, 0.0f, 0.0f };
+
+		m_bounds.resize(slot + 1, empty);
+	}
+
+	m_bounds[slot] = bounds;
+
+	float extentX = (bounds.maxX - bounds.minX) * 0.5f;
+	float extentY = (bounds.maxY - bounds.minY) * 0.5f;
+
+	if (m_maxExtent < extentX) { m_maxExtent = extentX; }
+	if (m_maxExtent < extentY) { m_maxExtent = extentY; }
+}
+
+// Converts a coordinate to a cell index that's inside of the grid.
+// The grid grows when it's handed coordinates past its edge, so queries
+// can't go through it.
+int GridBroadPhase::clampCell(float coordinate, int cellCount)
+{
+	int cell = 0;
+
+	if (0 < coordinate)
+	{
+		cell = (int)(coordinate / (float)m_grid->cellSize());
+	}
+
+	if (cellCount <= cell)
+	{
+		cell = cellCount - 1;
+	}
+
+	return cell;
+}
+
+//=============================================================================
+// Function: bool traverseLine(const Line, const Line[], unsigned int, int, ILineVisitor&)
+// Description:
+// Walks the cells the line crosses in order. At each step the line moves
+// into whichever neighbor it reaches first, the x one or the y one.
+// Parameters:
+// const Line line - The line to walk.
+// const Line lines[] - Every line in the query.
+// unsigned int allLines - A bit for each line in the query.
+// int reach - How many cells around each crossed cell to look in.
+// ILineVisitor &visitor - Gets each entity the lines pass through.
+// Output:
+// bool - Returns false if the visitor stopped the query.
+//=============================================================================
+bool GridBroadPhase::traverseLine(const Line line, const Line lines[], unsigned int allLines, int reach, ILineVisitor &visitor)
+{
+	float cellSize = (float)m_grid->cellSize();
+
+	float startX = line.start.getX();
+	float startY = line.start.getY();
+	float directionX = line.end.getX() - startX;
+	float directionY = line.end.getY() - startY;
+
+	int cellX = clampCell(startX, m_grid->columnCount());
+	int cellY = clampCell(startY, m_grid->rowCount());
+	int endCellX = clampCell(line.end.getX(), m_grid->columnCount());
+	int endCellY = clampCell(line.end.getY(), m_grid->rowCount());
+
+	int stepX = (0.0f < directionX ? 1 : -1);
+	int stepY = (0.0f < directionY ? 1 : -1);
+
+	// How far along the line the next x and y cell borders are, and how
+	// far along the line one whole cell is.
+	float nextX = 2.0f;
+	float nextY = 2.0f;
+	float deltaX = 2.0f;
+	float deltaY = 2.0f;
+
+	if (directionX != 0.0f)
+	{
+		float border = (float)(cellX + (0 < stepX ? 1 : 0)) * cellSize;
+
+		nextX = (border - startX) / directionX;
+		deltaX = cellSize / fabs(directionX);
+	}
+
+	if (directionY != 0.0f)
+	{
+		float border = (float)(cellY + (0 < stepY ? 1 : 0)) * cellSize;
+
+		nextY = (border - startY) / directionY;
+		deltaY = cellSize / fabs(directionY);
+	}
+
+	// A line can't cross more cells than this, even clamped to the edge
+	int steps = m_grid->columnCount() + m_grid->rowCount();
+
+	for (int i = 0; i <= steps; i++)
+	{
+		if (!visitCells(cellX, cellY, reach, lines, allLines, visitor))
+		{
+			return false;
+		}
+
+		if ((cellX == endCellX && cellY == endCellY) || (1.0f < nextX && 1.0f < nextY))
+		{
+			break;
+		}
+
+		// Anything past the edge of the grid is stored in the edge cells,
+		// so a line that walks off an edge stays in the edge cells.
+		if (nextX < nextY)
+		{
+			if (0 <= cellX + stepX && cellX + stepX < m_grid->columnCount())
+			{
+				cellX += stepX;
+				nextX += deltaX;
+			}
+			else
+			{
+				nextX = 2.0f;
+			}
+		}
+		else
+		{
+			if (0 <= cellY + stepY && cellY + stepY < m_grid->rowCount())
+			{
+				cellY += stepY;
+				nextY += deltaY;
+			}
+			else
+			{
+				nextY = 2.0f;
+			}
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: bool visitCells(int, int, int, const Line[], unsigned int, ILineVisitor&)
+// Description:
+// Looks in the cell and every cell within reach of it that hasn't been
+// looked in yet, and visits the entities that any of the lines pass through.
+// Parameters:
+// int cellX - The x of the crossed cell.
+// int cellY - The y of the crossed cell.
+// int reach - How many cells around the crossed cell to look in.
+// const Line lines[] - Every line in the query.
+// unsigned int allLines - A bit for each line in the query.
+// ILineVisitor &visitor - Gets each entity the lines pass through.
+// Output:
+// bool - Returns false if the visitor stopped the query.
+//=============================================================================
+bool GridBroadPhase::visitCells(int cellX, int cellY, int reach, const Line lines[], unsigned int allLines, ILineVisitor &visitor)
+{
+	int rowCount = m_grid->rowCount();
+	int columnCount = m_grid->columnCount();
+
+	for (int x = cellX - reach; x <= cellX + reach; x++)
+	{
+		for (int y = cellY - reach; y <= cellY + reach; y++)
+		{
+			if (0 <= x && x < columnCount && 0 <= y && y < rowCount &&
+				m_cellMarks[(x * rowCount) + y] != m_queryMark)
+			{
+				m_cellMarks[(x * rowCount) + y] = m_queryMark;
+
+				GridCell cell = m_grid->getCell(x, y);
+
+				for (int k = 0; k < cell.count(); k++)
+				{
+					unsigned int lineMask = 0;
+
+					for (int i = 0; i < BroadPhase::MAX_LINES && (allLines >> i) != 0; i++)
+					{
+						if (lineOverlapsBounds(lines[i], m_bounds[entitySlot(cell[k])]))
+						{
+							lineMask |= (1u << i);
+						}
+					}
+
+					if (lineMask != 0 && !visitor.visit(cell[k], lineMask))
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
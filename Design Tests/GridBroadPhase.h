@@ -0,0 +1,53 @@
+#pragma once
+//==========================================================================================
+// File Name: GridBroadPhase.h
+// Author: Brian Blackmon
+// Date Created: 9/4/2019
+// Purpose: 
+// A broad phase backed by the uniform grid. Entities are stored in the cell
+// under their center, so a query has to look as far out as the biggest box
+// that's ever been added. Works best when everything is close to the same
+// size as the cells.
+//==========================================================================================
+#include "IBroadPhase.h"
+#include "Grid.h"
+
+class GridBroadPhase : public IBroadPhase
+{
+public:
+	GridBroadPhase(int originX, int originY, int width, int height, int cellSize);
+	~GridBroadPhase();
+
+	BroadPhase::BroadPhaseType type() { return BroadPhase::GRID; }
+
+	void add(int ID, const AABB bounds);
+	void remove(int ID);
+	void update(int ID, const AABB bounds);
+
+	bool contains(int ID);
+
+	void query(const AABB bounds, std::vector<int> &results);
+	void queryLines(const Line lines[], int lineCount, ILineVisitor &visitor);
+
+	Grid* grid() { return m_grid; }
+
+private:
+	Grid *m_grid;
+
+	// The box of every stored entity, indexed by its slot
+	std::vector<AABB> m_bounds;
+
+	// Half the width or height of the biggest box added so far
+	float m_maxExtent;
+
+	// Marks the cells a line query has already looked in. A cell is
+	// visited when its mark matches the current query's.
+	std::vector<int> m_cellMarks;
+	int m_queryMark;
+
+	void storeBounds(int ID, const AABB bounds);
+	int clampCell(float coordinate, int cellCount);
+
+	bool traverseLine(const Line line, const Line lines[], unsigned int allLines, int reach, ILineVisitor &visitor);
+	bool visitCells(int cellX, int cellY, int reach, const Line lines[], unsigned int allLines, ILineVisitor &visitor);
+};
@@ -0,0 +1,59 @@
+#pragma once
+//==========================================================================================
+// File Name: IBroadPhase.h
+// Author: Brian Blackmon
+// Date Created: 9/4/2019
+// Purpose: 
+// The interface for the collision broad phase. A broad phase keeps track of
+// where every entity's box is and quickly finds the entities that could be
+// touching an area, so the exact shape checks only run on those.
+//==========================================================================================
+#include <vector>
+#include "AABB.h"
+
+namespace BroadPhase
+{
+	enum BroadPhaseType
+	{
+		GRID,
+		AABB_TREE
+	};
+
+	// The most lines one line query can carry. Each line gets a bit.
+	const int MAX_LINES = 32;
+}
+
+class ILineVisitor
+{
+public:
+	virtual ~ILineVisitor() {}
+
+	// Called for each entity a query's lines pass through. Bit i of the
+	// mask is set if line i passes through the entity's box. Return false
+	// to stop the query early.
+	virtual bool visit(int ID, unsigned int lineMask) = 0;
+};
+
+class IBroadPhase
+{
+public:
+	virtual ~IBroadPhase() {}
+
+	virtual BroadPhase::BroadPhaseType type() = 0;
+
+	virtual void add(int ID, const AABB bounds) = 0;
+	virtual void remove(int ID) = 0;
+	// Call whenever the entity moves or changes size.
+	virtual void update(int ID, const AABB bounds) = 0;
+
+	virtual bool contains(int ID) = 0;
+
+	// Adds every entity whose box overlaps the bounds to the results.
+	// The results aren't cleared first.
+	virtual void query(const AABB bounds, std::vector<int> &results) = 0;
+
+	// Hands every entity whose box one of the lines passes through to the
+	// visitor. Each entity is only visited once, no matter how many of the
+	// lines it's on.
+	virtual void queryLines(const Line lines[], int lineCount, ILineVisitor &visitor) = 0;
+};
@@ -6,6 +6,8 @@
 // Purpose: 
 // The abstract base class for messages. 
 //==========================================================================================
+#include <cstddef>
+
 class IMessage
 {
 public:
@@ -27,6 +29,12 @@ public:
 	{
 	}
 	virtual ~IMessage() {}
+
+	// Messages are made in the message system's arenas instead of on their
+	// own. Other threads get arenas of their own, so push a message from the
+	// thread that made it.
+	static void* operator new(size_t size);
+	static void operator delete(void *memory);
 	
 	MessageType type() { return m_type; }
 
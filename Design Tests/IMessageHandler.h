@@ -0,0 +1,29 @@
+#pragma once
+//==========================================================================================
+// File Name: IMessageHandler.h
+// Author: Brian Blackmon
+// Date Created: 9/20/2019
+// Purpose: 
+// The abstract base class for anything that subscribes to messages. The
+// message system hands each handler only the types it subscribed to, a
+// whole frame of one type at a time.
+//==========================================================================================
+#include "IMessage.h"
+
+class IMessageHandler
+{
+public:
+	virtual ~IMessageHandler() {}
+
+	virtual void processMessage(IMessage *message) = 0;
+
+	// Gets every message of one type from a frame, oldest first. Override it
+	// to handle the batch together instead of one message at a time.
+	virtual void processMessages(IMessage *const *messages, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			processMessage(messages[i]);
+		}
+	}
+};
@@ -21,12 +21,12 @@ namespace Shape
 	{
 	public:
 		IShape()
-			:m_center(0, 0), m_rotation(0.0)
+			:m_center(0, 0), m_rotation(0.0), m_dirty(true)
 		{
 		}
 
 		IShape(float centerX, float centerY)
-			:m_center(centerX, centerY), m_rotation(0.0)
+			:m_center(centerX, centerY), m_rotation(0.0), m_dirty(true)
 		{
 		}
 
@@ -39,11 +39,12 @@ namespace Shape
 		{ 
 			m_center.setX(x);
 			m_center.setY(y);
+			m_dirty = true;
 		}
 
-		virtual void setCenterX(float centerX) { m_center.setX(centerX); }
-		virtual void setCenterY(float centerY) { m_center.setY(centerY); }
-		void setRotation(float rotation) { m_rotation = rotation; }
+		virtual void setCenterX(float centerX) { m_center.setX(centerX); m_dirty = true; }
+		virtual void setCenterY(float centerY) { m_center.setY(centerY); m_dirty = true; }
+		void setRotation(float rotation) { m_rotation = rotation; m_dirty = true; }
 
 		virtual Vector2D center() const { return m_center; }
 		float rotation() const { return m_rotation; }
@@ -51,5 +52,7 @@ namespace Shape
 	protected:
 		Vector2D m_center;
 		float m_rotation;
+		// Set when the shape moves or turns so cached geometry gets rebuilt
+		bool m_dirty;
 	};
 }
\ No newline at end of file
@@ -7,10 +7,10 @@
 // Holds the information for creating and modifying Logic Components.
 //==========================================================================================
 #include "LogicComponent.h"
-#include "IMessage.h"
+#include "IMessageHandler.h"
 #include <map>
 
-class LogicSystem
+class LogicSystem : public IMessageHandler
 {
 public:
 	static LogicSystem* instance()
@@ -0,0 +1,65 @@
+#include "MessageArena.h"
+
+MessageArena::MessageArena()
+	:m_currentBlock(-1), m_used(0), m_liveCount(0)
+{
+}
+
+MessageArena::~MessageArena()
+{
+	for (unsigned int i = 0; i < m_blocks.size(); i++)
+	{
+		delete[] m_blocks[i].m_memory;
+	}
+}
+
+//=============================================================================
+// Function: void* allocate(size_t)
+// Description:
+// Takes the next piece of the current block, moving on to the next block
+// when it's full. Messages bigger than a block get a block of their own.
+// Parameters:
+// size_t size - How many bytes are needed.
+// Output:
+// void* - The memory, lined up for anything a message could hold.
+//=============================================================================
+void* MessageArena::allocate(size_t size)
+{
+	size = (size + m_ALIGNMENT - 1) & ~(m_ALIGNMENT - 1);
+
+	while (m_currentBlock < 0 || m_blocks[m_currentBlock].m_size < m_used + size)
+	{
+		m_currentBlock++;
+		m_used = 0;
+
+		if (m_currentBlock == (int)m_blocks.size())
+		{
+			Block block;
+
+			block.m_size = (m_BLOCK_SIZE < size ? size : m_BLOCK_SIZE);
+			block.m_memory = new char[block.m_size];
+
+			m_blocks.push_back(block);
+		}
+	}
+
+	void *memory = m_blocks[m_currentBlock].m_memory + m_used;
+
+	m_used += size;
+	m_liveCount++;
+
+	return memory;
+}
+
+bool MessageArena::reset()
+{
+	if (0 < m_liveCount)
+	{
+		return false;
+	}
+
+	m_currentBlock = -1;
+	m_used = 0;
+
+	return true;
+}
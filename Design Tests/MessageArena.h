@@ -0,0 +1,47 @@
+#pragma once
+//==========================================================================================
+// File Name: MessageArena.h
+// Author: Brian Blackmon
+// Date Created: 9/19/2019
+// Purpose: 
+// Memory for messages. Allocating just bumps a pointer through big blocks,
+// and everything is given back at once when the arena is reset. The blocks
+// are kept, so after the first few frames messages don't touch the heap.
+//==========================================================================================
+#include <vector>
+#include <cstddef>
+
+class MessageArena
+{
+public:
+	MessageArena();
+	~MessageArena();
+
+	void* allocate(size_t size);
+
+	// Frees the blocks' space for reuse. Messages still in the arena stop
+	// it from being reset, so nothing alive gets written over.
+	bool reset();
+
+	// Counts a message that was made in the arena as destroyed
+	void release() { m_liveCount--; }
+
+	int liveCount() { return m_liveCount; }
+
+private:
+	static const size_t m_BLOCK_SIZE = 64 * 1024;
+	static const size_t m_ALIGNMENT = 16;
+
+	struct Block
+	{
+		char *m_memory;
+		size_t m_size;
+	};
+
+	std::vector<Block> m_blocks;
+	// The block being bumped through and how far into it we are
+	int m_currentBlock;
+	size_t m_used;
+
+	int m_liveCount;
+};
@@ -0,0 +1,491 @@
+#include "MessageJournal.h"
+#include "MoveMessage.h"
+#include "CollisionMessage.h"
+#include "StateChangeMessage.h"
+#include "VelocityIncreaseMessage.h"
+#include "AnimationChangeMessage.h"
+#include "EntityDestroyMessage.h"
+#include "InputMessage.h"
+#include "CameraMoveMessage.h"
+#include <cstring>
+
+// Marks the start of a journal file
+static const char JOURNAL_TAG[4] = { 'M', 'J', 'N', 'L' };
+
+MessageJournal::MessageJournal()
+	:m_writing(false), m_seed(0), m_tickRate(0), m_readOffset(0)
+{
+}
+
+MessageJournal::~MessageJournal()
+{
+	close();
+}
+
+//=============================================================================
+// Function: bool openForWrite(string, unsigned int, int)
+// Description:
+// Starts a new journal, replacing anything already in the file.
+// Parameters:
+// string path - The file to write.
+// unsigned int seed - The seed the world was made from.
+// int tickRate - How many ticks a second the session runs at.
+// Output:
+// bool - Returns false if the file couldn't be opened.
+//=============================================================================
+bool MessageJournal::openForWrite(std::string path, unsigned int seed, int tickRate)
+{
+	close();
+
+	m_stream.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!m_stream.is_open())
+	{
+		return false;
+	}
+
+	int version = m_VERSION;
+
+	m_stream.write(JOURNAL_TAG, sizeof(JOURNAL_TAG));
+	m_stream.write((const char*)&version, sizeof(version));
+	m_stream.write((const char*)&seed, sizeof(seed));
+	m_stream.write((const char*)&tickRate, sizeof(tickRate));
+
+	m_writing = true;
+	m_seed = seed;
+	m_tickRate = tickRate;
+
+	return true;
+}
+
+bool MessageJournal::openForRead(std::string path)
+{
+	close();
+
+	m_stream.open(path, std::ios::in | std::ios::binary);
+
+	if (!m_stream.is_open())
+	{
+		return false;
+	}
+
+	char tag[sizeof(JOURNAL_TAG)];
+	int version = 0;
+
+	m_stream.read(tag, sizeof(tag));
+	m_stream.read((char*)&version, sizeof(version));
+	m_stream.read((char*)&m_seed, sizeof(m_seed));
+	m_stream.read((char*)&m_tickRate, sizeof(m_tickRate));
+
+	if (!m_stream || memcmp(tag, JOURNAL_TAG, sizeof(tag)) != 0 || version != m_VERSION)
+	{
+		close();
+		return false;
+	}
+
+	m_writing = false;
+
+	return true;
+}
+
+void MessageJournal::close()
+{
+	if (m_stream.is_open())
+	{
+		m_stream.close();
+	}
+
+	m_writing = false;
+}
+
+//=============================================================================
+// Function: void write(int, IMessage*)
+// Description:
+// Adds a message to the end of the journal. Types the journal doesn't
+// know about are skipped.
+// Parameters:
+// int tick - The tick the message was handled in.
+// IMessage *message - The message to write.
+//=============================================================================
+void MessageJournal::write(int tick, IMessage *message)
+{
+	if (!writing() || !message)
+	{
+		return;
+	}
+
+	m_payload.clear();
+
+	if (writePayload(message))
+	{
+		RecordHeader header{ tick, message->type(), (int)m_payload.size() };
+
+		m_stream.write((const char*)&header, sizeof(header));
+		m_stream.write(&m_payload[0], m_payload.size());
+	}
+}
+
+//=============================================================================
+// Function: bool read(int&, IMessage*&)
+// Description:
+// Reads records until one makes a message. Records of types this version
+// doesn't know, or whose fields don't make sense, are skipped using the
+// size in their header, so one bad record doesn't end the replay.
+// Parameters:
+// int &tick - Gets the tick the message was handled in.
+// IMessage *& message - Gets the message. NULL when nothing was read.
+// Output:
+// bool - Returns false at the end of the file or if it can't be read.
+//=============================================================================
+bool MessageJournal::read(int &tick, IMessage *& message)
+{
+	message = NULL;
+
+	if (!m_stream.is_open() || m_writing)
+	{
+		return false;
+	}
+
+	while (!message)
+	{
+		RecordHeader header;
+
+		m_stream.read((char*)&header, sizeof(header));
+
+		if (!m_stream || header.m_size < 0)
+		{
+			return false;
+		}
+
+		m_payload.resize(header.m_size);
+		m_readOffset = 0;
+
+		if (0 < header.m_size)
+		{
+			m_stream.read(&m_payload[0], header.m_size);
+
+			if (!m_stream)
+			{
+				return false;
+			}
+		}
+
+		tick = header.m_tick;
+		message = readPayload(header.m_type);
+	}
+
+	return true;
+}
+
+void MessageJournal::writeBytes(const void *data, int size)
+{
+	const char *bytes = (const char*)data;
+
+	m_payload.insert(m_payload.end(), bytes, bytes + size);
+}
+
+// Strings are written as their length and then their characters
+void MessageJournal::writeString(const std::string &value)
+{
+	writeInt((int)value.size());
+	writeBytes(value.data(), (int)value.size());
+}
+
+bool MessageJournal::readBytes(void *data, int size)
+{
+	if ((int)m_payload.size() < m_readOffset + size)
+	{
+		return false;
+	}
+
+	memcpy(data, &m_payload[m_readOffset], size);
+	m_readOffset += size;
+
+	return true;
+}
+
+bool MessageJournal::readString(std::string &value)
+{
+	int size = 0;
+
+	if (!readInt(size) || size < 0 || (int)m_payload.size() < m_readOffset + size)
+	{
+		return false;
+	}
+
+	value.assign(&m_payload[0] + m_readOffset, size);
+	m_readOffset += size;
+
+	return true;
+}
+
+//=============================================================================
+// Function: bool writePayload(IMessage*)
+// Description:
+// Writes the message's fields one at a time, in the order readPayload
+// reads them back.
+// Parameters:
+// IMessage *message - The message to write.
+// Output:
+// bool - Returns false if the message's type can't be written.
+//=============================================================================
+bool MessageJournal::writePayload(IMessage *message)
+{
+	switch (message->type())
+	{
+	case IMessage::MOVE:
+	{
+		MoveMessage *move = static_cast<MoveMessage*>(message);
+
+		writeInt(move->m_entityID);
+		writeFloat(move->m_oldPosition.getX());
+		writeFloat(move->m_oldPosition.getY());
+		writeFloat(move->m_newPosition.getX());
+		writeFloat(move->m_newPosition.getY());
+
+		return true;
+	}
+	case IMessage::COLLISION:
+	{
+		CollisionMessage *collision = static_cast<CollisionMessage*>(message);
+
+		writeInt(collision->m_entityID);
+		writeInt(collision->m_collidingID);
+		writeFloat(collision->m_position.getX());
+		writeFloat(collision->m_position.getY());
+
+		return true;
+	}
+	case IMessage::STATE_CHANGE:
+	{
+		StateChangeMessage *state = static_cast<StateChangeMessage*>(message);
+
+		writeInt(state->m_entityID);
+		writeString(state->m_stateName);
+
+		return true;
+	}
+	case IMessage::VELOCITY_INCREASE:
+	{
+		VelocityIncreaseMessage *velocity = static_cast<VelocityIncreaseMessage*>(message);
+
+		writeInt(velocity->m_entityID);
+		writeFloat(velocity->m_xIncrease);
+		writeFloat(velocity->m_yIncrease);
+		writeFloat(velocity->m_xMaxSpeed);
+		writeFloat(velocity->m_yMaxSpeed);
+
+		return true;
+	}
+	case IMessage::ANIMATION_CHANGE:
+	{
+		AnimationChangeMessage *animation = static_cast<AnimationChangeMessage*>(message);
+
+		writeInt(animation->m_entityID);
+		writeInt(animation->m_frame);
+		writeInt(animation->m_direction);
+		writeString(animation->m_name);
+
+		return true;
+	}
+	case IMessage::ENTITY_DESTROY:
+	{
+		writeInt(static_cast<EntityDestroyMessage*>(message)->m_entityID);
+
+		return true;
+	}
+	case IMessage::INPUT:
+	{
+		InputMessage *input = static_cast<InputMessage*>(message);
+
+		writeInt(input->m_deviceID);
+		writeInt(input->m_deviceType);
+		writeInt(input->m_inputType);
+
+		switch (input->m_inputType)
+		{
+		case InputMessage::INPUT_BUTTON:
+		{
+			InputButtonMessage *button = static_cast<InputButtonMessage*>(input);
+
+			writeInt((int)button->m_button);
+			writeInt(button->m_pressed ? 1 : 0);
+
+			return true;
+		}
+		case InputMessage::INPUT_AXIS:
+		{
+			InputAxisMessage *axis = static_cast<InputAxisMessage*>(input);
+
+			writeInt(axis->m_axis);
+			writeFloat(axis->m_axisMovement);
+
+			return true;
+		}
+		case InputMessage::INPUT_MOVE:
+		{
+			InputMoveMessage *move = static_cast<InputMoveMessage*>(input);
+
+			writeFloat(move->m_x);
+			writeFloat(move->m_y);
+
+			return true;
+		}
+		}
+
+		return false;
+	}
+	case IMessage::CAMERA_MOVE:
+	{
+		CameraMoveMessage *camera = static_cast<CameraMoveMessage*>(message);
+
+		writeFloat(camera->m_oldPosition.getX());
+		writeFloat(camera->m_oldPosition.getY());
+		writeFloat(camera->m_newPosition.getX());
+		writeFloat(camera->m_newPosition.getY());
+
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+//=============================================================================
+// Function: IMessage* readPayload(int)
+// Description:
+// Makes a message out of the fields that were just read in.
+// Parameters:
+// int type - The type of message the fields are for.
+// Output:
+// IMessage* - The new message, or NULL if the fields don't fit the type.
+//=============================================================================
+IMessage* MessageJournal::readPayload(int type)
+{
+	int entityID = 0;
+	int otherID = 0;
+	float values[4]{ 0.0f, 0.0f, 0.0f, 0.0f };
+	std::string name;
+
+	switch (type)
+	{
+	case IMessage::MOVE:
+	{
+		if (readInt(entityID) && readFloat(values[0]) && readFloat(values[1]) && readFloat(values[2]) && readFloat(values[3]))
+		{
+			return new MoveMessage(entityID, Vector2D(values[0], values[1]), Vector2D(values[2], values[3]));
+		}
+
+		break;
+	}
+	case IMessage::COLLISION:
+	{
+		if (readInt(entityID) && readInt(otherID) && readFloat(values[0]) && readFloat(values[1]))
+		{
+			return new CollisionMessage(entityID, otherID, Vector2D(values[0], values[1]));
+		}
+
+		break;
+	}
+	case IMessage::STATE_CHANGE:
+	{
+		if (readInt(entityID) && readString(name))
+		{
+			return new StateChangeMessage(entityID, name);
+		}
+
+		break;
+	}
+	case IMessage::VELOCITY_INCREASE:
+	{
+		if (readInt(entityID) && readFloat(values[0]) && readFloat(values[1]) && readFloat(values[2]) && readFloat(values[3]))
+		{
+			return new VelocityIncreaseMessage(entityID, values[0], values[1], values[2], values[3]);
+		}
+
+		break;
+	}
+	case IMessage::ANIMATION_CHANGE:
+	{
+		int frame = 0;
+		int direction = 0;
+
+		if (readInt(entityID) && readInt(frame) && readInt(direction) && readString(name))
+		{
+			return new AnimationChangeMessage(entityID, name, (AnimationComponent::Direction)direction, frame);
+		}
+
+		break;
+	}
+	case IMessage::ENTITY_DESTROY:
+	{
+		if (readInt(entityID))
+		{
+			return new EntityDestroyMessage(entityID);
+		}
+
+		break;
+	}
+	case IMessage::INPUT:
+	{
+		int deviceType = 0;
+		int inputType = 0;
+
+		if (!readInt(entityID) || !readInt(deviceType) || !readInt(inputType))
+		{
+			break;
+		}
+
+		InputDevice::DEVICE_TYPE device = (InputDevice::DEVICE_TYPE)deviceType;
+
+		switch (inputType)
+		{
+		case InputMessage::INPUT_BUTTON:
+		{
+			int button = 0;
+			int pressed = 0;
+
+			if (readInt(button) && readInt(pressed))
+			{
+				return new InputButtonMessage(entityID, device, (Uint32)button, pressed != 0);
+			}
+
+			break;
+		}
+		case InputMessage::INPUT_AXIS:
+		{
+			int axis = 0;
+
+			if (readInt(axis) && readFloat(values[0]))
+			{
+				return new InputAxisMessage(entityID, device, (Uint8)axis, values[0]);
+			}
+
+			break;
+		}
+		case InputMessage::INPUT_MOVE:
+		{
+			if (readFloat(values[0]) && readFloat(values[1]))
+			{
+				return new InputMoveMessage(entityID, device, values[0], values[1]);
+			}
+
+			break;
+		}
+		}
+
+		break;
+	}
+	case IMessage::CAMERA_MOVE:
+	{
+		if (readFloat(values[0]) && readFloat(values[1]) && readFloat(values[2]) && readFloat(values[3]))
+		{
+			return new CameraMoveMessage(Vector2D(values[0], values[1]), Vector2D(values[2], values[3]));
+		}
+
+		break;
+	}
+	}
+
+	return NULL;
+}
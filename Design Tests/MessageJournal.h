@@ -0,0 +1,73 @@
+#pragma once
+//==========================================================================================
+// File Name: MessageJournal.h
+// Author: Brian Blackmon
+// Date Created: 9/22/2019
+// Purpose: 
+// A binary file of messages. The file starts with the seed the world was
+// made from and the tick rate, then each message is written with the tick
+// it was handled in, its type, and its fields, so a session can be
+// recorded once and played back later. The fields are written as they
+// are in memory, so a journal only plays back on the kind of machine
+// that recorded it.
+//==========================================================================================
+#include "IMessage.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+class MessageJournal
+{
+public:
+	MessageJournal();
+	~MessageJournal();
+
+	bool openForWrite(std::string path, unsigned int seed, int tickRate);
+	bool openForRead(std::string path);
+	void close();
+
+	bool writing() { return m_stream.is_open() && m_writing; }
+	bool reading() { return m_stream.is_open() && !m_writing; }
+
+	// What the recorded session was started with
+	unsigned int seed() { return m_seed; }
+	int tickRate() { return m_tickRate; }
+
+	void write(int tick, IMessage *message);
+	// Makes the next message in the journal, skipping records it can't make
+	// a message from. Returns false at the end or if the file can't be read.
+	bool read(int &tick, IMessage *& message);
+
+private:
+	static const int m_VERSION = 2;
+
+	// Written before each message's fields
+	struct RecordHeader
+	{
+		int m_tick;
+		int m_type;
+		int m_size;
+	};
+
+	std::fstream m_stream;
+	bool m_writing;
+	unsigned int m_seed;
+	int m_tickRate;
+
+	// The fields of the message being written or read
+	std::vector<char> m_payload;
+	int m_readOffset;
+
+	void writeBytes(const void *data, int size);
+	void writeInt(int value) { writeBytes(&value, sizeof(value)); }
+	void writeFloat(float value) { writeBytes(&value, sizeof(value)); }
+	void writeString(const std::string &value);
+
+	bool readBytes(void *data, int size);
+	bool readInt(int &value) { return readBytes(&value, sizeof(value)); }
+	bool readFloat(float &value) { return readBytes(&value, sizeof(value)); }
+	bool readString(std::string &value);
+
+	bool writePayload(IMessage *message);
+	IMessage* readPayload(int type);
+};
@@ -0,0 +1,39 @@
+#include "MessageStaging.h"
+
+MessageStaging::MessageStaging()
+	:m_currentArena(0)
+{
+}
+
+MessageStaging::~MessageStaging()
+{
+	for (unsigned int i = 0; i < m_messages.size(); i++)
+	{
+		delete m_messages[i];
+	}
+}
+
+void* MessageStaging::allocate(size_t size, MessageArena *& arena)
+{
+	arena = &m_arenas[m_currentArena];
+
+	return arena->allocate(size);
+}
+
+//=============================================================================
+// Function: void takeMessages(std::vector<IMessage*>&)
+// Description:
+// Swaps the pushed messages out and starts filling the other arena. The
+// messages in it were taken a frame ago, so they've been polled and freed
+// by now. If some haven't, the arena won't reset and just keeps growing.
+// Parameters:
+// std::vector<IMessage*> &messages - Gets the messages, oldest first. It
+// should be empty.
+//=============================================================================
+void MessageStaging::takeMessages(std::vector<IMessage*> &messages)
+{
+	m_messages.swap(messages);
+
+	m_currentArena = 1 - m_currentArena;
+	m_arenas[m_currentArena].reset();
+}
@@ -0,0 +1,39 @@
+#pragma once
+//==========================================================================================
+// File Name: MessageStaging.h
+// Author: Brian Blackmon
+// Date Created: 9/21/2019
+// Purpose: 
+// Where a thread other than the main one puts the messages it sends. Only
+// its own thread touches it during a frame, so nothing needs a lock. The
+// message system takes the messages when the next frame starts.
+//==========================================================================================
+#include "IMessage.h"
+#include "MessageArena.h"
+#include <vector>
+
+class MessageStaging
+{
+public:
+	MessageStaging();
+	~MessageStaging();
+
+	// Messages made on the staging buffer's thread come from its own arena
+	void* allocate(size_t size, MessageArena *& arena);
+
+	void push(IMessage *message) { m_messages.push_back(message); }
+
+	int messageCount() { return (int)m_messages.size(); }
+
+	// Hands over everything pushed since the last call. Only call it while
+	// the thread that owns the buffer isn't sending anything.
+	void takeMessages(std::vector<IMessage*> &messages);
+
+private:
+	// Same as the message system. One arena is being filled and the other
+	// holds the messages taken at the last frame.
+	MessageArena m_arenas[2];
+	int m_currentArena;
+
+	std::vector<IMessage*> m_messages;
+};
@@ -9,679 +9,872 @@
 #include "CameraMoveMessage.h"
 #include <SDL.h>
 #include <cmath>
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+
+// Gives the thread's staging buffer back to the message system when the
+// thread ends, so the next thread can have it.
+struct StagingHandle
+{
+	MessageStaging *m_staging = NULL;
+
+	~StagingHandle()
+	{
+		if (m_staging)
+		{
+			MessageSystem::instance()->releaseStaging(m_staging);
+		}
+	}
+};
+
+static thread_local StagingHandle t_stagingHandle;
 
 //=============================================================================
-// Function: bool pollMessage(IMessage)
+// Function: void beginFrame()
 // Description:
-// Polls the event to see if there's a system message in the queue.
-// Parameters:
-// IMessage &message - The message to fill.
-// Output:
-// Returns true if there's a message.
-// Returns false if there isn't.
+// Starts a new batch of messages. The messages polled last frame are
+// freed, and everything pushed since then can be polled.
 //=============================================================================
-bool MessageSystem::pollMessage(IMessage *& message)
+void MessageSystem::beginFrame()
 {
-	bool messageRetrieved = false;
+	releasePolled();
+
+	// Everything in the other arena was polled last frame and just freed
+	m_currentArena = 1 - m_currentArena;
+	m_arenas[m_currentArena].reset();
+
+	mergeStaged();
+	finishFrameStats();
 
-	int msgIndex = getNextUnprocessedMessage();
+	m_frameCount = m_pendingCount;
+}
+
+void MessageSystem::releaseStaging(MessageStaging *staging)
+{
+	std::lock_guard<std::mutex> lock(m_stagingMutex);
 
-	if(msgIndex != -1)
+	m_freeStaging.push_back(staging);
+}
+
+//=============================================================================
+// Function: MessageStaging* stagingBuffer()
+// Description:
+// Gets the calling thread's staging buffer. The first time a thread asks,
+// it's given one, which is the only time a lock is taken.
+// Output:
+// MessageStaging* - The buffer, or NULL on the thread that polls, since
+// it pushes straight into the queue.
+//=============================================================================
+MessageStaging* MessageSystem::stagingBuffer()
+{
+	if (t_stagingHandle.m_staging)
 	{
-		if (m_messages[msgIndex])
-		{
-			message = m_messages[msgIndex];
-			m_messageFlag[msgIndex] = true;
+		return t_stagingHandle.m_staging;
+	}
 
-			messageRetrieved = true;
-		}
+	if (std::this_thread::get_id() == m_pollingThread)
+	{
+		return NULL;
 	}
 
-	if (!messageRetrieved)
+	std::lock_guard<std::mutex> lock(m_stagingMutex);
+
+	if (m_freeStaging.empty())
 	{
-		message = NULL;
+		m_staging.push_back(new MessageStaging());
+		t_stagingHandle.m_staging = m_staging.back();
+	}
+	else
+	{
+		t_stagingHandle.m_staging = m_freeStaging.back();
+		m_freeStaging.pop_back();
 	}
 
-	return messageRetrieved;
+	return t_stagingHandle.m_staging;
 }
 
 //=============================================================================
-// Function: void pushMessage(IMessage)
+// Function: void mergeStaged()
 // Description:
-// Pushes a message onto the queue.
-// Parameters:
-// IMessage message - The message to push.
+// Pushes every staged message into the queue, one buffer after another in
+// the order the buffers were made. They're combined and dropped the same as
+// messages pushed here. Threads don't share a buffer, so only messages from
+// the same thread are sure to stay in the order they were sent.
 //=============================================================================
-void MessageSystem::pushMessage(IMessage *message)
+void MessageSystem::mergeStaged()
 {
-	if(!combineMessage(message))
+	std::lock_guard<std::mutex> lock(m_stagingMutex);
+
+	for (unsigned int i = 0; i < m_staging.size(); i++)
 	{
-		if(m_messages.size() < (unsigned int)m_MAX_MESSAGES)
+		m_staging[i]->takeMessages(m_merging);
+
+		for (unsigned int j = 0; j < m_merging.size(); j++)
 		{
-			m_messages.push_back(message);
-			m_messageFlag.push_back(false);
+			pushMessage(m_merging[j]);
 		}
-		else
-		{
-			// Find the next available message.
-			int index = getFirstProcessedMessage();
 
-			if(0 <= index)
-			{
-				delete m_messages[index];
-				m_messages[index] = NULL;
-
-				if (message)
-				{
-					m_messages[index] = message;
-					m_messageFlag[index] = false;
-				}
-			}
-			else if(index == -1)
-			{
-				delete message;
-				message = NULL;
-			}
-		}
+		m_merging.clear();
 	}
-
 }
 
-//=============================================================================
-// Function: bool peekMessage(IMessage *& message)
-// Description:
-// Loops through the message queue and peeks through the messages.
-// Parameters:
-// IMessage *& message - The message to fill the data of.
-// Output:
-// bool - Returns true on message found
-// Returns false if no message.
-//=============================================================================
-bool MessageSystem::peekMessage(IMessage *& message, int startingIndex)
+void MessageSystem::Stats::clear(int frame)
 {
-	bool messageFound = false;
+	m_frame = frame;
+	m_depth = 0;
+	m_peakDepth = 0;
 
-	if(0 <= startingIndex && (unsigned int)startingIndex < m_messages.size())
+	for (int type = 0; type < m_MESSAGE_TYPES; type++)
 	{
-		if(m_messageFlag[startingIndex] == false)
+		for (int counter = 0; counter < COUNTER_COUNT; counter++)
 		{
-			message = m_messages[startingIndex];
-			messageFound = true;
+			m_counts[type][counter] = 0;
 		}
 	}
+}
 
-	return messageFound;
+int MessageSystem::Stats::total(Counter counter) const
+{
+	int total = 0;
+
+	for (int type = 0; type < m_MESSAGE_TYPES; type++)
+	{
+		total += m_counts[type][counter];
+	}
+
+	return total;
 }
 
-//=============================================================================
-// Function: void flushMessages()
-// Description:
-// Flushes the message queue, deleting all of the current messages.
-//=============================================================================
-void MessageSystem::flushMessages()
+float MessageSystem::Stats::coalesceRatio() const
+{
+	int pushed = total(PUSHED);
+
+	return (pushed == 0 ? 0.0f : (float)total(COALESCED) / (float)pushed);
+}
+
+bool MessageSystem::frameStats(int framesAgo, Stats &stats)
 {
-	for(unsigned int i = 0; i < m_messages.size(); i++)
+	if (framesAgo < 0 || m_statsCount <= framesAgo)
 	{
-		delete m_messages[i];
+		return false;
 	}
 
-	m_messages.resize(0);
+	stats = m_statsHistory[(m_statsNext - 1 - framesAgo + m_STATS_FRAMES) % m_STATS_FRAMES];
 
-	m_messageFlag.clear();
-	m_messageFlag.resize(0);
+	return true;
 }
 
 //=============================================================================
-// Function: bool combineMessage(IMessage&)
+// Function: bool writeStats(string)
 // Description:
-// Looks through the message queue and sees if it can merge the message with
-// any of the existing messages.
+// Writes the stats out as comma separated values, the oldest frame first
+// and the totals last. Each type gets a column for each counter.
 // Parameters:
-// IMessage &message - The message to try to combine.
+// string path - The file to write. It's replaced if it already exists.
 // Output:
-// Returns true on successful combining.
-// Returns false on failure.
+// bool - Returns false if the file couldn't be opened.
 //=============================================================================
-bool MessageSystem::combineMessage(IMessage *message)
+bool MessageSystem::writeStats(std::string path)
 {
-	bool combined = false;
+	static const char *typeNames[m_MESSAGE_TYPES] = { "Move", "Collision", "StateChange", "VelocityIncrease",
+		"AnimationChange", "EntityDestroy", "Input", "CameraMove" };
+	static const char *counterNames[Stats::COUNTER_COUNT] = { "Pushed", "Coalesced", "Dropped", "Polled" };
 
-	switch(message->type())
-	{
-	case IMessage::MessageType::COLLISION:
-	{
-		combined = combineCollision(message);
-		break;
-	}
-	case IMessage::MessageType::MOVE:
-	{
-		combined = combineMove(message);
-		break;
-	}
-	case IMessage::MessageType::VELOCITY_INCREASE:
+	std::fstream statsStream;
+
+	statsStream.open(path, std::ios::out | std::ios::trunc);
+
+	if (!statsStream.is_open())
 	{
-		combined = combineVelIncrease(message);
-		break;
+		return false;
 	}
-	case IMessage::MessageType::ANIMATION_CHANGE:
+
+	statsStream << "Frame,Depth,PeakDepth";
+
+	for (int type = 0; type < m_MESSAGE_TYPES; type++)
 	{
-		combined = combineAnimationChange(message);
-		break;
+		for (int counter = 0; counter < Stats::COUNTER_COUNT; counter++)
+		{
+			statsStream << "," << typeNames[type] << counterNames[counter];
+		}
 	}
-	case IMessage::ENTITY_DESTROY:
+
+	statsStream << ",CoalesceRatio\n";
+
+	for (int i = m_statsCount; 0 <= i; i--)
 	{
-		combined = combineEntityDestroy(message);
-		break;
+		Stats stats = m_totalStats;
+
+		if (0 < i)
+		{
+			frameStats(i - 1, stats);
+			statsStream << stats.m_frame;
+		}
+		else
+		{
+			statsStream << "Total";
+		}
+
+		statsStream << "," << stats.m_depth << "," << stats.m_peakDepth;
+
+		for (int type = 0; type < m_MESSAGE_TYPES; type++)
+		{
+			for (int counter = 0; counter < Stats::COUNTER_COUNT; counter++)
+			{
+				statsStream << "," << stats.m_counts[type][counter];
+			}
+		}
+
+		statsStream << "," << stats.coalesceRatio() << "\n";
 	}
-	case IMessage::INPUT:
+
+	statsStream.close();
+
+	return true;
+}
+
+bool MessageSystem::startRecording(std::string path, unsigned int seed, int tickRate)
+{
+	return m_journal.openForWrite(path, seed, tickRate);
+}
+
+//=============================================================================
+// Function: bool startReplay(string, unsigned int&, int&)
+// Description:
+// Opens a journal to play back. Anything already waiting in the queue is
+// thrown away, since the journal has it from when it was recorded.
+// Parameters:
+// string path - The journal to play.
+// unsigned int &seed - Gets the seed the world was made from.
+// int &tickRate - Gets the tick rate the session ran at.
+// Output:
+// bool - Returns false if the journal couldn't be opened.
+//=============================================================================
+bool MessageSystem::startReplay(std::string path, unsigned int &seed, int &tickRate)
+{
+	stopReplay();
+
+	if (!m_replayJournal.openForRead(path))
 	{
-		combined = combineInput(message);
-		break;
+		return false;
 	}
-	case IMessage::CAMERA_MOVE:
-	{
-		combined = combineCameraMove(message);
 
-		break;
-	}
+	flushMessages();
+
+	seed = m_replayJournal.seed();
+	tickRate = m_replayJournal.tickRate();
+
+	m_replaying = true;
+
+	if (!m_replayJournal.read(m_replayNextTick, m_replayNext))
+	{
+		m_replayNext = NULL;
 	}
 
-	return combined;
+	return true;
 }
 
 //=============================================================================
-// Function: int getNextUnprocessedMessage()
+// Function: bool replayTick(int)
 // Description:
-// Gets the next message that hasn't been processed.
+// Queues the input messages recorded for the tick. The rest of what was
+// recorded is thrown away, since the systems send it again themselves.
+// Parameters:
+// int tick - The tick about to be run.
 // Output:
-// Returns the index number of the unprocessed message.
-// Returns -1 on error.
+// bool - Returns true if the journal has messages after this tick.
 //=============================================================================
-int MessageSystem::getNextUnprocessedMessage()
+bool MessageSystem::replayTick(int tick)
 {
-
-	if (0 < m_messages.size())
+	while (m_replayNext && m_replayNextTick <= tick)
 	{
-		while (m_currentPollIndex < (int)m_messages.size() && m_messageFlag[m_currentPollIndex])
+		if (m_replayNext->type() == IMessage::INPUT)
 		{
-			m_currentPollIndex++;
+			queueMessage(m_replayNext);
 		}
-
-		if (m_currentPollIndex == (int)m_messages.size())
+		else
 		{
-			m_currentPollIndex = 0;
-			return -1;
+			delete m_replayNext;
 		}
-		else if(m_messages[m_currentPollIndex] == NULL)
+
+		if (!m_replayJournal.read(m_replayNextTick, m_replayNext))
 		{
-			return -1;
+			m_replayNext = NULL;
 		}
 	}
-	else
+
+	return (m_replayNext != NULL);
+}
+
+void MessageSystem::stopReplay()
+{
+	if (m_replayNext)
 	{
-		return -1;
+		delete m_replayNext;
+		m_replayNext = NULL;
 	}
 
-	return m_currentPollIndex;
+	m_replayJournal.close();
+	m_replaying = false;
+}
+
+void MessageSystem::subscribe(IMessageHandler *handler, IMessage::MessageType type)
+{
+	if (handler && 0 <= type && type < m_MESSAGE_TYPES)
+	{
+		std::vector<IMessageHandler*> &subscribers = m_subscribers[type];
+
+		if (std::find(subscribers.begin(), subscribers.end(), handler) == subscribers.end())
+		{
+			subscribers.push_back(handler);
+		}
+	}
+}
+
+void MessageSystem::unsubscribe(IMessageHandler *handler)
+{
+	for (int type = 0; type < m_MESSAGE_TYPES; type++)
+	{
+		std::vector<IMessageHandler*> &subscribers = m_subscribers[type];
+
+		subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), handler), subscribers.end());
+	}
 }
 
 //=============================================================================
-// Function: int getFirstProcessedMessage()
+// Function: void dispatchMessages()
 // Description:
-// Finds the first message in the vector that has been processed by 
-// the poll loop.
-// Output:
-// Returns the index of the processed message on success.
-// Returns -1 on failure.
+// Polls the whole frame, sorting the messages by type, then gives each
+// subscriber its types one batch at a time. Types go out in the order
+// they're listed in IMessage, and messages keep their order within a type.
+// Types nobody subscribed to are just polled and freed. Messages stay
+// alive until the next frame, so the batches can hold onto them.
 //=============================================================================
-int MessageSystem::getFirstProcessedMessage()
+void MessageSystem::dispatchMessages()
 {
-	int messageIndex = -1;
+	IMessage *message = NULL;
 
-	if (0 < m_messages.size())
+	beginFrame();
+
+	while (pollMessage(message))
 	{
-		if(!m_messageFlag[m_currentPushIndex])
+		if (message && 0 <= message->type() && message->type() < m_MESSAGE_TYPES &&
+			!m_subscribers[message->type()].empty())
 		{
-			int prevPushIndex = m_currentPushIndex;
-			
-			m_currentPushIndex++;
+			m_batches[message->type()].push_back(message);
+		}
+	}
 
-			if(m_currentPushIndex == (int)m_messages.size())
-			{
-				m_currentPushIndex = 0;
-			}
+	for (int type = 0; type < m_MESSAGE_TYPES; type++)
+	{
+		std::vector<IMessage*> &batch = m_batches[type];
 
-			while(m_currentPushIndex != prevPushIndex && !m_messageFlag[m_currentPushIndex])
+		if (!batch.empty())
+		{
+			for (unsigned int i = 0; i < m_subscribers[type].size(); i++)
 			{
-				m_currentPushIndex++;
-
-				if(m_currentPushIndex == (int)m_messages.size())
-				{
-					m_currentPushIndex = 0;
-				}
+				m_subscribers[type][i]->processMessages(&batch[0], (int)batch.size());
 			}
 
-			if(m_currentPushIndex != prevPushIndex)
-			{
-				messageIndex = m_currentPushIndex;
-			}
-		}
-		else
-		{
-			messageIndex = m_currentPushIndex;
+			batch.clear();
 		}
 	}
+}
+
+// Counts towards both the current frame and the totals
+void MessageSystem::countMessage(IMessage *message, Stats::Counter counter)
+{
+	int type = message->type();
 
-	if(messageIndex != -1)
+	if (0 <= type && type < m_MESSAGE_TYPES)
 	{
-		delete m_messages[messageIndex];
-		m_messages[messageIndex] = NULL;
+		m_frameStats.m_counts[type][counter]++;
+		m_totalStats.m_counts[type][counter]++;
 	}
+}
 
-	return messageIndex;
+void MessageSystem::countDepth(int depth)
+{
+	if (m_frameStats.m_peakDepth < depth) { m_frameStats.m_peakDepth = depth; }
+	if (m_totalStats.m_peakDepth < depth) { m_totalStats.m_peakDepth = depth; }
 }
 
-//=============================================================================
-// Function: void resetMessageFlag(int)
-// Description:
-// Resets the message flag for the specified message, setting it to false.
-// This means the message hasn't been processed.
-// Parameters:
-// int index - The index of the flag to reset.
-//=============================================================================
-void MessageSystem::resetMessageFlag(int index)
+// Keeps the frame that just ended and starts the next one off with what's
+// waiting to be polled.
+void MessageSystem::finishFrameStats()
 {
-	if(0 <= index && index < (int)m_messageFlag.size())
+	m_statsHistory[m_statsNext] = m_frameStats;
+	m_statsNext = (m_statsNext + 1) % m_STATS_FRAMES;
+
+	if (m_statsCount < m_STATS_FRAMES)
 	{
-		m_messageFlag[index] = false;
+		m_statsCount++;
+	}
 
-		if(index < m_currentPollIndex)
-		{
-			m_currentPollIndex = index;
-		}
+	m_frameStats.clear(m_frameStats.m_frame + 1);
+	m_frameStats.m_depth = m_pendingCount;
+
+	countDepth(m_polledCount + m_pendingCount);
+}
+
+// The arena a message came from is written just before it, so it can be
+// counted as freed in the right one.
+void* MessageSystem::allocateMessage(size_t size)
+{
+	MessageStaging *staging = stagingBuffer();
+	MessageArena *arena = &m_arenas[m_currentArena];
+	char *memory = NULL;
+
+	if (staging)
+	{
+		memory = (char*)staging->allocate(m_MESSAGE_HEADER_SIZE + size, arena);
 	}
+	else
+	{
+		memory = (char*)arena->allocate(m_MESSAGE_HEADER_SIZE + size);
+	}
+
+	*(MessageArena**)memory = arena;
+
+	return memory + m_MESSAGE_HEADER_SIZE;
+}
+
+void MessageSystem::freeMessage(void *memory)
+{
+	if (memory)
+	{
+		MessageArena *arena = *(MessageArena**)((char*)memory - m_MESSAGE_HEADER_SIZE);
+
+		arena->release();
+	}
+}
+
+void* IMessage::operator new(size_t size)
+{
+	return MessageSystem::instance()->allocateMessage(size);
+}
+
+void IMessage::operator delete(void *memory)
+{
+	MessageSystem::instance()->freeMessage(memory);
 }
 
 //=============================================================================
-// Function: bool combineCollision(IMessage*)
+// Function: bool pollMessage(IMessage)
 // Description:
-// Combines the collision message with another compatible collision message
-// if possible.
+// Polls the event to see if there's a system message in the queue. The
+// message stays alive until the next frame starts.
 // Parameters:
-// IMessage *message - The message to combine.
+// IMessage &message - The message to fill.
 // Output:
-// Returns true if the message was combined.
-// Returns false if the message wasn't combined.
+// Returns true if there's a message.
+// Returns false if there isn't.
 //=============================================================================
-bool MessageSystem::combineCollision(IMessage *message)
+bool MessageSystem::pollMessage(IMessage *& message)
 {
-	bool combined = false;
+	message = NULL;
 
-	for (unsigned int i = 0; i < m_messages.size(); i++)
+	if (m_frameCount == 0)
 	{
-		if(m_messages[i]->type() == IMessage::MessageType::COLLISION)
-		{
-			CollisionMessage *messageToCombine = static_cast<CollisionMessage*>(message);
-			CollisionMessage *currentMessage = static_cast<CollisionMessage*>(m_messages[i]);
+		return false;
+	}
 
-			if(currentMessage->m_entityID == messageToCombine->m_entityID)
-			{
-				if(currentMessage->m_collidingID == messageToCombine->m_collidingID)
-				{
-					currentMessage->m_position = messageToCombine->m_position;
-					
-					resetMessageFlag(i);
-
-					combined = true;
-
-					// Delete the created message
-					delete message;
-					message = NULL;
-				}
-			}
-		}
+	message = m_messages[m_pollIndex];
 
-		if(combined)
-		{
-			break;
-		}
+	unindexMessage(message);
+	countMessage(message, Stats::POLLED);
+
+	if (m_journal.writing())
+	{
+		m_journal.write(m_tick, message);
 	}
 
-	return combined;
+	m_pollIndex = pendingSlot(1);
+	m_polledCount++;
+	m_pendingCount--;
+	m_frameCount--;
+
+	return true;
 }
 
 //=============================================================================
-// Function: bool combineMove(IMessage*)
+// Function: void pushMessage(IMessage)
 // Description:
-// Trys to combine the move message with an already existing move message.
+// Pushes a message onto the end of the queue. If every slot is taken, the
+// message is dropped and counted.
 // Parameters:
-// IMessage *message - The message to try to combine.
-// Output:
-// Returns true if the message was combined.
-// Returns false if the message failed to be combined.
+// IMessage message - The message to push.
 //=============================================================================
-bool MessageSystem::combineMove(IMessage *message)
+void MessageSystem::pushMessage(IMessage *message)
 {
-	bool combined = false;
+	if (!message)
+	{
+		return;
+	}
+
+	MessageStaging *staging = stagingBuffer();
 
-	if (message->type() == IMessage::MOVE)
+	if (staging)
 	{
-		for (unsigned int i = 0; i < m_messages.size(); i++)
-		{
-			if (m_messages[i]->type() == IMessage::MessageType::MOVE)
-			{
-				// TODO: Remember. This takes away the system's "memory"
-				// of moves that are made. If you want to track them and store
-				// them, make a separate tool for that.
-				MoveMessage *combineMove = static_cast<MoveMessage*>(message);
-				MoveMessage *currentMove = static_cast<MoveMessage*>(m_messages[i]);
+		staging->push(message);
+		return;
+	}
 
-				if (currentMove->m_entityID == combineMove->m_entityID)
-				{
-					currentMove->m_oldPosition = combineMove->m_oldPosition;
-					currentMove->m_newPosition = combineMove->m_newPosition;
+	// Only the journal's input goes into a replay
+	if (m_replaying && message->type() == IMessage::INPUT)
+	{
+		delete message;
+		return;
+	}
 
-					resetMessageFlag(i);
+	queueMessage(message);
+}
 
-					combined = true;
+// Puts a message in the queue, unless it can be combined with one that's
+// already waiting or there's no room.
+void MessageSystem::queueMessage(IMessage *message)
+{
+	// Staged messages are counted when they're merged in
+	countMessage(message, Stats::PUSHED);
 
-					delete message;
-					message = NULL;
-				}
-			}
+	if (combineMessage(message))
+	{
+		return;
+	}
 
-			if (combined)
-			{
-				break;
-			}
-		}
+	int usedCount = m_polledCount + m_pendingCount;
+
+	if (usedCount == m_MAX_MESSAGES)
+	{
+		countMessage(message, Stats::DROPPED);
+
+		delete message;
+		return;
 	}
 
-	return combined;
+	m_messages[pendingSlot(m_pendingCount)] = message;
+	indexMessage(message, pendingSlot(m_pendingCount));
+	m_pendingCount++;
+
+	countDepth(usedCount + 1);
 }
 
 //=============================================================================
-// Function: bool combineVelIncrease(IMessage*)
+// Function: bool peekMessage(IMessage *& message)
 // Description:
-// Trys to combine the velocity increase message with an 
-// already existing velocity increase message.
+// Looks at a message that hasn't been polled yet without taking it.
 // Parameters:
-// IMessage *message - The message to try to combine.
+// IMessage *& message - The message to fill the data of.
+// int startingIndex - How many messages after the next one to look at.
 // Output:
-// Returns true if the message was combined.
-// Returns false if the message failed to be combined.
+// bool - Returns true on message found
+// Returns false if no message.
 //=============================================================================
-bool MessageSystem::combineVelIncrease(IMessage *message)
+bool MessageSystem::peekMessage(IMessage *& message, int startingIndex)
 {
-	bool combined = false;
+	bool messageFound = false;
 
-	for (unsigned int i = 0; i < m_messages.size(); i++)
+	if(0 <= startingIndex && startingIndex < m_pendingCount)
 	{
-		if (m_messages[i]->type() == IMessage::MessageType::VELOCITY_INCREASE)
-		{
-			VelocityIncreaseMessage *messageToCombine = static_cast<VelocityIncreaseMessage*>(message);
-			VelocityIncreaseMessage *currentMessage = static_cast<VelocityIncreaseMessage*>(m_messages[i]);
+		message = m_messages[pendingSlot(startingIndex)];
+		messageFound = true;
+	}
 
-			if (currentMessage->m_entityID == messageToCombine->m_entityID)
-			{
+	return messageFound;
+}
 
-				if (m_messageFlag[i] == true)
-				{
-					currentMessage->m_xIncrease = messageToCombine->m_xIncrease;
-					currentMessage->m_yIncrease = messageToCombine->m_yIncrease;
-					currentMessage->m_xMaxSpeed = messageToCombine->m_xMaxSpeed;
-					currentMessage->m_yMaxSpeed = messageToCombine->m_yMaxSpeed;
+//=============================================================================
+// Function: void flushMessages()
+// Description:
+// Flushes the message queue, deleting all of the current messages.
+//=============================================================================
+void MessageSystem::flushMessages()
+{
+	releasePolled();
 
-					resetMessageFlag(i);
+	for (int i = 0; i < m_pendingCount; i++)
+	{
+		delete m_messages[pendingSlot(i)];
+	}
 
-					combined = true;
+	m_pendingCount = 0;
+	m_frameCount = 0;
 
-					// Delete the created message
-					delete message;
-					message = NULL;
-				}
-			}
-		}
+	m_pendingIndex.clear();
+
+	std::lock_guard<std::mutex> lock(m_stagingMutex);
+
+	for (unsigned int i = 0; i < m_staging.size(); i++)
+	{
+		m_staging[i]->takeMessages(m_merging);
 
-		if (combined)
+		for (unsigned int j = 0; j < m_merging.size(); j++)
 		{
-			break;
+			delete m_merging[j];
 		}
+
+		m_merging.clear();
 	}
+}
 
-	return combined;
+// Deletes the messages that have already been handed out
+void MessageSystem::releasePolled()
+{
+	for (int i = 0; i < m_polledCount; i++)
+	{
+		int slot = (m_polledStart + i) % m_MAX_MESSAGES;
+
+		delete m_messages[slot];
+		m_messages[slot] = NULL;
+	}
+
+	m_polledStart = m_pollIndex;
+	m_polledCount = 0;
 }
 
 //=============================================================================
-// Function: bool combineAnimationChange(IMessage*)
+// Function: bool messageKey(IMessage*, MessageKey&)
 // Description:
-// Trys to combine the animation change message with an already 
-// existing animation change message.
+// Gets what a message is combined by. Two pending messages with the same
+// key are merged into one.
 // Parameters:
-// IMessage *message - The message to try to combine.
+// IMessage *message - The message to get the key of.
+// MessageKey &key - Gets the key.
 // Output:
-// Returns true if the message was combined.
-// Returns false if the message failed to be combined.
+// Returns true if the message can be combined.
+// Returns false if every message of its kind is kept.
 //=============================================================================
-bool MessageSystem::combineAnimationChange(IMessage *message)
+bool MessageSystem::messageKey(IMessage *message, MessageKey &key)
 {
-	bool combined = false;
+	key.m_type = message->type();
+	key.m_first = 0;
+	key.m_second = 0;
+	key.m_third = 0;
 
-	AnimationChangeMessage *animation = static_cast<AnimationChangeMessage*>(message);
+	switch (message->type())
+	{
+	case IMessage::COLLISION:
+	{
+		CollisionMessage *collision = static_cast<CollisionMessage*>(message);
+
+		key.m_first = collision->m_entityID;
+		key.m_second = collision->m_collidingID;
 
-	for(unsigned int i = 0; i < m_messages.size(); i++)
+		return true;
+	}
+	case IMessage::MOVE:
 	{
-		if(m_messages[i]->type() == IMessage::ANIMATION_CHANGE)
-		{
-			AnimationChangeMessage *combine = static_cast<AnimationChangeMessage*>(m_messages[i]);
+		key.m_first = static_cast<MoveMessage*>(message)->m_entityID;
 
-			if (animation->m_entityID == combine->m_entityID)
-			{
-				combine->m_name = animation->m_name;
-				combine->m_frame = animation->m_frame;
-				combine->m_direction = animation->m_direction;
+		return true;
+	}
+	case IMessage::ANIMATION_CHANGE:
+	{
+		key.m_first = static_cast<AnimationChangeMessage*>(message)->m_entityID;
+
+		return true;
+	}
+	case IMessage::ENTITY_DESTROY:
+	{
+		key.m_first = static_cast<EntityDestroyMessage*>(message)->m_entityID;
+
+		return true;
+	}
+	case IMessage::INPUT:
+	{
+		InputMessage *input = static_cast<InputMessage*>(message);
 
-				resetMessageFlag(i);
+		key.m_first = input->m_inputType;
+		key.m_second = input->m_deviceID;
 
-				combined = true;
+		switch (input->m_inputType)
+		{
+		case InputMessage::INPUT_AXIS:
+		{
+			key.m_third = static_cast<InputAxisMessage*>(input)->m_axis;
 
-				delete message;
-				message = NULL;
-			}
+			return true;
 		}
+		case InputMessage::INPUT_BUTTON:
+		{
+			key.m_third = (int)static_cast<InputButtonMessage*>(input)->m_button;
 
-		if(combined)
+			return true;
+		}
+		case InputMessage::INPUT_MOVE:
 		{
-			break;
+			return true;
+		}
 		}
+
+		return false;
+	}
+	case IMessage::CAMERA_MOVE:
+	{
+		// There's only one camera
+		return true;
+	}
 	}
 
-	return combined;
+	return false;
 }
 
 //=============================================================================
-// Function: bool combineEntityDestroy(IMessage*)
+// Function: bool combineMessage(IMessage&)
 // Description:
-// Checks to see if there is already a destroy message for an entity.
-// If so, it combines the current message with the existing message.
+// Looks up a message that hasn't been polled yet with the same key and
+// merges the new one into it. Velocity increases add up, so every one of
+// them is kept.
 // Parameters:
-// IMessage *message - The message to try to combine.
+// IMessage &message - The message to try to combine.
 // Output:
-// Returns true on success.
+// Returns true on successful combining.
 // Returns false on failure.
 //=============================================================================
-bool MessageSystem::combineEntityDestroy(IMessage *message)
+bool MessageSystem::combineMessage(IMessage *message)
 {
-	bool combined = false;
+	MessageKey key;
 
-	if(message)
+	if (!messageKey(message, key))
 	{
-		EntityDestroyMessage *destroy = static_cast<EntityDestroyMessage*>(message);
+		return false;
+	}
 
-		if(destroy)
-		{
-			for(unsigned int i = 0; i < m_messages.size(); i++)
-			{
-				if(m_messages[i]->type() == IMessage::ENTITY_DESTROY)
-				{
-					EntityDestroyMessage *current = static_cast<EntityDestroyMessage*>(m_messages[i]);
-
-					if(current)
-					{
-						if(current->m_entityID == destroy->m_entityID)
-						{
-							resetMessageFlag(i);
-
-							combined = true;
-
-							delete message;
-							message = NULL;
-						}
-					}
-				}
-
-				if(combined)
-				{
-					break;
-				}
-			}
-		}
+	std::unordered_map<MessageKey, int, MessageKeyHash>::iterator found = m_pendingIndex.find(key);
+
+	if (found == m_pendingIndex.end())
+	{
+		return false;
+	}
+
+	IMessage *pending = m_messages[found->second];
+
+	switch(message->type())
+	{
+	case IMessage::MessageType::COLLISION:
+	{
+		combineCollision(pending, message);
+		break;
+	}
+	case IMessage::MessageType::MOVE:
+	{
+		combineMove(pending, message);
+		break;
+	}
+	case IMessage::MessageType::ANIMATION_CHANGE:
+	{
+		combineAnimationChange(pending, message);
+		break;
+	}
+	case IMessage::INPUT:
+	{
+		combineInput(pending, message);
+		break;
+	}
+	case IMessage::CAMERA_MOVE:
+	{
+		combineCameraMove(pending, message);
+		break;
+	}
+	default:
+		// Destroying an entity twice is the same as once
+		break;
 	}
 
-	return combined;
+	countMessage(message, Stats::COALESCED);
+
+	delete message;
+
+	return true;
 }
 
-//=============================================================================
-// Function: bool combineInput(IMessage*)
-// Description:
-// Trys to combine the input message with an already existing input message.
-// Parameters:
-// IMessage *message - The message to try to combine.
-// Output:
-// Returns true if the message was combined.
-// Returns false if the message failed to be combined.
-//=============================================================================
-bool MessageSystem::combineInput(IMessage *message)
+// Lets later messages with the same key be combined with the one in the slot
+void MessageSystem::indexMessage(IMessage *message, int slot)
 {
-	bool combined = false;
+	MessageKey key;
 
-	if(message->type() == IMessage::INPUT)
+	if (messageKey(message, key))
 	{
-		InputMessage *first = static_cast<InputMessage*>(message);
-
-		for (unsigned int i = 0; i < m_messages.size(); i++)
-		{
-			if (m_messages[i]->type() == IMessage::INPUT)
-			{
-				InputMessage *second = static_cast<InputMessage*>(m_messages[i]);
-
-				if (first->m_inputType == second->m_inputType &&
-					first->m_deviceID == second->m_deviceID)
-				{
-					// Do final checks to make sure the message can be combined.
-					switch (first->m_inputType)
-					{
-					case InputMessage::INPUT_AXIS:
-					{
-						InputAxisMessage *firstAxis = static_cast<InputAxisMessage*>(first);
-						InputAxisMessage *secondAxis = static_cast<InputAxisMessage*>(second);
-
-						if(firstAxis->m_axis == secondAxis->m_axis)
-						{
-							secondAxis->m_axisMovement = firstAxis->m_axisMovement;
-
-							combined = true;
-						}
-
-						break;
-					}
-					case InputMessage::INPUT_BUTTON:
-					{
-						InputButtonMessage *firstButton = static_cast<InputButtonMessage*>(first);
-						InputButtonMessage *secondButton = static_cast<InputButtonMessage*>(second);
-
-						if(firstButton->m_button == secondButton->m_button)
-						{
-							secondButton->m_pressed = firstButton->m_pressed;
-
-							combined = true;
-						}
-
-						break;
-					}
-					case InputMessage::INPUT_MOVE:
-					{
-						InputMoveMessage *firstMove = static_cast<InputMoveMessage*>(first);
-						InputMoveMessage *secondMove = static_cast<InputMoveMessage*>(second);
-
-						secondMove->m_x = firstMove->m_x;
-						secondMove->m_y = firstMove->m_y;
-
-						combined = true;
-
-						break;
-					}
-					}
-
-					// If we've successfully combined the message
-					// reset and exit.
-					if(combined)
-					{
-						resetMessageFlag(i);
-
-						delete message;
-						message = NULL;
-
-						break;
-					}
-				}
-			}
-		}
+		m_pendingIndex[key] = slot;
 	}
-
-	return combined;
 }
 
-//=============================================================================
-// Function: bool combineCameraMove(IMessage*)
-// Description:
-// Combines the move message with an existing move message.
-// Parameters:
-// IMessage *message - The message to try to combine.
-// Output:
-// Returns true on success.
-// Returns false on failure.
-//=============================================================================
-bool MessageSystem::combineCameraMove(IMessage *message)
+// Stops the message from being combined with once it's been polled
+void MessageSystem::unindexMessage(IMessage *message)
 {
-	bool combined = false;
+	MessageKey key;
 
-	if(message->type() == IMessage::CAMERA_MOVE)
+	if (messageKey(message, key))
 	{
-		CameraMoveMessage *combineAttempt = static_cast<CameraMoveMessage*>(message);
+		m_pendingIndex.erase(key);
+	}
+}
 
-		for(unsigned int i = 0; i < m_messages.size(); i++)
-		{
-			if(m_messages[i]->type() == IMessage::CAMERA_MOVE)
-			{
-				CameraMoveMessage *combineWith = static_cast<CameraMoveMessage*>(m_messages[i]);
+void MessageSystem::combineCollision(IMessage *pending, IMessage *message)
+{
+	CollisionMessage *currentMessage = static_cast<CollisionMessage*>(pending);
+	CollisionMessage *messageToCombine = static_cast<CollisionMessage*>(message);
 
-				combineWith->m_oldPosition = combineAttempt->m_oldPosition;
-				combineWith->m_newPosition = combineAttempt->m_newPosition;
+	currentMessage->m_position = messageToCombine->m_position;
+}
 
-				resetMessageFlag(i);
+// TODO: Remember. This takes away the system's "memory" of moves that are
+// made. If you want to track them and store them, make a separate tool for
+// that.
+void MessageSystem::combineMove(IMessage *pending, IMessage *message)
+{
+	MoveMessage *currentMove = static_cast<MoveMessage*>(pending);
+	MoveMessage *combineMove = static_cast<MoveMessage*>(message);
 
-				delete message;
-				message = NULL;
+	currentMove->m_oldPosition = combineMove->m_oldPosition;
+	currentMove->m_newPosition = combineMove->m_newPosition;
+}
 
-				combined = true;
+void MessageSystem::combineAnimationChange(IMessage *pending, IMessage *message)
+{
+	AnimationChangeMessage *combine = static_cast<AnimationChangeMessage*>(pending);
+	AnimationChangeMessage *animation = static_cast<AnimationChangeMessage*>(message);
 
-				break;
-			}
-		}
+	combine->m_name = animation->m_name;
+	combine->m_frame = animation->m_frame;
+	combine->m_direction = animation->m_direction;
+}
+
+void MessageSystem::combineInput(IMessage *pending, IMessage *message)
+{
+	InputMessage *second = static_cast<InputMessage*>(pending);
+	InputMessage *first = static_cast<InputMessage*>(message);
 
+	switch (first->m_inputType)
+	{
+	case InputMessage::INPUT_AXIS:
+	{
+		static_cast<InputAxisMessage*>(second)->m_axisMovement = static_cast<InputAxisMessage*>(first)->m_axisMovement;
+		break;
 	}
+	case InputMessage::INPUT_BUTTON:
+	{
+		static_cast<InputButtonMessage*>(second)->m_pressed = static_cast<InputButtonMessage*>(first)->m_pressed;
+		break;
+	}
+	case InputMessage::INPUT_MOVE:
+	{
+		InputMoveMessage *firstMove = static_cast<InputMoveMessage*>(first);
+		InputMoveMessage *secondMove = static_cast<InputMoveMessage*>(second);
+
+		secondMove->m_x = firstMove->m_x;
+		secondMove->m_y = firstMove->m_y;
+		break;
+	}
+	}
+}
 
-	return combined;
-}
\ No newline at end of file
+void MessageSystem::combineCameraMove(IMessage *pending, IMessage *message)
+{
+	CameraMoveMessage *combineWith = static_cast<CameraMoveMessage*>(pending);
+	CameraMoveMessage *combineAttempt = static_cast<CameraMoveMessage*>(message);
+
+	combineWith->m_oldPosition = combineAttempt->m_oldPosition;
+	combineWith->m_newPosition = combineAttempt->m_newPosition;
+}
@@ -7,12 +7,49 @@
 // Holds and handles messages for the game.
 //==========================================================================================
 #include "IMessage.h"
+#include "IMessageHandler.h"
+#include "MessageArena.h"
+#include "MessageStaging.h"
+#include "MessageJournal.h"
 #include <SDL.h>
 #include <vector>
+#include <string>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
 
 class MessageSystem
 {
 public:
+	static const int m_MESSAGE_TYPES = IMessage::CAMERA_MOVE + 1;
+
+	// What happened to each type of message over a frame, or over every
+	// frame so far.
+	struct Stats
+	{
+		enum Counter
+		{
+			PUSHED,
+			COALESCED,
+			DROPPED,
+			POLLED,
+			COUNTER_COUNT
+		};
+
+		// -1 for the stats of every frame
+		int m_frame;
+		int m_counts[m_MESSAGE_TYPES][COUNTER_COUNT];
+		// Messages waiting when the frame started, and the most slots that
+		// were in use during it.
+		int m_depth;
+		int m_peakDepth;
+
+		void clear(int frame);
+		int total(Counter counter) const;
+		// The part of the pushed messages that were merged into another one
+		float coalesceRatio() const;
+	};
+
 	static MessageSystem* instance()
 	{
 		static MessageSystem *instance = new MessageSystem();
@@ -22,43 +59,201 @@ public:
 
 	~MessageSystem()
 	{
+		stopReplay();
 		flushMessages();
+
+		for (unsigned int i = 0; i < m_staging.size(); i++)
+		{
+			delete m_staging[i];
+		}
 	}
 
+	// Frees the messages polled since the last call and makes everything
+	// pushed since then ready to poll. Messages pushed while a frame is
+	// being polled wait for the next one. This is also where messages from
+	// other threads are merged in, so none of them can be sending then.
+	void beginFrame();
+
+	// Handlers only get the types they subscribe to. Each type goes to its
+	// subscribers in the order they subscribed.
+	void subscribe(IMessageHandler *handler, IMessage::MessageType type);
+	void unsubscribe(IMessageHandler *handler);
+
+	// Starts a frame and hands its messages out to the subscribers, a batch
+	// for each type.
+	void dispatchMessages();
+
+	// Where every message's memory comes from
+	void* allocateMessage(size_t size);
+	void freeMessage(void *memory);
+
+	// Only the thread that made the message system can poll. Any thread
+	// can push, and pushes from the others are staged until the next frame.
 	bool pollMessage(IMessage *& message);
 	void pushMessage(IMessage *message);
 	bool peekMessage(IMessage *& message, int startingIndex);
 
-	int messageCount() { return (int)m_messages.size(); }
+	// Messages that haven't been polled yet
+	int messageCount() { return m_pendingCount; }
+
+	// Backpressure. Messages pushed while the queue is full are dropped.
+	int droppedCount() { return m_totalStats.total(Stats::DROPPED); }
+	// The most slots that have been in use at once
+	int peakCount() { return m_totalStats.m_peakDepth; }
+	// How many pushed messages were merged into one already waiting
+	int coalescedCount() { return m_totalStats.total(Stats::COALESCED); }
+
+	// Stats for every frame so far and for the frame that's going now. A
+	// frame's stats are finished by beginFrame, which keeps the last
+	// m_STATS_FRAMES of them.
+	const Stats& totalStats() { return m_totalStats; }
+	const Stats& currentStats() { return m_frameStats; }
+	int statsFrameCount() { return m_statsCount; }
+	// 0 is the last finished frame
+	bool frameStats(int framesAgo, Stats &stats);
+	// Writes the kept frames and then the totals, one line each
+	bool writeStats(std::string path);
+
+	// Recording writes every polled message to a journal, with the tick
+	// it was polled in. Messages that were dropped or combined into another
+	// one aren't written. The seed and tick rate go at the top, so a replay
+	// can start the world the same way.
+	bool startRecording(std::string path, unsigned int seed, int tickRate);
+	void stopRecording() { m_journal.close(); }
+	// The simulation tick the next messages are polled in
+	void setTick(int tick) { m_tick = tick; }
+
+	// Opens a journal to play back, and gets the seed and tick rate it was
+	// recorded with. Only the input is played back. Everything else is made
+	// again by the systems as the ticks run.
+	bool startReplay(std::string path, unsigned int &seed, int &tickRate);
+	// Queues the input that was handled in the tick. Returns false once
+	// the journal has nothing after it.
+	bool replayTick(int tick);
+	void stopReplay();
+	bool replaying() { return m_replaying; }
+
+	// Lets another thread use a thread's staging buffer once it's done
+	void releaseStaging(MessageStaging *staging);
 
 private:
-	const int m_MAX_MESSAGES = 10000;
-	int m_currentPollIndex;
-	int m_currentPeekIndex;
-	int m_currentPushIndex;
-	std::vector<IMessage*> m_messages;
-	std::vector<bool> m_messageFlag;
+	static const int m_MAX_MESSAGES = 10000;
+	// Room in front of each message for the arena it's in. Keeps the
+	// message lined up the same as the arena's memory.
+	static const size_t m_MESSAGE_HEADER_SIZE = 16;
+
+	// A ring of slots. Polled messages sit between m_polledStart and
+	// m_pollIndex until the next frame, then the pending ones run up to
+	// the end of the frame and on to the newest.
+	IMessage *m_messages[m_MAX_MESSAGES];
+	int m_polledStart;
+	int m_pollIndex;
+	int m_polledCount;
+	int m_pendingCount;
+	// How many of the pending messages can be polled this frame
+	int m_frameCount;
+
+	static const int m_STATS_FRAMES = 600;
+
+	Stats m_totalStats;
+	Stats m_frameStats;
+	// A ring of the finished frames
+	Stats m_statsHistory[m_STATS_FRAMES];
+	int m_statsNext;
+	int m_statsCount;
+
+	// What a message is combined by. Collisions are by both entities and
+	// input is by the device and the button or axis.
+	struct MessageKey
+	{
+		int m_type;
+		int m_first;
+		int m_second;
+		int m_third;
+
+		bool operator==(const MessageKey &other) const
+		{
+			return (m_type == other.m_type && m_first == other.m_first &&
+					m_second == other.m_second && m_third == other.m_third);
+		}
+	};
+
+	struct MessageKeyHash
+	{
+		size_t operator()(const MessageKey &key) const
+		{
+			size_t hash = (size_t)key.m_type;
+
+			hash = (hash * 31) + (size_t)key.m_first;
+			hash = (hash * 31) + (size_t)key.m_second;
+			hash = (hash * 31) + (size_t)key.m_third;
+
+			return hash;
+		}
+	};
+
+	// Messages pushed each frame go in the current arena. The other one
+	// holds the frame being polled, and it's reset once that's released.
+	MessageArena m_arenas[2];
+	int m_currentArena;
+
+	// Who gets each type, and the frame's messages sorted by type. The
+	// batches keep their memory between frames.
+	std::vector<IMessageHandler*> m_subscribers[m_MESSAGE_TYPES];
+	std::vector<IMessage*> m_batches[m_MESSAGE_TYPES];
+
+	// A staging buffer for each thread that has sent messages, besides the
+	// one polling. Buffers from threads that ended are reused.
+	std::vector<MessageStaging*> m_staging;
+	std::vector<MessageStaging*> m_freeStaging;
+	std::vector<IMessage*> m_merging;
+	std::mutex m_stagingMutex;
+	std::thread::id m_pollingThread;
+
+	MessageJournal m_journal;
+	int m_tick;
+
+	MessageJournal m_replayJournal;
+	bool m_replaying;
+	// The next message in the replay and the tick it belongs to. NULL once
+	// the journal runs out.
+	IMessage *m_replayNext;
+	int m_replayNextTick;
+
+	// The slot of each pending message that can be combined with
+	std::unordered_map<MessageKey, int, MessageKeyHash> m_pendingIndex;
 
 	MessageSystem()
-		:m_currentPeekIndex(0), m_currentPollIndex(0), m_currentPushIndex(0)
+		:m_polledStart(0), m_pollIndex(0), m_polledCount(0), m_pendingCount(0), m_frameCount(0),
+		m_statsNext(0), m_statsCount(0), m_currentArena(0),
+		m_pollingThread(std::this_thread::get_id()), m_tick(0), m_replaying(false),
+		m_replayNext(NULL), m_replayNextTick(0)
 	{
+		m_totalStats.clear(-1);
+		m_frameStats.clear(0);
 	}
 
 	void flushMessages();
+	void releasePolled();
+	void queueMessage(IMessage *message);
+	MessageStaging* stagingBuffer();
+	void mergeStaged();
+	void countMessage(IMessage *message, Stats::Counter counter);
+	void countDepth(int depth);
+	void finishFrameStats();
 	bool combineMessage(IMessage *message);
-	int getNextUnprocessedMessage();
-	int getFirstProcessedMessage();
+	bool messageKey(IMessage *message, MessageKey &key);
+	void indexMessage(IMessage *message, int slot);
+	void unindexMessage(IMessage *message);
 
-	void resetMessageFlag(int index);
+	// Gets the slot of the pending message that many after the next one
+	int pendingSlot(int offset) { return (m_pollIndex + offset) % m_MAX_MESSAGES; }
 
 	// Message combining functions
-	bool combineCollision(IMessage *message);
-	bool combineMove(IMessage *message);
-	bool combineVelIncrease(IMessage *message);
-	bool combineAnimationChange(IMessage *message);
-	bool combineEntityDestroy(IMessage *message);
-	bool combineInput(IMessage *message);
-	bool combineCameraMove(IMessage *message);
+	void combineCollision(IMessage *pending, IMessage *message);
+	void combineMove(IMessage *pending, IMessage *message);
+	void combineAnimationChange(IMessage *pending, IMessage *message);
+	void combineInput(IMessage *pending, IMessage *message);
+	void combineCameraMove(IMessage *pending, IMessage *message);
 //	bool combinePhysic(SystemMessage &message);
 };
-
@@ -0,0 +1,331 @@
+#include "NarrowPhase.h"
+#include "Rectangle.h"
+#include "Circle.h"
+#include "AABB.h"
+#include "FixedPoint.h"
+
+// SSE2 is always there on x64, and on x86 when the compiler is told to use it
+#if defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP) || defined(__SSE2__)
+#define NARROW_PHASE_SSE
+#include <emmintrin.h>
+#endif
+
+NarrowPhaseBatch::NarrowPhaseBatch()
+	:m_fixedPoint(false)
+{
+}
+
+NarrowPhaseBatch::~NarrowPhaseBatch()
+{
+}
+
+//=============================================================================
+// Function: void clear()
+// Description:
+// Throws out every queued pair. The storage is kept for the next batch.
+//=============================================================================
+void NarrowPhaseBatch::clear()
+{
+	m_boxes.m_aMinX.clear(); m_boxes.m_aMinY.clear();
+	m_boxes.m_aMaxX.clear(); m_boxes.m_aMaxY.clear();
+	m_boxes.m_bMinX.clear(); m_boxes.m_bMinY.clear();
+	m_boxes.m_bMaxX.clear(); m_boxes.m_bMaxY.clear();
+	m_boxes.m_pair.clear();
+
+	m_circles.m_aX.clear(); m_circles.m_aY.clear();
+	m_circles.m_bX.clear(); m_circles.m_bY.clear();
+	m_circles.m_radiusSum.clear();
+	m_circles.m_pair.clear();
+
+	m_circleBoxes.m_x.clear(); m_circleBoxes.m_y.clear();
+	m_circleBoxes.m_radius.clear();
+	m_circleBoxes.m_minX.clear(); m_circleBoxes.m_minY.clear();
+	m_circleBoxes.m_maxX.clear(); m_circleBoxes.m_maxY.clear();
+	m_circleBoxes.m_pair.clear();
+
+	m_rotated.clear();
+	m_fixed.clear();
+	m_results.clear();
+}
+
+//=============================================================================
+// Function: int addPair(IShape*, IShape*)
+// Description:
+// Sorts the pair into the list for its kind of shapes.
+// Parameters:
+// IShape *a - The first shape.
+// IShape *b - The second shape.
+// Output:
+// int - The index of the pair's result.
+//=============================================================================
+int NarrowPhaseBatch::addPair(Shape::IShape *a, Shape::IShape *b)
+{
+	int pair = (int)m_results.size();
+
+	m_results.push_back(0);
+
+	if (!a || !b)
+	{
+		return pair;
+	}
+
+	Shape::ShapeType typeA = a->type();
+	Shape::ShapeType typeB = b->type();
+
+	bool turned = ((typeA == Shape::RECTANGLE && a->rotation() != 0.0f) ||
+				   (typeB == Shape::RECTANGLE && b->rotation() != 0.0f));
+
+	if (m_fixedPoint && !turned)
+	{
+		ShapePair fixed{ a, b, pair };
+
+		m_fixed.push_back(fixed);
+	}
+	else if (typeA == Shape::RECTANGLE && typeB == Shape::RECTANGLE)
+	{
+		if (a->rotation() == 0.0f && b->rotation() == 0.0f)
+		{
+			AABB boxA = shapeBounds(a);
+			AABB boxB = shapeBounds(b);
+
+			m_boxes.m_aMinX.push_back(boxA.minX); m_boxes.m_aMinY.push_back(boxA.minY);
+			m_boxes.m_aMaxX.push_back(boxA.maxX); m_boxes.m_aMaxY.push_back(boxA.maxY);
+			m_boxes.m_bMinX.push_back(boxB.minX); m_boxes.m_bMinY.push_back(boxB.minY);
+			m_boxes.m_bMaxX.push_back(boxB.maxX); m_boxes.m_bMaxY.push_back(boxB.maxY);
+			m_boxes.m_pair.push_back(pair);
+		}
+		else
+		{
+			ShapePair rotated{ a, b, pair };
+
+			m_rotated.push_back(rotated);
+		}
+	}
+	else if (typeA == Shape::CIRCLE && typeB == Shape::CIRCLE)
+	{
+		Shape::Circle *circleA = static_cast<Shape::Circle*>(a);
+		Shape::Circle *circleB = static_cast<Shape::Circle*>(b);
+
+		m_circles.m_aX.push_back(circleA->center().getX());
+		m_circles.m_aY.push_back(circleA->center().getY());
+		m_circles.m_bX.push_back(circleB->center().getX());
+		m_circles.m_bY.push_back(circleB->center().getY());
+		m_circles.m_radiusSum.push_back((float)(circleA->radius() + circleB->radius()));
+		m_circles.m_pair.push_back(pair);
+	}
+	else if (typeA == Shape::CIRCLE && typeB == Shape::RECTANGLE)
+	{
+		addCircleBox(a, b, pair);
+	}
+	else if (typeA == Shape::RECTANGLE && typeB == Shape::CIRCLE)
+	{
+		addCircleBox(b, a, pair);
+	}
+
+	return pair;
+}
+
+//=============================================================================
+// Function: void run()
+// Description:
+// Tests every queued pair and stores the results.
+//=============================================================================
+void NarrowPhaseBatch::run()
+{
+	testBoxes();
+	testCircles();
+	testCircleBoxes();
+	testRotated();
+	testFixed();
+}
+
+void NarrowPhaseBatch::addCircleBox(Shape::IShape *circle, Shape::IShape *rect, int pair)
+{
+	Shape::Circle *c = static_cast<Shape::Circle*>(circle);
+	Shape::Rectangle *r = static_cast<Shape::Rectangle*>(rect);
+
+	// Turn the circle into the rectangle's space, centered on the rectangle
+	Vector2D center = r->toLocal(c->center());
+
+	float halfWidth = (float)r->width() * 0.5f;
+	float halfHeight = (float)r->height() * 0.5f;
+
+	m_circleBoxes.m_x.push_back(center.getX());
+	m_circleBoxes.m_y.push_back(center.getY());
+	m_circleBoxes.m_radius.push_back((float)c->radius());
+	m_circleBoxes.m_minX.push_back(-halfWidth);
+	m_circleBoxes.m_minY.push_back(-halfHeight);
+	m_circleBoxes.m_maxX.push_back(halfWidth);
+	m_circleBoxes.m_maxY.push_back(halfHeight);
+	m_circleBoxes.m_pair.push_back(pair);
+}
+
+// Boxes overlap when they're apart on neither axis. Touching edges don't count.
+void NarrowPhaseBatch::testBoxes()
+{
+	int count = (int)m_boxes.m_pair.size();
+	int i = 0;
+
+#ifdef NARROW_PHASE_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 aMinX = _mm_loadu_ps(&m_boxes.m_aMinX[i]);
+		__m128 aMinY = _mm_loadu_ps(&m_boxes.m_aMinY[i]);
+		__m128 aMaxX = _mm_loadu_ps(&m_boxes.m_aMaxX[i]);
+		__m128 aMaxY = _mm_loadu_ps(&m_boxes.m_aMaxY[i]);
+		__m128 bMinX = _mm_loadu_ps(&m_boxes.m_bMinX[i]);
+		__m128 bMinY = _mm_loadu_ps(&m_boxes.m_bMinY[i]);
+		__m128 bMaxX = _mm_loadu_ps(&m_boxes.m_bMaxX[i]);
+		__m128 bMaxY = _mm_loadu_ps(&m_boxes.m_bMaxY[i]);
+
+		__m128 overlapX = _mm_and_ps(_mm_cmplt_ps(aMinX, bMaxX), _mm_cmplt_ps(bMinX, aMaxX));
+		__m128 overlapY = _mm_and_ps(_mm_cmplt_ps(aMinY, bMaxY), _mm_cmplt_ps(bMinY, aMaxY));
+
+		int mask = _mm_movemask_ps(_mm_and_ps(overlapX, overlapY));
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			m_results[m_boxes.m_pair[i + lane]] = (unsigned char)((mask >> lane) & 1);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		bool overlap = (m_boxes.m_aMinX[i] < m_boxes.m_bMaxX[i] && m_boxes.m_bMinX[i] < m_boxes.m_aMaxX[i] &&
+						m_boxes.m_aMinY[i] < m_boxes.m_bMaxY[i] && m_boxes.m_bMinY[i] < m_boxes.m_aMaxY[i]);
+
+		m_results[m_boxes.m_pair[i]] = (unsigned char)overlap;
+	}
+}
+
+// Circles overlap when their centers are closer than their radii put together.
+void NarrowPhaseBatch::testCircles()
+{
+	int count = (int)m_circles.m_pair.size();
+	int i = 0;
+
+#ifdef NARROW_PHASE_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&m_circles.m_bX[i]), _mm_loadu_ps(&m_circles.m_aX[i]));
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&m_circles.m_bY[i]), _mm_loadu_ps(&m_circles.m_aY[i]));
+		__m128 radiusSum = _mm_loadu_ps(&m_circles.m_radiusSum[i]);
+
+		__m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+		int mask = _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_mul_ps(radiusSum, radiusSum)));
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			m_results[m_circles.m_pair[i + lane]] = (unsigned char)((mask >> lane) & 1);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		float dx = m_circles.m_bX[i] - m_circles.m_aX[i];
+		float dy = m_circles.m_bY[i] - m_circles.m_aY[i];
+		float radiusSum = m_circles.m_radiusSum[i];
+
+		m_results[m_circles.m_pair[i]] = (unsigned char)((dx * dx) + (dy * dy) < radiusSum * radiusSum);
+	}
+}
+
+// A circle touches a box when the closest point in the box is inside the circle.
+void NarrowPhaseBatch::testCircleBoxes()
+{
+	int count = (int)m_circleBoxes.m_pair.size();
+	int i = 0;
+
+#ifdef NARROW_PHASE_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&m_circleBoxes.m_x[i]);
+		__m128 y = _mm_loadu_ps(&m_circleBoxes.m_y[i]);
+		__m128 radius = _mm_loadu_ps(&m_circleBoxes.m_radius[i]);
+
+		__m128 closestX = _mm_min_ps(_mm_max_ps(x, _mm_loadu_ps(&m_circleBoxes.m_minX[i])), _mm_loadu_ps(&m_circleBoxes.m_maxX[i]));
+		__m128 closestY = _mm_min_ps(_mm_max_ps(y, _mm_loadu_ps(&m_circleBoxes.m_minY[i])), _mm_loadu_ps(&m_circleBoxes.m_maxY[i]));
+
+		__m128 dx = _mm_sub_ps(x, closestX);
+		__m128 dy = _mm_sub_ps(y, closestY);
+
+		__m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(radius, radius)));
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			m_results[m_circleBoxes.m_pair[i + lane]] = (unsigned char)((mask >> lane) & 1);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		float x = m_circleBoxes.m_x[i];
+		float y = m_circleBoxes.m_y[i];
+		float radius = m_circleBoxes.m_radius[i];
+
+		float closestX = x;
+		float closestY = y;
+
+		if (closestX < m_circleBoxes.m_minX[i]) { closestX = m_circleBoxes.m_minX[i]; }
+		if (m_circleBoxes.m_maxX[i] < closestX) { closestX = m_circleBoxes.m_maxX[i]; }
+		if (closestY < m_circleBoxes.m_minY[i]) { closestY = m_circleBoxes.m_minY[i]; }
+		if (m_circleBoxes.m_maxY[i] < closestY) { closestY = m_circleBoxes.m_maxY[i]; }
+
+		float dx = x - closestX;
+		float dy = y - closestY;
+
+		m_results[m_circleBoxes.m_pair[i]] = (unsigned char)((dx * dx) + (dy * dy) <= radius * radius);
+	}
+}
+
+void NarrowPhaseBatch::testRotated()
+{
+	for (unsigned int i = 0; i < m_rotated.size(); i++)
+	{
+		m_results[m_rotated[i].m_pair] = (unsigned char)rotatedRectsOverlap(m_rotated[i].m_a, m_rotated[i].m_b);
+	}
+}
+
+void NarrowPhaseBatch::testFixed()
+{
+	for (unsigned int i = 0; i < m_fixed.size(); i++)
+	{
+		m_results[m_fixed[i].m_pair] = (unsigned char)fixedShapesOverlap(m_fixed[i].m_a, m_fixed[i].m_b);
+	}
+}
+
+// Checks two rectangles with the separating axis test. If the rectangles
+// are apart along either one's width or height direction, they can't be
+// touching. Each rectangle keeps its own directions, so no trig is needed.
+bool rotatedRectsOverlap(Shape::IShape *a, Shape::IShape *b)
+{
+	const int AXES = 4;
+
+	Shape::Rectangle *rectA = static_cast<Shape::Rectangle*>(a);
+	Shape::Rectangle *rectB = static_cast<Shape::Rectangle*>(b);
+
+	Vector2D axes[AXES]{ rectA->axis(0), rectA->axis(1), rectB->axis(0), rectB->axis(1) };
+
+	bool overlap = true;
+
+	for (int i = 0; i < AXES && overlap; i++)
+	{
+		float minimumA, maximumA, minimumB, maximumB;
+
+		rectA->project(axes[i], minimumA, maximumA);
+		rectB->project(axes[i], minimumB, maximumB);
+
+		if (maximumA <= minimumB || maximumB <= minimumA)
+		{
+			overlap = false;
+		}
+	}
+
+	return overlap;
+}
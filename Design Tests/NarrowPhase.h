@@ -0,0 +1,93 @@
+#pragma once
+//==========================================================================================
+// File Name: NarrowPhase.h
+// Author: Brian Blackmon
+// Date Created: 9/6/2019
+// Purpose: 
+// Batched shape overlap tests. Pairs are sorted by what kind of shapes they
+// are into flat arrays, then each kind is tested four pairs at a time with
+// SSE. Axis aligned rectangles, which covers every tile, only need a box
+// test. Two rotated rectangles are checked one at a time with the
+// separating axis test. In fixed point mode, everything but turned
+// rectangles is tested with integer math instead.
+//==========================================================================================
+#include <vector>
+#include "IShape.h"
+
+class NarrowPhaseBatch
+{
+public:
+	NarrowPhaseBatch();
+	~NarrowPhaseBatch();
+
+	void clear();
+
+	// Queues up a pair and returns the index to read its result with
+	int addPair(Shape::IShape *a, Shape::IShape *b);
+
+	// Tests every queued pair
+	void run();
+
+	// Only changes where pairs queued after it go
+	void setFixedPoint(bool fixedPoint) { m_fixedPoint = fixedPoint; }
+
+	bool result(int index) { return m_results[index] != 0; }
+	int size() { return (int)m_results.size(); }
+
+private:
+	// Axis aligned box against axis aligned box
+	struct BoxLanes
+	{
+		std::vector<float> m_aMinX, m_aMinY, m_aMaxX, m_aMaxY;
+		std::vector<float> m_bMinX, m_bMinY, m_bMaxX, m_bMaxY;
+		std::vector<int> m_pair;
+	};
+
+	// Circle against circle
+	struct CircleLanes
+	{
+		std::vector<float> m_aX, m_aY;
+		std::vector<float> m_bX, m_bY;
+		std::vector<float> m_radiusSum;
+		std::vector<int> m_pair;
+	};
+
+	// Circle against a box. Rotated rectangles have the circle turned
+	// into the rectangle's space first, so the box is always axis aligned.
+	struct CircleBoxLanes
+	{
+		std::vector<float> m_x, m_y, m_radius;
+		std::vector<float> m_minX, m_minY, m_maxX, m_maxY;
+		std::vector<int> m_pair;
+	};
+
+	// Shapes that are tested one pair at a time
+	struct ShapePair
+	{
+		Shape::IShape *m_a;
+		Shape::IShape *m_b;
+		int m_pair;
+	};
+
+	BoxLanes m_boxes;
+	CircleLanes m_circles;
+	CircleBoxLanes m_circleBoxes;
+	// Rotated rectangles that need the separating axis test
+	std::vector<ShapePair> m_rotated;
+	// Pairs tested with the fixed point kernels
+	std::vector<ShapePair> m_fixed;
+
+	bool m_fixedPoint;
+
+	std::vector<unsigned char> m_results;
+
+	void addCircleBox(Shape::IShape *circle, Shape::IShape *rect, int pair);
+
+	void testBoxes();
+	void testCircles();
+	void testCircleBoxes();
+	void testRotated();
+	void testFixed();
+};
+
+bool rotatedRectsOverlap(Shape::IShape *a, Shape::IShape *b);
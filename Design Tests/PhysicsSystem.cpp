@@ -4,6 +4,7 @@
 #include "EntityDestroyMessage.h"
 #include "IShape.h"
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 
 PhysicsSystem::~PhysicsSystem()
@@ -20,8 +21,15 @@ PhysicsSystem::~PhysicsSystem()
 //=============================================================================
 void PhysicsSystem::update(float delta)
 {
+	buildBroadPhase(delta);
+
 	// Try velocity
 	applyVelocity(delta);
+
+	m_collisionSystem->endBroadPhase();
+
+	// Logic reads these next tick instead of digging through the messages
+	m_collisionSystem->publishContacts();
 }
 
 //=============================================================================
@@ -61,42 +69,60 @@ CollisionComponent* PhysicsSystem::getCollisionComponent(int ID)
 }
 
 //=============================================================================
-// Function: VelocityComponent* getVelocityComponent(int)
+// Function: void addVelocity(int)
 // Description:
-// Gets the velocity component for the ID. If one isn't found, it creates it.
+// Gives the entity a velocity of 0. Does nothing if it already has one.
 // Parameters:
-// int ID - The id of the velocity component to get.
-// Output:
-// Returns a pointer to the velocity component on success.
-// Returns NULL on failure.
+// int ID - The entity to give a velocity.
 //=============================================================================
-VelocityComponent* PhysicsSystem::getVelocityComponent(int ID)
+void PhysicsSystem::addVelocity(int ID)
 {
-	VelocityComponent *component = NULL;
+	m_velocities.add(ID);
+}
 
-	auto mit = m_velocityComponents.find(ID);
+//=============================================================================
+// Function: Vector2D velocity(int)
+// Description:
+// Gets the entity's velocity.
+// Parameters:
+// int ID - The entity to get the velocity of.
+// Output:
+// Vector2D - The velocity. Entities without one aren't moving.
+//=============================================================================
+Vector2D PhysicsSystem::velocity(int ID)
+{
+	int index = m_velocities.indexOf(ID);
 
-	// If the component doesn't exist, create it
-	if(mit == m_velocityComponents.end())
+	if (index < 0)
 	{
-		std::cout << "Made a new velocity component!\n";
-		component = new VelocityComponent();
+		return Vector2D(0.0f, 0.0f);
+	}
 
-		component->setHorizonalSpeed(0);
-		component->setVerticalSpeed(0);
+	return m_velocities.velocity(index);
+}
 
-		m_velocityComponents.insert(std::make_pair(ID, component));
-	}
-	// Otherwise set the component to the existing component
-	else
+//=============================================================================
+// Function: void setVelocity(int, Vector2D)
+// Description:
+// Sets the entity's velocity, giving it one if it doesn't have one yet.
+// The entity is woken up so it starts moving.
+// Parameters:
+// int ID - The entity to set the velocity of.
+// Vector2D velocity - The new velocity.
+//=============================================================================
+void PhysicsSystem::setVelocity(int ID, Vector2D velocity)
+{
+	m_velocities.add(ID);
+	m_velocities.wake(ID);
+
+	int index = m_velocities.indexOf(ID);
+
+	if (0 <= index)
 	{
-		component = mit->second;
+		m_velocities.setVelocity(index, velocity);
 	}
-
-	return component;
 }
 
-
 //=============================================================================
 // Function: void processMessage(IMessage*)
 // Description:
@@ -113,16 +139,19 @@ void PhysicsSystem::processMessage(IMessage *message)
 	case IMessage::VELOCITY_INCREASE:
 	{
 		VelocityIncreaseMessage *velMessage = static_cast<VelocityIncreaseMessage*>(message);
-		VelocityComponent *vel = getVelocityComponent(velMessage->m_entityID);
+		m_velocities.add(velMessage->m_entityID);
+		m_velocities.wake(velMessage->m_entityID);
+
+		int vel = m_velocities.indexOf(velMessage->m_entityID);
 
-		if(vel)
+		if(0 <= vel)
 		{
 			float xMax = abs(velMessage->m_xMaxSpeed);
 			float yMax = abs(velMessage->m_yMaxSpeed);
 			float xIncrease = velMessage->m_xIncrease;
 			float yIncrease = velMessage->m_yIncrease;
-			float xSpeed = vel->xSpeed();
-			float ySpeed = vel->ySpeed();
+			float xSpeed = m_velocities.velocity(vel).getX();
+			float ySpeed = m_velocities.velocity(vel).getY();
 
 			float xChange = xSpeed + xIncrease;
 			float yChange = ySpeed + yIncrease;
@@ -131,7 +160,7 @@ void PhysicsSystem::processMessage(IMessage *message)
 			{
 				if(abs(xChange) < xMax)
 				{
-					vel->increaseHorizontalSpeed(xIncrease);
+					m_velocities.increaseVelocity(vel, xIncrease, 0.0f);
 				}
 				else
 				{
@@ -147,7 +176,7 @@ void PhysicsSystem::processMessage(IMessage *message)
 						tempX -= xDiff;
 					}
 
-					vel->increaseHorizontalSpeed(tempX);
+					m_velocities.increaseVelocity(vel, tempX, 0.0f);
 				}
 			}
 
@@ -155,7 +184,7 @@ void PhysicsSystem::processMessage(IMessage *message)
 			{
 				if(abs(yChange) < yMax)
 				{
-					vel->increaseVerticalSpeed(yIncrease);
+					m_velocities.increaseVelocity(vel, 0.0f, yIncrease);
 				}
 				else
 				{
@@ -171,18 +200,28 @@ void PhysicsSystem::processMessage(IMessage *message)
 						tempY -= yDiff;
 					}
 
-					vel->increaseVerticalSpeed(tempY);
+					m_velocities.increaseVelocity(vel, 0.0f, tempY);
 				}
 			}
 		}
 		
 		break;
 	}
+	case IMessage::MOVE:
+	{
+		// Something else may have moved the body somewhere it needs to
+		// react to.
+		MoveMessage *move = static_cast<MoveMessage*>(message);
+
+		m_velocities.wake(move->m_entityID);
+
+		break;
+	}
 	case IMessage::ENTITY_DESTROY:
 	{
 		EntityDestroyMessage *destroy = static_cast<EntityDestroyMessage*>(message);
 
-		removeVelocityComponent(destroy->m_entityID);
+		m_velocities.remove(destroy->m_entityID);
 
 		break;
 	}
@@ -190,21 +229,63 @@ void PhysicsSystem::processMessage(IMessage *message)
 }
 
 //=============================================================================
-// Function: void initCollisionSystem(int, int, int, int, int)
+// Function: void initCollisionSystem(int, int, int, int, int, BroadPhaseType)
 // Description:
-// Initializes the collision system and sets up the collision grid.
+// Initializes the collision system and sets up its broad phase.
 // Parameters:
 // int gridX - The starting x of the grid.
 // int gridY - The starting y of the grid.
 // int width - The width of the grid.
 // int height - The height of the grid.
 // int cellSize - The size of the grid cells.
+// BroadPhaseType broadPhase - Whether to use the grid or the AABB tree.
 //=============================================================================
-void PhysicsSystem::initCollisionSystem(int gridX, int gridY, int width, int height, int cellSize)
+void PhysicsSystem::initCollisionSystem(int gridX, int gridY, int width, int height, int cellSize,
+	BroadPhase::BroadPhaseType broadPhase)
 {
 	if(!m_collisionSystem)
 	{
-		m_collisionSystem = new CollisionSystem(gridX, gridY, width, height, cellSize);
+		m_collisionSystem = new CollisionSystem(gridX, gridY, width, height, cellSize, broadPhase);
+	}
+
+	if (!m_workers)
+	{
+		setWorkerCount(WorkerPool::defaultWorkerCount());
+	}
+}
+
+//=============================================================================
+// Function: void setWorkerCount(int)
+// Description:
+// Replaces the threads that help move bodies. The results are the same no
+// matter how many there are.
+// Parameters:
+// int workerCount - How many threads to use besides the main one.
+//=============================================================================
+void PhysicsSystem::setWorkerCount(int workerCount)
+{
+	if (workerCount < 0)
+	{
+		workerCount = 0;
+	}
+
+	delete m_workers;
+	m_workers = new WorkerPool(workerCount);
+}
+
+//=============================================================================
+// Function: void setFixedPoint(bool)
+// Description:
+// Switches between moving bodies with floats and with Q16.16 fixed point
+// numbers. The collision system has to be made first.
+// Parameters:
+// bool fixedPoint - Whether to use fixed point math.
+//=============================================================================
+void PhysicsSystem::setFixedPoint(bool fixedPoint)
+{
+	if (m_collisionSystem)
+	{
+		m_collisionSystem->setFixedPoint(fixedPoint);
 	}
 }
 
@@ -225,37 +306,40 @@ bool PhysicsSystem::hasLineOfSight(int entityID, int otherEntityID)
 }
 
 //=============================================================================
-// Function: void sendMoveMessage(int, Vector2D, Vector2D)
+// Function: void hasLineOfSight(std::vector<SightQuery>&)
 // Description:
-// Sends a message to the message system, with information about a move that was
-// made.
+// Checks line of sight for a list of entity pairs in one pass.
 // Parameters:
-// int entityID - The ID that was moved.
-// Vector2D oldPosition - The position it was moved from.
-// Vector2D newPosition - The position it was moved to.
+// std::vector<SightQuery> &queries - The pairs to check. Each one's
+// m_hasSight is filled in.
 //=============================================================================
-void PhysicsSystem::sendMoveMessage(int entityID, Vector2D oldPosition, Vector2D newPosition)
+void PhysicsSystem::hasLineOfSight(std::vector<SightQuery> &queries)
 {
-	MoveMessage *message = new MoveMessage(entityID, oldPosition, newPosition);
-
-	MessageSystem::instance()->pushMessage(message);
+	m_collisionSystem->hasLineOfSight(queries);
 }
 
 //=============================================================================
-// Function: void removeVelocityComponent(int)
+// Function: void sendMoveMessage(int, Vector2D, Vector2D, CollisionWorkspace&)
 // Description:
-// Finds and deletes the velocity component associated with the ID.
+// Sends a message to the message system, with information about a move that was
+// made. A deferred workspace holds on to it instead.
 // Parameters:
-// int entityID - The ID of the velocity component to delete.
+// int entityID - The ID that was moved.
+// Vector2D oldPosition - The position it was moved from.
+// Vector2D newPosition - The position it was moved to.
+// CollisionWorkspace &workspace - The workspace the move was made in.
 //=============================================================================
-void PhysicsSystem::removeVelocityComponent(int entityID)
+void PhysicsSystem::sendMoveMessage(int entityID, Vector2D oldPosition, Vector2D newPosition, CollisionWorkspace &workspace)
 {
-	auto mit = m_velocityComponents.find(entityID);
+	if (workspace.m_deferred)
+	{
+		DeferredMessage deferred{ IMessage::MOVE, entityID, -1, oldPosition, newPosition };
 
-	if(mit != m_velocityComponents.end())
+		workspace.m_messages.push_back(deferred);
+	}
+	else
 	{
-		delete mit->second;
-		mit = m_velocityComponents.erase(mit);
+		MessageSystem::instance()->pushMessage(new MoveMessage(entityID, oldPosition, newPosition));
 	}
 }
 
@@ -266,163 +350,421 @@ void PhysicsSystem::removeVelocityComponent(int entityID)
 //=============================================================================
 void PhysicsSystem::cleanUp()
 {
+	delete m_workers;
+	m_workers = NULL;
+
 	delete m_collisionSystem;
+	m_collisionSystem = NULL;
 
-	auto velMit = m_velocityComponents.begin();
+	m_velocities.clear();
 
-	while (velMit != m_velocityComponents.end())
+	for (unsigned int i = 0; i < m_groups.size(); i++)
 	{
-		delete velMit->second;
-		velMit->second = NULL;
+		delete m_groups[i];
+	}
 
-		velMit = m_velocityComponents.erase(velMit);
+	m_groups.clear();
+}
 
-		if (velMit != m_velocityComponents.end())
+//=============================================================================
+// Function: void buildBroadPhase(float)
+// Description:
+// Registers every entity that's moving this frame with the collision
+// system, then has it find all of the possible collision pairs at once.
+// Parameters:
+// float delta - The time passed since the last update.
+//=============================================================================
+void PhysicsSystem::buildBroadPhase(float delta)
+{
+	m_collisionSystem->beginBroadPhase();
+
+	for (int i = 0; i < m_velocities.awakeCount(); i++)
+	{
+		if (m_velocities.moving(i))
 		{
-			velMit++;
+			m_collisionSystem->addSweptBody(m_velocities.entityID(i), m_velocities.velocity(i) * delta);
 		}
 	}
+
+	m_collisionSystem->buildCandidatePairs();
 }
 
 //=============================================================================
 // Function: void applyVelocity(float delta);
 // Description:
-// Applies the velocity of each velocity component to its corresponding
-// collision component.
+// Moves every awake entity by its velocity, then slows them all down.
+// Entities that have been still for long enough are put to sleep and
+// skipped until something wakes them.
+// Movers are split up by which strip of the world they stay inside of.
+// Strips can't touch anything the other strips move, so they're moved at
+// the same time and their results are put together in strip order. Movers
+// that cross into another strip are moved after that, one at a time.
 // Parameters:
 // float delta - The time passed since the last update.
 //=============================================================================
 void PhysicsSystem::applyVelocity(float delta)
 {
-	// Cycle through the velocity components and apply them to their corresponding 
-	// collision objects.
+	partitionMovers(delta);
 
-	auto mit = m_velocityComponents.begin();
+	if (m_workers && m_MIN_PARALLEL_MOVERS <= (int)m_stripMovers.size())
+	{
+		m_workers->run(m_groupCount, [this, delta](int group)
+		{
+			moveGroup(*m_groups[group], delta);
+		});
+	}
+	else
+	{
+		for (int i = 0; i < m_groupCount; i++)
+		{
+			moveGroup(*m_groups[i], delta);
+		}
+	}
 
-	while(mit != m_velocityComponents.end())
+	for (int i = 0; i < m_groupCount; i++)
 	{
-		VelocityComponent *vel = mit->second;
-		int velID = mit->first;
+		finishGroup(*m_groups[i]);
+	}
+
+	moveGroup(m_crossers, delta);
+	finishGroup(m_crossers);
 
-		if (vel)
+	applyFriction(delta);
+
+	m_velocities.sleepStill(m_SLEEP_TICKS);
+}
+
+//=============================================================================
+// Function: void partitionMovers(float)
+// Description:
+// Puts every awake mover in the group for the strip its swept box stays
+// inside of, or with the crossers if it reaches over a strip's edge. The
+// groups come out in strip order, and each keeps the movers in the same
+// order they're stored in.
+// Parameters:
+// float delta - The time passed since the last update.
+//=============================================================================
+void PhysicsSystem::partitionMovers(float delta)
+{
+	m_stripMovers.clear();
+	m_crossers.m_movers.clear();
+	m_crossers.m_workspace.m_deferred = false;
+
+	for (int i = 0; i < m_velocities.awakeCount(); i++)
+	{
+		if (m_velocities.moving(i))
 		{
-			if (vel->xSpeed() != 0 || vel->ySpeed() != 0)
+			int velID = m_velocities.entityID(i);
+
+			CollisionComponent *component = m_collisionSystem->getCollisionComponent(velID);
+
+			if (component)
 			{
-				Vector2D start{ 0, 0 };
-				Vector2D end{ 0, 0 };
+				AABB start = shapeBounds(component->shape());
+				AABB end = translateBounds(start, m_velocities.velocity(i) * delta);
+				AABB reach = expandBounds(combineBounds(start, end), m_STRIP_HALO);
 
-				CollisionComponent *component = m_collisionSystem->getCollisionComponent(velID);
-		
-				if (component)
-				{
-					vel->setCurrentVel(vel->velocity());
-					start = component->center();
-					end = start + (vel->currentVel() * delta);
+				int strip = (int)floor(reach.minX / m_STRIP_WIDTH);
 
-					float endX = end.getX();
-					float endY = end.getY();
+				if (strip == (int)floor(reach.maxX / m_STRIP_WIDTH))
+				{
+					StripMover mover{ strip, velID };
 
-					Line line{ start, end };
+					m_stripMovers.push_back(mover);
+				}
+				else
+				{
+					m_crossers.m_movers.push_back(velID);
+				}
+			}
+		}
+	}
 
-					// Move the component
-					if (!m_collisionSystem->collisionOnLine(mit->first, line))
-					{
-						m_collisionSystem->updatePosition(mit->first, endX, endY);
-
-						bool moved = false;
-
-						// If we're colliding at the new location
-						if (m_collisionSystem->isColliding(mit->first) == true)
-						{
-							m_collisionSystem->updatePosition(mit->first, start.getX(), end.getY());
-
-							if (m_collisionSystem->isColliding(mit->first))
-							{
-								m_collisionSystem->updatePosition(mit->first, end.getX(), start.getY());
-
-								if (m_collisionSystem->isColliding(mit->first))
-								{
-									m_collisionSystem->updatePosition(mit->first, start.getX(), start.getY());
-								}
-								else
-								{
-									moved = true;
-									sendMoveMessage(mit->first, start, Vector2D(end.getX(), start.getY()));
-								}
-							}
-							else
-							{
-								moved = true;
-								sendMoveMessage(mit->first, start, Vector2D(start.getX(), end.getY()));
-							}
-						}
-						else
-						{
-							sendMoveMessage(mit->first, start, end);
-						}
-					}
+	std::stable_sort(m_stripMovers.begin(), m_stripMovers.end(), [](const StripMover &a, const StripMover &b)
+	{
+		return a.m_strip < b.m_strip;
+	});
 
-					applyFriction(mit->first, delta);
+	m_groupCount = 0;
 
-				}
+	for (unsigned int i = 0; i < m_stripMovers.size(); i++)
+	{
+		if (i == 0 || m_stripMovers[i].m_strip != m_stripMovers[i - 1].m_strip)
+		{
+			if ((int)m_groups.size() <= m_groupCount)
+			{
+				m_groups.push_back(new MoverGroup());
 			}
+
+			m_groups[m_groupCount]->m_movers.clear();
+			m_groups[m_groupCount]->m_workspace.m_deferred = true;
+			m_groupCount++;
 		}
 
-		mit++;
+		m_groups[m_groupCount - 1]->m_movers.push_back(m_stripMovers[i].m_entityID);
 	}
 }
 
 //=============================================================================
-// Function: void applyFriction(int, float)
+// Function: void moveGroup(MoverGroup&, float)
 // Description:
-// Applies friction to the velocity.
-// TODO: Make it only apply friction to objects opted into friction thx.
+// Moves each mover in the group and checks what it ended up touching.
+// Everything it changes besides the movers' shapes goes in the group.
 // Parameters:
-// int entityID - The entity to apply friction for.
-// float delta - The time since the last update.
+// MoverGroup &group - The movers to move.
+// float delta - The time passed since the last update.
 //=============================================================================
-void PhysicsSystem::applyFriction(int entityID, float delta)
+void PhysicsSystem::moveGroup(MoverGroup &group, float delta)
 {
-	VelocityComponent *vel = getVelocityComponent(entityID);
+	for (unsigned int i = 0; i < group.m_movers.size(); i++)
+	{
+		int velID = group.m_movers[i];
 
-	float friction = 10.0f;
+		CollisionComponent *component = m_collisionSystem->getCollisionComponent(velID);
 
-	float xSpeed = vel->xSpeed();
-	float ySpeed = vel->ySpeed();
+		Vector2D start = component->center();
 
-	if(abs(xSpeed) < friction)
-	{
-		vel->increaseHorizontalSpeed(xSpeed * -1);
-	}
-	else
-	{
-		if (0 < xSpeed)
+		if (m_collisionSystem->fixedPoint())
 		{
-			vel->increaseHorizontalSpeed(friction * -1);
+			FixedVector speed = toFixed(velocity(velID));
+			Fixed time = toFixed(delta);
+
+			FixedVector displacement{ fixedMultiply(speed.x, time), fixedMultiply(speed.y, time) };
+
+			moveAndSlide(velID, displacement, group);
 		}
 		else
 		{
-			vel->increaseHorizontalSpeed(friction);
+			moveAndSlide(velID, velocity(velID) * delta, group);
 		}
+
+		Vector2D end = component->center();
+
+		if (end != start)
+		{
+			sendMoveMessage(velID, start, end, group.m_workspace);
+		}
+
+		// Let the mover know about anything it ended up on top of,
+		// like triggers and attacks that don't block it.
+		m_collisionSystem->isColliding(velID, group.m_workspace);
 	}
+}
 
-	if (abs(ySpeed) < friction)
+// Hands back everything the group changed
+void PhysicsSystem::finishGroup(MoverGroup &group)
+{
+	m_collisionSystem->flushWorkspace(group.m_workspace);
+
+	for (unsigned int i = 0; i < group.m_woken.size(); i++)
 	{
-		vel->increaseVerticalSpeed(ySpeed * -1);
+		m_velocities.wake(group.m_woken[i]);
 	}
-	else
+
+	group.m_woken.clear();
+}
+
+//=============================================================================
+// Function: void moveAndSlide(int, Vector2D, MoverGroup&)
+// Description:
+// Moves the entity until it runs into something solid, then slides the
+// rest of the way along what it hit. Moves that are longer than the entity
+// are split into steps so it slides correctly around corners.
+// Parameters:
+// int entityID - The entity to move.
+// Vector2D displacement - How far the entity wants to move.
+// MoverGroup &group - The group the entity is being moved in.
+//=============================================================================
+void PhysicsSystem::moveAndSlide(int entityID, Vector2D displacement, MoverGroup &group)
+{
+	CollisionComponent *component = m_collisionSystem->getCollisionComponent(entityID);
+
+	if (!component)
+	{
+		return;
+	}
+
+	AABB bounds = shapeBounds(component->shape());
+
+	float size = std::min(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY);
+	float length = std::max(fabs(displacement.getX()), fabs(displacement.getY()));
+
+	if (size < 1.0f)
 	{
-		if (0 < ySpeed)
+		size = 1.0f;
+	}
+
+	int steps = (int)ceil(length / size);
+
+	if (steps < 1) { steps = 1; }
+	if (m_MAX_SUBSTEPS < steps) { steps = m_MAX_SUBSTEPS; }
+
+	Vector2D step = displacement * (1.0f / (float)steps);
+	Vector2D none{ 0.0f, 0.0f };
+
+	for (int i = 0; i < steps && step != none; i++)
+	{
+		Vector2D remaining = step;
+
+		for (int k = 0; k < m_SLIDE_ITERATIONS && remaining != none; k++)
 		{
-			vel->increaseVerticalSpeed(friction * -1);
+			Vector2D position = component->center();
+			SweepHit hit{ 0.0f, none, -1 };
+
+			if (!m_collisionSystem->sweepCollision(entityID, remaining, hit, group.m_workspace))
+			{
+				position = position + remaining;
+				m_collisionSystem->updatePosition(entityID, position.getX(), position.getY(), group.m_workspace);
+
+				break;
+			}
+
+			// Whatever was run into gets a chance to react
+			if (0 <= hit.m_entityID)
+			{
+				group.m_woken.push_back(hit.m_entityID);
+			}
+
+			// Stop just short of what was hit
+			float speed = fabs(hit.m_normal.getX() != 0.0f ? remaining.getX() : remaining.getY());
+			float time = hit.m_time - (m_SKIN / speed);
+
+			if (time < 0.0f)
+			{
+				time = 0.0f;
+			}
+
+			Vector2D moved = remaining * time;
+
+			position = position + moved;
+			m_collisionSystem->updatePosition(entityID, position.getX(), position.getY(), group.m_workspace);
+
+			// Keep going along the surface. Moving into it again is blocked
+			// for the rest of the steps too.
+			Vector2D slide{ std::fabs(hit.m_normal.getY()), std::fabs(hit.m_normal.getX()) };
+
+			remaining = (remaining - moved) * slide;
+			step = step * slide;
 		}
-		else
+	}
+}
+
+//=============================================================================
+// Function: void moveAndSlide(int, FixedVector, MoverGroup&)
+// Description:
+// The fixed point version of moveAndSlide. Positions are kept in floats
+// between moves, which hold them exactly near the origin and round them
+// the same way everywhere further out.
+// Parameters:
+// int entityID - The entity to move.
+// FixedVector displacement - How far the entity wants to move.
+// MoverGroup &group - The group the entity is being moved in.
+//=============================================================================
+void PhysicsSystem::moveAndSlide(int entityID, FixedVector displacement, MoverGroup &group)
+{
+	CollisionComponent *component = m_collisionSystem->getCollisionComponent(entityID);
+
+	if (!component)
+	{
+		return;
+	}
+
+	FixedBounds bounds = fixedShapeBounds(component->shape());
+
+	Fixed size = std::min(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY);
+	Fixed length = std::max(fixedAbs(displacement.x), fixedAbs(displacement.y));
+
+	if (size < FIXED_ONE)
+	{
+		size = FIXED_ONE;
+	}
+
+	int steps = (int)(((long long)length + size - 1) / size);
+
+	if (steps < 1) { steps = 1; }
+	if (m_MAX_SUBSTEPS < steps) { steps = m_MAX_SUBSTEPS; }
+
+	FixedVector step{ displacement.x / steps, displacement.y / steps };
+	Fixed skin = toFixed(m_SKIN);
+
+	for (int i = 0; i < steps && (step.x != 0 || step.y != 0); i++)
+	{
+		FixedVector remaining = step;
+
+		for (int k = 0; k < m_SLIDE_ITERATIONS && (remaining.x != 0 || remaining.y != 0); k++)
 		{
-			vel->increaseVerticalSpeed(friction);
+			FixedVector position = toFixed(component->center());
+			SweepHit hit{ 0.0f, Vector2D(0.0f, 0.0f), -1 };
+
+			if (!m_collisionSystem->sweepCollision(entityID, toFloat(remaining), hit, group.m_workspace))
+			{
+				position.x += remaining.x;
+				position.y += remaining.y;
+				m_collisionSystem->updatePosition(entityID, toFloat(position.x), toFloat(position.y), group.m_workspace);
+
+				break;
+			}
+
+			if (0 <= hit.m_entityID)
+			{
+				group.m_woken.push_back(hit.m_entityID);
+			}
+
+			bool hitSide = (hit.m_normal.getX() != 0.0f);
+
+			// Stop just short of what was hit
+			Fixed speed = fixedAbs(hitSide ? remaining.x : remaining.y);
+			Fixed time = toFixed(hit.m_time) - fixedDivide(skin, speed);
+
+			if (time < 0)
+			{
+				time = 0;
+			}
+
+			FixedVector moved{ fixedMultiply(remaining.x, time), fixedMultiply(remaining.y, time) };
+
+			position.x += moved.x;
+			position.y += moved.y;
+			m_collisionSystem->updatePosition(entityID, toFloat(position.x), toFloat(position.y), group.m_workspace);
+
+			// Keep sliding along the surface
+			remaining.x -= moved.x;
+			remaining.y -= moved.y;
+
+			if (hitSide)
+			{
+				remaining.x = 0;
+				step.x = 0;
+			}
+			else
+			{
+				remaining.y = 0;
+				step.y = 0;
+			}
 		}
 	}
 }
 
+//=============================================================================
+// Function: void applyFriction(float)
+// Description:
+// Applies friction to every velocity.
+// TODO: Make it only apply friction to objects opted into friction thx.
+// Parameters:
+// float delta - The time since the last update.
+//=============================================================================
+void PhysicsSystem::applyFriction(float delta)
+{
+	if (m_collisionSystem->fixedPoint())
+	{
+		m_velocities.applyFriction(fixedMultiply(toFixed(m_FRICTION), toFixed(delta)));
+	}
+	else
+	{
+		m_velocities.applyFriction(m_FRICTION * delta);
+	}
+}
+
 Vector2D PhysicsSystem::lerp(Vector2D goal, Vector2D current, float amount)
 {
 	float xDiff = goal.getX() - current.getX();
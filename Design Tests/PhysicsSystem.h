@@ -8,11 +8,12 @@
 //==========================================================================================
 #include <map>
 #include "CollisionSystem.h"
-#include "VelocityComponent.h"
+#include "VelocityStore.h"
+#include "WorkerPool.h"
 #include "MessageSystem.h"
-#include "IMessage.h"
+#include "IMessageHandler.h"
 
-class PhysicsSystem
+class PhysicsSystem : public IMessageHandler
 {
 public:
 	static PhysicsSystem *instance()
@@ -39,30 +40,91 @@ public:
 	CollisionComponent* getCollisionComponent(int ID);
 
 	// Velocity Functions
-	VelocityComponent* getVelocityComponent(int ID);
+	void addVelocity(int ID);
+	Vector2D velocity(int ID);
+	void setVelocity(int ID, Vector2D velocity);
+
+	// Moves bodies with Q16.16 fixed point math instead of floats, so the
+	// same inputs move them the same way on every machine.
+	void setFixedPoint(bool fixedPoint);
 
 	void processMessage(IMessage *message);
 
-	void initCollisionSystem(int gridX, int gridY, int width, int height, int cellSize);
+	void initCollisionSystem(int gridX, int gridY, int width, int height, int cellSize,
+		BroadPhase::BroadPhaseType broadPhase = BroadPhase::GRID);
+
+	// How many threads besides the main one help move bodies. 0 keeps
+	// everything on the main thread.
+	void setWorkerCount(int workerCount);
 
 	bool hasLineOfSight(int entityID, int otherEntityID);
+	void hasLineOfSight(std::vector<SightQuery> &queries);
 
 private:
 	PhysicsSystem()
-		:m_collisionSystem(NULL)
+		:m_collisionSystem(NULL), m_groupCount(0), m_workers(NULL)
 	{
 	}
 
-	std::map<int, VelocityComponent*> m_velocityComponents;
+	// How far movers stop short of what they hit, so rounding can't leave
+	// them inside of it.
+	const float m_SKIN = 0.01f;
+	// Fast movers are split into steps no longer than they are, up to this many
+	const int m_MAX_SUBSTEPS = 8;
+	// Hit normals are always along x or y, so two hits stop all movement
+	const int m_SLIDE_ITERATIONS = 2;
+	// How much speed friction takes away a second. It used to take 10 away
+	// every frame, which is the same thing at 60 ticks a second.
+	const float m_FRICTION = 600.0f;
+	// How many ticks a body has to sit still before it's put to sleep
+	const int m_SLEEP_TICKS = 30;
+	// Movers are split into strips this wide, and the strips are moved at
+	// the same time.
+	const float m_STRIP_WIDTH = 512.0f;
+	// How far a mover has to stay from the edges of its strip. It's bigger
+	// than the AABB tree's fat margin, so nothing a mover looks at can be
+	// moved by another strip.
+	const float m_STRIP_HALO = 16.0f;
+	// Fewer movers than this aren't worth handing to other threads
+	const int m_MIN_PARALLEL_MOVERS = 64;
+
+	// Movers that are moved together on one thread, and everything they
+	// changed that still has to be handed back.
+	struct MoverGroup
+	{
+		std::vector<int> m_movers;
+		std::vector<int> m_woken;
+		CollisionWorkspace m_workspace;
+	};
+
+	struct StripMover
+	{
+		int m_strip;
+		int m_entityID;
+	};
+
+	VelocityStore m_velocities;
 	CollisionSystem *m_collisionSystem;
 
-	void sendMoveMessage(int entityID, Vector2D oldPosition, Vector2D newPosition);
-	
-	void removeVelocityComponent(int entityID);
+	std::vector<StripMover> m_stripMovers;
+	std::vector<MoverGroup*> m_groups;
+	int m_groupCount;
+	// Movers that reach across a strip edge
+	MoverGroup m_crossers;
 
+	WorkerPool *m_workers;
+
+	void sendMoveMessage(int entityID, Vector2D oldPosition, Vector2D newPosition, CollisionWorkspace &workspace);
+	
 	void cleanUp();
+	void buildBroadPhase(float delta);
 	void applyVelocity(float delta);
-	void applyFriction(int entityID, float delta);
+	void partitionMovers(float delta);
+	void moveGroup(MoverGroup &group, float delta);
+	void finishGroup(MoverGroup &group);
+	void moveAndSlide(int entityID, Vector2D displacement, MoverGroup &group);
+	void moveAndSlide(int entityID, FixedVector displacement, MoverGroup &group);
+	void applyFriction(float delta);
 	Vector2D lerp(Vector2D goal, Vector2D current, float amount);
 };
 
@@ -1,5 +1,4 @@
 #include "PlayerLogicComponent.h"
-#include "CollisionMessage.h"
 #include "EntitySystem.h"
 #include "AttackInfo.h"
 #include "PhysicsSystem.h"
@@ -131,10 +130,25 @@ void PlayerLogicComponent::changeState(std::string stateName)
 //=============================================================================
 // Function: void update()
 // Description:
-// If there's a current state, it handles the logic behind it.
+// Reacts to what hit the player last tick, then if there's a current
+// state, it handles the logic behind it.
 //=============================================================================
 void PlayerLogicComponent::update()
 {
+	const Contact *contacts = NULL;
+
+	int contactCount = PhysicsSystem::instance()->collisionSystem()->contacts(m_entityID, contacts);
+
+	for (int i = 0; i < contactCount; i++)
+	{
+		// Only attacks that ran into the player count
+		if (!contacts[i].m_checked &&
+			EntitySystem::instance()->entityType(contacts[i].m_otherID) == "EnemyAttack")
+		{
+			knockback(contacts[i].m_otherID, contacts[i].m_position);
+		}
+	}
+
 	if(m_currentState)
 	{
 		m_currentState->update();
@@ -152,57 +166,6 @@ void PlayerLogicComponent::processMessage(IMessage *message)
 {
 	if(message)
 	{
-		switch(message->type())
-		{
-		case IMessage::COLLISION:
-		{
-			CollisionMessage *collision = static_cast<CollisionMessage*>(message);
-
-			if(collision->m_collidingID == m_entityID)
-			{
-				if (EntitySystem::instance()->entityType(collision->m_entityID) == "EnemyAttack")
-				{
-					if (canKnockback())
-					{
-						int attackKey = EntitySystem::instance()->getEntityKey(collision->m_entityID);
-
-						if (attackKey != -1)
-						{
-							AttackInfo *attack = EntitySystem::instance()->entityAttack(attackKey);
-
-							if (attack)
-							{
-								CollisionComponent *selfCol = PhysicsSystem::instance()->getCollisionComponent(m_entityID);
-
-								if (selfCol)
-								{
-									Vector2D distance = collision->m_position - selfCol->center();
-
-									float angle = (float)atan2(distance.getY(), distance.getX());
-
-									float xVel = (float)(cos(angle + M_PI) * attack->knockback());
-									float yVel = (float)(sin(angle + M_PI) * attack->knockback());
-
-									VelocityIncreaseMessage *vel = new VelocityIncreaseMessage(m_entityID, xVel, yVel, attack->knockback(), attack->knockback());
-
-									MessageSystem::instance()->pushMessage(vel);
-
-									SDL_Color redFade{ 255, 40, 40, 100 };
-
-									RenderSystem::instance()->createTextureEffect(m_entityID, TextureEffect::EFFECT_ALL_FLASH, redFade, SDL_BLENDMODE_BLEND, m_knockbackCooldown, 12.0f);
-
-									m_knockback.start();
-								}
-							}
-						}
-					}
-				}
-			}
-				
-			break;
-		}
-		}
-
 		if(m_currentState)
 		{
 			m_currentState->processMessage(message);
@@ -232,6 +195,53 @@ void PlayerLogicComponent::cleanUp()
 	}
 }
 
+//=============================================================================
+// Function: void knockback(int, Vector2D)
+// Description:
+// Pushes the player away from where an attack hit and flashes them red,
+// unless they were knocked back too recently.
+// Parameters:
+// int attackID - The attack's entity.
+// Vector2D position - Where the attack hit.
+//=============================================================================
+void PlayerLogicComponent::knockback(int attackID, Vector2D position)
+{
+	if (canKnockback())
+	{
+		int attackKey = EntitySystem::instance()->getEntityKey(attackID);
+
+		if (attackKey != -1)
+		{
+			AttackInfo *attack = EntitySystem::instance()->entityAttack(attackKey);
+
+			if (attack)
+			{
+				CollisionComponent *selfCol = PhysicsSystem::instance()->getCollisionComponent(m_entityID);
+
+				if (selfCol)
+				{
+					Vector2D distance = position - selfCol->center();
+
+					float angle = (float)atan2(distance.getY(), distance.getX());
+
+					float xVel = (float)(cos(angle + M_PI) * attack->knockback());
+					float yVel = (float)(sin(angle + M_PI) * attack->knockback());
+
+					VelocityIncreaseMessage *vel = new VelocityIncreaseMessage(m_entityID, xVel, yVel, attack->knockback(), attack->knockback());
+
+					MessageSystem::instance()->pushMessage(vel);
+
+					SDL_Color redFade{ 255, 40, 40, 100 };
+
+					RenderSystem::instance()->createTextureEffect(m_entityID, TextureEffect::EFFECT_ALL_FLASH, redFade, SDL_BLENDMODE_BLEND, m_knockbackCooldown, 12.0f);
+
+					m_knockback.start();
+				}
+			}
+		}
+	}
+}
+
 bool PlayerLogicComponent::canKnockback()
 {
 	bool knockbackAllowed = false;
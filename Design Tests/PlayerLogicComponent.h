@@ -8,6 +8,7 @@
 //==========================================================================================
 #include "LogicComponent.h"
 #include "Timer.h"
+#include "Vector2D.h"
 #include <map>
 
 class PlayerLogicComponent : public LogicComponent
@@ -43,5 +44,6 @@ private:
 	float m_knockbackCooldown;
 
 	bool canKnockback();
+	void knockback(int attackID, Vector2D position);
 };
 
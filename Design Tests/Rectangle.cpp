@@ -22,48 +22,133 @@ Rectangle::~Rectangle()
 
 Vector2D Rectangle::getTopRight()
 {
-	Vector2D topRight(m_center.getX() + (m_width / 2), m_center.getY() - (m_height / 2));
+	updateGeometry();
 
-	if (m_rotation != 0.0f)
-	{
-		topRight = rotatePoint(topRight, m_center, m_rotation);
-	}
-
-	return topRight;
+	return Vector2D(m_cornerX[1], m_cornerY[1]);
 }
 
 Vector2D Rectangle::getTopLeft()
 {
-	Vector2D topLeft(m_center.getX() - (m_width / 2), m_center.getY() - (m_height / 2));
+	updateGeometry();
 
-	if (m_rotation != 0.0f)
-	{
-		topLeft = rotatePoint(topLeft, m_center, m_rotation);
-	}
-
-	return topLeft;
+	return Vector2D(m_cornerX[0], m_cornerY[0]);
 }
 
 Vector2D Rectangle::getBottomRight()
 {
-	Vector2D bottomRight(m_center.getX() + (m_width / 2), m_center.getY() + (m_height / 2));
-
-	if (m_rotation != 0.0f)
-	{
-		bottomRight = rotatePoint(bottomRight, m_center, m_rotation);
-	}
+	updateGeometry();
 
-	return bottomRight;
+	return Vector2D(m_cornerX[2], m_cornerY[2]);
 }
 
 Vector2D Rectangle::getBottomLeft()
 {
-	Vector2D bottomLeft(m_center.getX() - (m_width / 2), m_center.getY() + (m_height / 2));
+	updateGeometry();
+
+	return Vector2D(m_cornerX[3], m_cornerY[3]);
+}
+
+Vector2D Rectangle::axis(int index)
+{
+	updateGeometry();
+
+	return Vector2D(m_axisX[index], m_axisY[index]);
+}
+
+AABB Rectangle::bounds()
+{
+	updateGeometry();
+
+	return m_bounds;
+}
+
+//=============================================================================
+// Function: void project(Vector2D, float&, float&)
+// Description:
+// Gets the range the rectangle covers when it's flattened onto the axis.
+// Parameters:
+// Vector2D axis - The direction to flatten onto. Doesn't need to be normalized.
+// float &minimum - The low end of the range.
+// float &maximum - The high end of the range.
+//=============================================================================
+void Rectangle::project(Vector2D axis, float &minimum, float &maximum)
+{
+	updateGeometry();
+
+	float center = (m_center.getX() * axis.getX()) + (m_center.getY() * axis.getY());
+
+	float widthReach = fabs((m_axisX[0] * axis.getX()) + (m_axisY[0] * axis.getY())) * ((float)m_width * 0.5f);
+	float heightReach = fabs((m_axisX[1] * axis.getX()) + (m_axisY[1] * axis.getY())) * ((float)m_height * 0.5f);
+
+	minimum = center - (widthReach + heightReach);
+	maximum = center + (widthReach + heightReach);
+}
+
+Vector2D Rectangle::toLocal(Vector2D point)
+{
+	updateGeometry();
+
+	float x = point.getX() - m_center.getX();
+	float y = point.getY() - m_center.getY();
+
+	return Vector2D((x * m_axisX[0]) + (y * m_axisY[0]), (x * m_axisX[1]) + (y * m_axisY[1]));
+}
+
+// Rebuilds the corners, axes, and bounds if the rectangle changed since
+// they were last worked out.
+void Rectangle::updateGeometry()
+{
+	if (!m_dirty)
+	{
+		return;
+	}
+
+	m_axisX[0] = 1.0f;
+	m_axisY[0] = 0.0f;
+	m_axisX[1] = 0.0f;
+	m_axisY[1] = 1.0f;
 
 	if (m_rotation != 0.0f)
 	{
-		bottomLeft = rotatePoint(bottomLeft, m_center, m_rotation);
+		float radians = degreesToRadians(convertRotationToDegrees(m_rotation));
+
+		float radianCosine = cos(radians);
+		float radianSine = sin(radians);
+
+		m_axisX[0] = radianCosine;
+		m_axisY[0] = radianSine;
+		m_axisX[1] = -radianSine;
+		m_axisY[1] = radianCosine;
+	}
+
+	float halfWidth = (float)m_width * 0.5f;
+	float halfHeight = (float)m_height * 0.5f;
+
+	// How far each corner is from the center along the width and height
+	const float WIDTH_SIGN[m_CORNERS]{ -1.0f, 1.0f, 1.0f, -1.0f };
+	const float HEIGHT_SIGN[m_CORNERS]{ -1.0f, -1.0f, 1.0f, 1.0f };
+
+	for (int i = 0; i < m_CORNERS; i++)
+	{
+		float alongWidth = WIDTH_SIGN[i] * halfWidth;
+		float alongHeight = HEIGHT_SIGN[i] * halfHeight;
+
+		m_cornerX[i] = m_center.getX() + (alongWidth * m_axisX[0]) + (alongHeight * m_axisX[1]);
+		m_cornerY[i] = m_center.getY() + (alongWidth * m_axisY[0]) + (alongHeight * m_axisY[1]);
+	}
+
+	m_bounds.minX = m_cornerX[0];
+	m_bounds.minY = m_cornerY[0];
+	m_bounds.maxX = m_cornerX[0];
+	m_bounds.maxY = m_cornerY[0];
+
+	for (int i = 1; i < m_CORNERS; i++)
+	{
+		if (m_cornerX[i] < m_bounds.minX) { m_bounds.minX = m_cornerX[i]; }
+		if (m_bounds.maxX < m_cornerX[i]) { m_bounds.maxX = m_cornerX[i]; }
+		if (m_cornerY[i] < m_bounds.minY) { m_bounds.minY = m_cornerY[i]; }
+		if (m_bounds.maxY < m_cornerY[i]) { m_bounds.maxY = m_cornerY[i]; }
 	}
 
-	return bottomLeft;
-}
\ No newline at end of file
+	m_dirty = false;
+}
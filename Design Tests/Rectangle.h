@@ -5,8 +5,12 @@
 // Date Created: 3/25/2019
 // Purpose: 
 // Holds information for a rectangle shape.
+// The corners, edge directions, and bounding box are worked out once after
+// the rectangle moves, turns, or changes size, then reused until it changes
+// again.
 //==========================================================================================
 #include "IShape.h"
+#include "AABB.h"
 
 namespace Shape
 {
@@ -21,11 +25,11 @@ namespace Shape
 
 		virtual ShapeType type() { return RECTANGLE; }
 
-		void setWidth(const int width) { m_width = width; }
-		void setHeight(const int height) { m_height = height; }
+		void setWidth(const int width) { m_width = width; m_dirty = true; }
+		void setHeight(const int height) { m_height = height; m_dirty = true; }
 
-		virtual void setCenterX(float x) { m_center.setX(x); }
-		virtual void setCenterY(float y) { m_center.setY(y); }
+		virtual void setCenterX(float x) { m_center.setX(x); m_dirty = true; }
+		virtual void setCenterY(float y) { m_center.setY(y); m_dirty = true; }
 
 		int width() const { return m_width; }
 		int height() const { return m_height; }
@@ -35,8 +39,30 @@ namespace Shape
 		Vector2D getBottomRight();
 		Vector2D getBottomLeft();
 
+		// The direction of the rectangle's width (0) or height (1)
+		Vector2D axis(int index);
+		AABB bounds();
+
+		// Gets how far the rectangle covers along the axis
+		void project(Vector2D axis, float &minimum, float &maximum);
+
+		// Gets where the point is along the rectangle's width and height,
+		// measured from its center
+		Vector2D toLocal(Vector2D point);
+
 	private:
+		static const int m_CORNERS = 4;
+
 		int m_width;
 		int m_height;
+
+		// Top left, top right, bottom right, bottom left
+		float m_cornerX[m_CORNERS];
+		float m_cornerY[m_CORNERS];
+		float m_axisX[2];
+		float m_axisY[2];
+		AABB m_bounds;
+
+		void updateGeometry();
 	};
 }
\ No newline at end of file
@@ -43,6 +43,47 @@ void RenderSystem::update(float delta)
 	}
 }
 
+//=============================================================================
+// Function: void settleSprites()
+// Description:
+// Moves the last position of every sprite that moved up to where it is now.
+// The camera is settled along with them.
+//=============================================================================
+void RenderSystem::settleSprites()
+{
+	for (int i = 0; i < (int)m_movedSprites.size(); i++)
+	{
+		SpriteComponent *sprite = getSprite(m_movedSprites[i]);
+
+		if (sprite)
+		{
+			sprite->setPreviousPosition(sprite->position());
+		}
+	}
+
+	m_movedSprites.clear();
+
+	if (m_camera)
+	{
+		m_previousCamera = Vector2D((float)m_camera->getX(), (float)m_camera->getY());
+	}
+}
+
+//=============================================================================
+// Function: void setInterpolation(float)
+// Description:
+// Sets how far between their last two positions the sprites are drawn.
+// Parameters:
+// float amount - 0 draws the sprites where they were, 1 where they are now.
+//=============================================================================
+void RenderSystem::setInterpolation(float amount)
+{
+	if (amount < 0.0f) { amount = 0.0f; }
+	if (1.0f < amount) { amount = 1.0f; }
+
+	m_interpolation = amount;
+}
+
 //=============================================================================
 // Function: SpriteComponent* createSprite(ID, string)
 // Description:
@@ -74,6 +115,7 @@ SpriteComponent* RenderSystem::createSprite(ID id,
 		comp = new SpriteComponent(ResourceManager::instance()->getTexture(texturePath));
 		
 		comp->setPosition(position);
+		comp->setPreviousPosition(position);
 
 		m_layers[comp->layer()]->add(id, (int)round(position.getX()), (int)round(position.getY()));
 
@@ -289,7 +331,7 @@ void RenderSystem::setSpriteLayer(ID spriteID, RenderLayers layer)
 		if (oldLayer < 0) { oldLayer = 0; }
 		else if (m_LAYER_COUNT <= oldLayer) { oldLayer = m_LAYER_COUNT - 1; }
 
-		m_layers[oldLayer]->remove(spriteID, (int)round(sprite->position().getX()), (int)round(sprite->position().getY()));
+		m_layers[oldLayer]->remove(spriteID);
 
 		int workingLayer = layer;
 
@@ -468,6 +510,9 @@ void RenderSystem::setCameraTarget(int targetID)
 		Vector2D newPosition{ (float)(m_camera->getX() + (m_camera->getWidth() / 2)),
 					  (float)(m_camera->getY() + (m_camera->getHeight() / 2)) };
 
+		// Jump straight to the new target instead of sliding over to it
+		m_previousCamera = Vector2D((float)m_camera->getX(), (float)m_camera->getY());
+
 		CameraMoveMessage *move = new CameraMoveMessage(oldPosition, newPosition);
 
 		MessageSystem::instance()->pushMessage(move);
@@ -566,10 +611,12 @@ void RenderSystem::drawSprites(float delta, int layer)
 
 	if (m_camera)
 	{
+		Vector2D camera = interpolate(m_previousCamera, Vector2D((float)m_camera->getX(), (float)m_camera->getY()));
+
 		scale.setX(m_camera->currentScaleX());
 		scale.setY(m_camera->currentScaleY());
-		offsetX = m_camera->getX();
-		offsetY = m_camera->getY();
+		offsetX = (int)round(camera.getX());
+		offsetY = (int)round(camera.getY());
 	}
 
 	int startingX = (int)round(m_camera->getX() / (m_GRID_SIZE * scale.getX()));
@@ -587,20 +634,20 @@ void RenderSystem::drawSprites(float delta, int layer)
 	{
 		for (int j = 0; j < yDiff; j++)
 		{
-			Node<int> *cell = m_layers[layer]->getCell(startingX + i, startingY + j);
+			GridCell cell = m_layers[layer]->getCell(startingX + i, startingY + j);
 
-			while (cell)
+			for (int k = 0; k < cell.count(); k++)
 			{
-				SpriteComponent *sprite = getSprite(cell->data());
+				SpriteComponent *sprite = getSprite(cell[k]);
 
 				if (sprite && sprite->visible())
 				{
-					TextureEffect *effect = getEffect(cell->data());
+					TextureEffect *effect = getEffect(cell[k]);
 
 					Texture *texture = sprite->texture();
 
 					Vector2D anchor = sprite->anchor();
-					Vector2D position = sprite->position();
+					Vector2D position = interpolate(sprite->previousPosition(), sprite->position());
 
 					SDL_Rect *clip = &sprite->clip();
 					SDL_Rect *renderSize = &sprite->renderSize();
@@ -608,7 +655,7 @@ void RenderSystem::drawSprites(float delta, int layer)
 					int width = renderSize->w;
 					int height = renderSize->h;
 
-					AnimationComponent *animation = getAnimation(cell->data());
+					AnimationComponent *animation = getAnimation(cell[k]);
 
 					if (animation != NULL)
 					{
@@ -701,8 +748,6 @@ void RenderSystem::drawSprites(float delta, int layer)
 							sprite->rotation());
 					}
 				}
-
-				cell = cell->m_next;
 			}
 		}
 	}
@@ -746,21 +791,21 @@ void RenderSystem::drawUI(float delta)
 		{
 			for (int j = 0; j < yDiff; j++)
 			{
-				Node<int> *cell = m_layers[layer]->getCell(startingX + i, startingY + j);
+				GridCell cell = m_layers[layer]->getCell(startingX + i, startingY + j);
 
-				while (cell)
+				for (int k = 0; k < cell.count(); k++)
 				{
-					SpriteComponent *sprite = getSprite(cell->data());
+					SpriteComponent *sprite = getSprite(cell[k]);
 
 					if (sprite && sprite->visible())
 					{
-						TextureEffect *effect = getEffect(cell->data());
+						TextureEffect *effect = getEffect(cell[k]);
 
 						Texture *texture = sprite->texture();
 						Vector2D anchor = sprite->anchor();
 						Vector2D position = sprite->position();
 
-						AnimationComponent *animation = getAnimation(cell->data());
+						AnimationComponent *animation = getAnimation(cell[k]);
 						SDL_Rect *clip = &sprite->clip();
 						SDL_Rect *renderSize = &sprite->renderSize();
 
@@ -812,8 +857,6 @@ void RenderSystem::drawUI(float delta)
 							clip,
 							sprite->rotation());
 					}
-
-					cell = cell->m_next;
 				}
 			}
 		}
@@ -943,7 +986,7 @@ void RenderSystem::processMoveMessage(MoveMessage *message)
 
 	if (comp)
 	{
-		m_layers[comp->layer()]->move(message->m_entityID, (int)round(comp->position().getX()), (int)round(comp->position().getY()), (int)round(position.getX()), (int)round(position.getY()));
+		m_layers[comp->layer()]->move(message->m_entityID, (int)round(position.getX()), (int)round(position.getY()));
 
 		if (m_camera)
 		{
@@ -1018,6 +1061,8 @@ void RenderSystem::processMoveMessage(MoveMessage *message)
 		}
 
 		comp->setPosition(position);
+
+		m_movedSprites.push_back(message->m_entityID);
 	}
 
 	if (text)
@@ -1038,7 +1083,7 @@ void RenderSystem::removeSprite(int entityID)
 	auto mit = m_sprites.find(entityID);
 		if(mit != m_sprites.end())
 	{
-		m_layers[mit->second->layer()]->remove(mit->first, (int)mit->second->position().getX(), (int)mit->second->position().getY());
+		m_layers[mit->second->layer()]->remove(mit->first);
 
 		delete mit->second;
 
@@ -1083,4 +1128,20 @@ void RenderSystem::removeText(int entityID)
 
 		mit = m_texts.erase(mit);
 	}
+}
+
+//=============================================================================
+// Function: Vector2D interpolate(Vector2D, Vector2D)
+// Description:
+// Gets the point between two positions that the current interpolation
+// amount lands on.
+// Parameters:
+// Vector2D previous - Where it was at the end of the tick before the last one.
+// Vector2D current - Where it was at the end of the last tick.
+// Output:
+// Vector2D - The position to draw at.
+//=============================================================================
+Vector2D RenderSystem::interpolate(Vector2D previous, Vector2D current)
+{
+	return previous + ((current - previous) * m_interpolation);
 }
\ No newline at end of file
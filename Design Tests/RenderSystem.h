@@ -12,7 +12,7 @@
 #include "Line.h"
 #include "SpriteComponent.h"
 #include "AnimationComponent.h"
-#include "IMessage.h"
+#include "IMessageHandler.h"
 #include "MessageSystem.h"
 #include "Camera2D.h"
 #include "TextureEffect.h"
@@ -25,7 +25,7 @@ class MoveMessage;
 
 typedef int ID;
 
-class RenderSystem
+class RenderSystem : public IMessageHandler
 {
 public:
 	enum RenderLayers
@@ -51,6 +51,12 @@ public:
 	void clear();
 	void update(float delta);
 
+	// Forgets where the sprites were before the last tick, so only sprites
+	// that move in the next tick are drawn between two positions.
+	void settleSprites();
+	// How far to draw the sprites between the last two ticks, from 0 to 1
+	void setInterpolation(float amount);
+
 	// TODO: Maybe take component creation away from the system, but have the system
 	// have control of registering and destroying them.
 	SpriteComponent* createSprite(ID id, std::string texturePath, Vector2D position);
@@ -84,7 +90,7 @@ private:
 	const int m_GRID_SIZE = 256;
 
 	RenderSystem()
-		:m_renderer(NULL), m_camera(NULL)
+		:m_renderer(NULL), m_camera(NULL), m_interpolation(1.0f), m_previousCamera(0.0f, 0.0f)
 	{
 		for(int i = 0; i < m_LAYER_COUNT; i++)
 		{
@@ -103,7 +109,13 @@ private:
 
 	std::vector<Grid*> m_layers;
 
+	float m_interpolation;
+	Vector2D m_previousCamera;
+	// Sprites that have moved since they were last settled
+	std::vector<ID> m_movedSprites;
+
 	void cleanUp();
+	Vector2D interpolate(Vector2D previous, Vector2D current);
 	void drawSprites(float delta, int layer);
 	void drawUI(float delta);
 	void drawText(float delta);
@@ -7,6 +7,7 @@ SpriteComponent::SpriteComponent(Texture *texture)
 	m_texture(texture),
 	m_anchor(-1, -1),
 	m_position(0, 0),
+	m_previousPosition(0, 0),
 	m_rotation(0.0f),
 	m_visible(true),
 	m_layer(0),
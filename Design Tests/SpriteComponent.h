@@ -22,6 +22,8 @@ public:
 	void setTexture(Texture *texture);
 	void setAnchor(Vector2D anchor) { m_anchor = anchor; }
 	void setPosition(Vector2D position) { m_position = position; }
+	// Where the sprite was at the end of the tick before the last one
+	void setPreviousPosition(Vector2D position) { m_previousPosition = position; }
 	void setRotation(float rotation) { m_rotation = rotation; }
 	void setColorMod(SDL_Color colorMod) { m_colorMod = colorMod; }
 	void setClip(int x, int y, int w, int h);
@@ -38,6 +40,7 @@ public:
 
 	Vector2D anchor() { return m_anchor; }
 	Vector2D position() { return m_position; }
+	Vector2D previousPosition() { return m_previousPosition; }
 	float rotation() { return m_rotation; }
 	int width() { return m_texture->width(); }
 	int height() { return m_texture->height(); }
@@ -55,6 +58,7 @@ private:
 
 	Vector2D m_anchor;
 	Vector2D m_position;
+	Vector2D m_previousPosition;
 	
 	float m_rotation;
 	bool m_visible;
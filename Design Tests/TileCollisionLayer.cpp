@@ -0,0 +1,414 @@
+#include "TileCollisionLayer.h"
+#include <cmath>
+#include <algorithm>
+
+TileCollisionLayer::TileCollisionLayer()
+	:m_originX(0), m_originY(0), m_columns(0), m_rows(0), m_tileSize(1), m_solidCount(0)
+{
+}
+
+TileCollisionLayer::~TileCollisionLayer()
+{
+}
+
+//=============================================================================
+// Function: void reset(int, int, int, int, int)
+// Description:
+// Clears the layer and sizes it to cover the area. Anything outside of the
+// area is never solid.
+// Parameters:
+// int originX - The left side of the area.
+// int originY - The top of the area.
+// int width - The width of the area.
+// int height - The height of the area.
+// int tileSize - How big each tile is.
+//=============================================================================
+void TileCollisionLayer::reset(int originX, int originY, int width, int height, int tileSize)
+{
+	if (tileSize <= 0)
+	{
+		tileSize = 1;
+	}
+
+	m_originX = originX;
+	m_originY = originY;
+	m_tileSize = tileSize;
+	m_columns = (width + tileSize - 1) / tileSize;
+	m_rows = (height + tileSize - 1) / tileSize;
+
+	if (m_columns < 0) { m_columns = 0; }
+	if (m_rows < 0) { m_rows = 0; }
+
+	m_solid.assign(m_columns * m_rows, 0);
+	m_solidCount = 0;
+}
+
+void TileCollisionLayer::clear()
+{
+	m_solid.assign(m_solid.size(), 0);
+	m_solidCount = 0;
+}
+
+//=============================================================================
+// Function: void setSolid(int, int, bool)
+// Description:
+// Sets whether the tile under the coordinates is solid. Coordinates outside
+// of the layer are ignored.
+// Parameters:
+// int x - Any x inside of the tile.
+// int y - Any y inside of the tile.
+// bool solid - Whether the tile blocks things.
+//=============================================================================
+void TileCollisionLayer::setSolid(int x, int y, bool solid)
+{
+	int column = (int)floor((float)(x - m_originX) / (float)m_tileSize);
+	int row = (int)floor((float)(y - m_originY) / (float)m_tileSize);
+
+	if (0 <= column && column < m_columns && 0 <= row && row < m_rows)
+	{
+		unsigned char &tile = m_solid[(row * m_columns) + column];
+
+		if (tile != (unsigned char)solid)
+		{
+			m_solidCount += (solid ? 1 : -1);
+			tile = (unsigned char)solid;
+		}
+	}
+}
+
+bool TileCollisionLayer::isSolid(int column, int row)
+{
+	if (0 <= column && column < m_columns && 0 <= row && row < m_rows)
+	{
+		return m_solid[(row * m_columns) + column] != 0;
+	}
+
+	return false;
+}
+
+bool TileCollisionLayer::pointSolid(float x, float y)
+{
+	int column = (int)floor((x - (float)m_originX) / (float)m_tileSize);
+	int row = (int)floor((y - (float)m_originY) / (float)m_tileSize);
+
+	return isSolid(column, row);
+}
+
+//=============================================================================
+// Function: bool overlapsSolid(const AABB)
+// Description:
+// Checks if the box overlaps any solid tile. Only touching the edge of a
+// tile doesn't count.
+// Parameters:
+// const AABB bounds - The box to check.
+// Output:
+// bool - Returns true if any tile under the box is solid.
+//=============================================================================
+bool TileCollisionLayer::overlapsSolid(const AABB bounds)
+{
+	int firstColumn = 0;
+	int firstRow = 0;
+	int lastColumn = 0;
+	int lastRow = 0;
+
+	if (m_solidCount == 0 || !tileRange(bounds, firstColumn, firstRow, lastColumn, lastRow))
+	{
+		return false;
+	}
+
+	for (int row = firstRow; row <= lastRow; row++)
+	{
+		for (int column = firstColumn; column <= lastColumn; column++)
+		{
+			if (m_solid[(row * m_columns) + column])
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+//=============================================================================
+// Function: bool lineSolid(const Line)
+// Description:
+// Walks the tiles the line crosses in order and stops at the first solid
+// one. The line is cut down to the part inside of the layer first.
+// Parameters:
+// const Line line - The line to check.
+// Output:
+// bool - Returns true if the line crosses a solid tile.
+//=============================================================================
+bool TileCollisionLayer::lineSolid(const Line line)
+{
+	if (m_solidCount == 0)
+	{
+		return false;
+	}
+
+	float tileSize = (float)m_tileSize;
+
+	float startX = line.start.getX() - (float)m_originX;
+	float startY = line.start.getY() - (float)m_originY;
+	float directionX = line.end.getX() - line.start.getX();
+	float directionY = line.end.getY() - line.start.getY();
+
+	// Clip the line to the layer one axis at a time
+	float origin[2]{ startX, startY };
+	float direction[2]{ directionX, directionY };
+	float size[2]{ (float)m_columns * tileSize, (float)m_rows * tileSize };
+	float enter = 0.0f;
+	float exit = 1.0f;
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (direction[axis] == 0.0f)
+		{
+			if (origin[axis] < 0.0f || size[axis] < origin[axis])
+			{
+				return false;
+			}
+		}
+		else
+		{
+			float first = (0.0f - origin[axis]) / direction[axis];
+			float second = (size[axis] - origin[axis]) / direction[axis];
+
+			if (second < first)
+			{
+				float temp = first;
+				first = second;
+				second = temp;
+			}
+
+			if (enter < first) { enter = first; }
+			if (second < exit) { exit = second; }
+
+			if (exit < enter)
+			{
+				return false;
+			}
+		}
+	}
+
+	float clippedX = startX + (directionX * enter);
+	float clippedY = startY + (directionY * enter);
+
+	int column = (int)floor(clippedX / tileSize);
+	int row = (int)floor(clippedY / tileSize);
+	int endColumn = (int)floor((startX + (directionX * exit)) / tileSize);
+	int endRow = (int)floor((startY + (directionY * exit)) / tileSize);
+
+	// Points sitting right on the far edge still belong to the last tile
+	if (m_columns <= column) { column = m_columns - 1; }
+	if (m_rows <= row) { row = m_rows - 1; }
+	if (m_columns <= endColumn) { endColumn = m_columns - 1; }
+	if (m_rows <= endRow) { endRow = m_rows - 1; }
+	if (column < 0) { column = 0; }
+	if (row < 0) { row = 0; }
+	if (endColumn < 0) { endColumn = 0; }
+	if (endRow < 0) { endRow = 0; }
+
+	int stepX = (0.0f < directionX ? 1 : -1);
+	int stepY = (0.0f < directionY ? 1 : -1);
+
+	// How far along the line the next x and y tile borders are, and how far
+	// along the line one whole tile is.
+	float nextX = 2.0f;
+	float nextY = 2.0f;
+	float deltaX = 2.0f;
+	float deltaY = 2.0f;
+
+	if (directionX != 0.0f)
+	{
+		float border = (float)(column + (0 < stepX ? 1 : 0)) * tileSize;
+
+		nextX = (border - startX) / directionX;
+		deltaX = tileSize / fabs(directionX);
+	}
+
+	if (directionY != 0.0f)
+	{
+		float border = (float)(row + (0 < stepY ? 1 : 0)) * tileSize;
+
+		nextY = (border - startY) / directionY;
+		deltaY = tileSize / fabs(directionY);
+	}
+
+	int steps = m_columns + m_rows;
+
+	for (int i = 0; i <= steps; i++)
+	{
+		if (m_solid[(row * m_columns) + column])
+		{
+			return true;
+		}
+
+		if ((column == endColumn && row == endRow) || (exit < nextX && exit < nextY))
+		{
+			break;
+		}
+
+		if (nextX < nextY)
+		{
+			column += stepX;
+			nextX += deltaX;
+		}
+		else
+		{
+			row += stepY;
+			nextY += deltaY;
+		}
+
+		if (column < 0 || m_columns <= column || row < 0 || m_rows <= row)
+		{
+			break;
+		}
+	}
+
+	return false;
+}
+
+//=============================================================================
+// Function: bool sweep(const AABB, Vector2D, float&, Vector2D&)
+// Description:
+// Finds the first solid tile a moving box runs into. Tiles the box is
+// already overlapping are skipped so it can still get out of them.
+// Parameters:
+// const AABB moving - The box that's moving.
+// Vector2D displacement - How far the box is going to move.
+// float &time - How far along the move the box hits, from 0 to 1.
+// Vector2D &normal - The side of the tile that was hit.
+// Output:
+// bool - Returns true if the box hits a solid tile.
+//=============================================================================
+bool TileCollisionLayer::sweep(const AABB moving, Vector2D displacement, float &time, Vector2D &normal)
+{
+	int firstColumn = 0;
+	int firstRow = 0;
+	int lastColumn = 0;
+	int lastRow = 0;
+
+	AABB swept = combineBounds(moving, translateBounds(moving, displacement));
+
+	if (m_solidCount == 0 || !tileRange(swept, firstColumn, firstRow, lastColumn, lastRow))
+	{
+		return false;
+	}
+
+	bool hit = false;
+
+	for (int row = firstRow; row <= lastRow; row++)
+	{
+		for (int column = firstColumn; column <= lastColumn; column++)
+		{
+			if (m_solid[(row * m_columns) + column])
+			{
+				float tileTime = 0.0f;
+				Vector2D tileNormal{ 0.0f, 0.0f };
+
+				if (sweepBounds(moving, displacement, tileBounds(column, row), tileTime, tileNormal))
+				{
+					if (!hit || tileTime < time)
+					{
+						hit = true;
+						time = tileTime;
+						normal = tileNormal;
+					}
+				}
+			}
+		}
+	}
+
+	return hit;
+}
+
+//=============================================================================
+// Function: bool sweep(const FixedBounds, FixedVector, Fixed&, Vector2D&)
+// Description:
+// The fixed point version of sweep, for the fixed point physics.
+// Parameters:
+// const FixedBounds moving - The box that's moving.
+// FixedVector displacement - How far the box is going to move.
+// Fixed &time - How far along the move the box hits, from 0 to 1.
+// Vector2D &normal - The side of the tile that was hit.
+// Output:
+// bool - Returns true if the box hits a solid tile.
+//=============================================================================
+bool TileCollisionLayer::sweep(const FixedBounds moving, FixedVector displacement, Fixed &time, Vector2D &normal)
+{
+	int firstColumn = 0;
+	int firstRow = 0;
+	int lastColumn = 0;
+	int lastRow = 0;
+
+	FixedBounds end = translateFixedBounds(moving, displacement);
+
+	AABB swept{ toFloat(std::min(moving.minX, end.minX)), toFloat(std::min(moving.minY, end.minY)),
+				toFloat(std::max(moving.maxX, end.maxX)), toFloat(std::max(moving.maxY, end.maxY)) };
+
+	if (m_solidCount == 0 || !tileRange(swept, firstColumn, firstRow, lastColumn, lastRow))
+	{
+		return false;
+	}
+
+	bool hit = false;
+
+	for (int row = firstRow; row <= lastRow; row++)
+	{
+		for (int column = firstColumn; column <= lastColumn; column++)
+		{
+			if (m_solid[(row * m_columns) + column])
+			{
+				AABB tile = tileBounds(column, row);
+
+				FixedBounds target{ toFixed(tile.minX), toFixed(tile.minY), toFixed(tile.maxX), toFixed(tile.maxY) };
+
+				Fixed tileTime = 0;
+				Vector2D tileNormal{ 0.0f, 0.0f };
+
+				if (sweepFixedBounds(moving, displacement, target, tileTime, tileNormal))
+				{
+					if (!hit || tileTime < time)
+					{
+						hit = true;
+						time = tileTime;
+						normal = tileNormal;
+					}
+				}
+			}
+		}
+	}
+
+	return hit;
+}
+
+AABB TileCollisionLayer::tileBounds(int column, int row)
+{
+	float left = (float)(m_originX + (column * m_tileSize));
+	float top = (float)(m_originY + (row * m_tileSize));
+
+	AABB bounds{ left, top, left + (float)m_tileSize, top + (float)m_tileSize };
+
+	return bounds;
+}
+
+// Gets the tiles the box overlaps, cut down to the ones inside of the layer.
+// Returns false if the box misses the layer completely.
+bool TileCollisionLayer::tileRange(const AABB bounds, int &firstColumn, int &firstRow, int &lastColumn, int &lastRow)
+{
+	float tileSize = (float)m_tileSize;
+
+	firstColumn = (int)floor((bounds.minX - (float)m_originX) / tileSize);
+	firstRow = (int)floor((bounds.minY - (float)m_originY) / tileSize);
+	lastColumn = (int)ceil((bounds.maxX - (float)m_originX) / tileSize) - 1;
+	lastRow = (int)ceil((bounds.maxY - (float)m_originY) / tileSize) - 1;
+
+	if (firstColumn < 0) { firstColumn = 0; }
+	if (firstRow < 0) { firstRow = 0; }
+	if (m_columns <= lastColumn) { lastColumn = m_columns - 1; }
+	if (m_rows <= lastRow) { lastRow = m_rows - 1; }
+
+	return (firstColumn <= lastColumn && firstRow <= lastRow);
+}
@@ -0,0 +1,56 @@
+#pragma once
+//==========================================================================================
+// File Name: TileCollisionLayer.h
+// Author: Brian Blackmon
+// Date Created: 9/10/2019
+// Purpose: 
+// The solid walls of the dungeon, stored as one flag per tile. Walls never
+// move, so they don't need to be entities sitting in the broad phase next
+// to the player and the enemies. The layer is baked when the dungeon's
+// tiles are loaded and the collision system checks it directly.
+//==========================================================================================
+#include <vector>
+#include "AABB.h"
+#include "FixedPoint.h"
+#include "Line.h"
+
+class TileCollisionLayer
+{
+public:
+	TileCollisionLayer();
+	~TileCollisionLayer();
+
+	// Throws away every solid tile and covers the new area
+	void reset(int originX, int originY, int width, int height, int tileSize);
+	void clear();
+
+	// Marks the tile under the coordinates
+	void setSolid(int x, int y, bool solid);
+
+	bool isSolid(int column, int row);
+	bool empty() { return m_solidCount == 0; }
+
+	int columnCount() { return m_columns; }
+	int rowCount() { return m_rows; }
+	int tileSize() { return m_tileSize; }
+
+	bool pointSolid(float x, float y);
+	bool overlapsSolid(const AABB bounds);
+	bool lineSolid(const Line line);
+	bool sweep(const AABB moving, Vector2D displacement, float &time, Vector2D &normal);
+	bool sweep(const FixedBounds moving, FixedVector displacement, Fixed &time, Vector2D &normal);
+
+private:
+	int m_originX;
+	int m_originY;
+	int m_columns;
+	int m_rows;
+	int m_tileSize;
+	int m_solidCount;
+
+	// One flag per tile, stored a row at a time
+	std::vector<unsigned char> m_solid;
+
+	AABB tileBounds(int column, int row);
+	bool tileRange(const AABB bounds, int &firstColumn, int &firstRow, int &lastColumn, int &lastRow);
+};
@@ -12,7 +12,8 @@ class Timer
 {
 public:
 	Timer()
-		:m_running(false), m_paused(false), m_startTick(0), m_pausedTick(0)
+		:m_running(false), m_paused(false), m_startTick(0), m_pausedTick(0),
+		m_startCount(0), m_pausedCount(0)
 	{
 
 	}
@@ -39,6 +40,9 @@ public:
 
 		m_startTick = SDL_GetTicks();
 		m_pausedTick = 0;
+
+		m_startCount = SDL_GetPerformanceCounter();
+		m_pausedCount = 0;
 	}
 
 	void pause()
@@ -47,6 +51,7 @@ public:
 		{
 			m_paused = true;
 			m_pausedTick = SDL_GetTicks();
+			m_pausedCount = SDL_GetPerformanceCounter();
 		}
 	}
 
@@ -54,8 +59,11 @@ public:
 	{
 		if(m_running && m_paused)
 		{
+			m_startCount += SDL_GetPerformanceCounter() - m_pausedCount;
+
 			m_paused = false;
 			m_pausedTick = 0;
+			m_pausedCount = 0;
 		}
 	}
 
@@ -65,6 +73,8 @@ public:
 		m_paused = false;
 		m_startTick = 0;
 		m_pausedTick = 0;
+		m_startCount = 0;
+		m_pausedCount = 0;
 	}
 
 	Uint32 currentTicks()
@@ -107,11 +117,29 @@ public:
 		return current;
 	}
 
+	// The same as currentSeconds, but read from the high resolution counter
+	// instead of the millisecond ticks. Time spent paused isn't counted.
+	double preciseSeconds()
+	{
+		double current = 0.0;
+
+		if(m_running)
+		{
+			Uint64 count = (m_paused ? m_pausedCount : SDL_GetPerformanceCounter());
+
+			current = (double)(count - m_startCount) / (double)SDL_GetPerformanceFrequency();
+		}
+
+		return current;
+	}
+
 private:
 	const int m_ticksPerSecond = 1000;
 	
 	Uint32 m_startTick;
 	Uint32 m_pausedTick;
+	Uint64 m_startCount;
+	Uint64 m_pausedCount;
 	bool m_running;
 	bool m_paused;
 };
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "UIGraphic.h"
 #include "UIButton.h"
 #include "UIText.h"
+#include "IMessageHandler.h"
 #include <map>
 #include "Rectangle.h"
 #include <string>
@@ -17,7 +18,7 @@
 typedef Shape::Rectangle Rectangle;
 typedef std::string string;
 
-class UIMenu
+class UIMenu : public IMessageHandler
 {
 public:
 	UIMenu(Vector2D position, int width, int height, string texturePath);
@@ -1,15 +0,0 @@
-#include "VelocityComponent.h"
-
-
-
-VelocityComponent::VelocityComponent()
-	:Component(VELOCITY), m_velocity(0, 0), m_currentVelocity(0, 0)
-{
-
-}
-
-
-VelocityComponent::~VelocityComponent()
-{
-
-}
\ No newline at end of file
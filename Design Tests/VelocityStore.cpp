@@ -0,0 +1,263 @@
+#include "VelocityStore.h"
+#include "EntityID.h"
+#include <cmath>
+#include <algorithm>
+
+VelocityStore::VelocityStore()
+	:m_awakeCount(0)
+{
+}
+
+VelocityStore::~VelocityStore()
+{
+}
+
+//=============================================================================
+// Function: int add(int)
+// Description:
+// Gives the entity a velocity at the end of the arrays, starting at 0 and
+// asleep. If the entity already has one, it's left alone. A velocity left
+// in the slot by a deleted entity is removed first.
+// Parameters:
+// int ID - The entity to give a velocity.
+// Output:
+// int - The entity's index in the arrays. Returns -1 for negative IDs.
+//=============================================================================
+int VelocityStore::add(int ID)
+{
+	if (ID < 0)
+	{
+		return m_NO_INDEX;
+	}
+
+	int slot = entitySlot(ID);
+
+	if ((int)m_indices.size() <= slot)
+	{
+		m_indices.resize(slot + 1, m_NO_INDEX);
+	}
+
+	if (m_indices[slot] != m_NO_INDEX && m_entityIDs[m_indices[slot]] != ID)
+	{
+		remove(m_entityIDs[m_indices[slot]]);
+	}
+
+	if (m_indices[slot] == m_NO_INDEX)
+	{
+		m_indices[slot] = (int)m_entityIDs.size();
+
+		m_entityIDs.push_back(ID);
+		m_velocityX.push_back(0.0f);
+		m_velocityY.push_back(0.0f);
+		m_stillTicks.push_back(0);
+	}
+
+	return m_indices[slot];
+}
+
+//=============================================================================
+// Function: void remove(int)
+// Description:
+// Removes the entity's velocity. An awake body first trades places with the
+// last awake one, then the last velocity in the arrays is moved into the
+// hole so they stay packed.
+// Parameters:
+// int ID - The entity to remove.
+//=============================================================================
+void VelocityStore::remove(int ID)
+{
+	int index = indexOf(ID);
+
+	if (index == m_NO_INDEX)
+	{
+		return;
+	}
+
+	if (index < m_awakeCount)
+	{
+		m_awakeCount--;
+		swapSlots(index, m_awakeCount);
+		index = m_awakeCount;
+	}
+
+	swapSlots(index, (int)m_entityIDs.size() - 1);
+
+	m_entityIDs.pop_back();
+	m_velocityX.pop_back();
+	m_velocityY.pop_back();
+	m_stillTicks.pop_back();
+
+	m_indices[entitySlot(ID)] = m_NO_INDEX;
+}
+
+void VelocityStore::clear()
+{
+	m_indices.clear();
+	m_entityIDs.clear();
+	m_velocityX.clear();
+	m_velocityY.clear();
+	m_stillTicks.clear();
+
+	m_awakeCount = 0;
+}
+
+int VelocityStore::indexOf(int ID)
+{
+	int slot = entitySlot(ID);
+
+	if (0 <= ID && slot < (int)m_indices.size())
+	{
+		int index = m_indices[slot];
+
+		// An old ID for a reused slot doesn't match the one stored
+		if (index != m_NO_INDEX && m_entityIDs[index] == ID)
+		{
+			return index;
+		}
+	}
+
+	return m_NO_INDEX;
+}
+
+//=============================================================================
+// Function: void wake(int)
+// Description:
+// Wakes the body up by swapping it with the first sleeping one. Waking an
+// awake body just restarts its count towards sleeping.
+// Parameters:
+// int ID - The entity to wake.
+//=============================================================================
+void VelocityStore::wake(int ID)
+{
+	int index = indexOf(ID);
+
+	if (index == m_NO_INDEX)
+	{
+		return;
+	}
+
+	if (m_awakeCount <= index)
+	{
+		swapSlots(index, m_awakeCount);
+		index = m_awakeCount;
+		m_awakeCount++;
+	}
+
+	m_stillTicks[index] = 0;
+}
+
+//=============================================================================
+// Function: void sleepStill(int)
+// Description:
+// Counts another tick for every awake body that isn't moving, and puts the
+// ones that have been still long enough to sleep. Bodies that are moving
+// start counting over.
+// Parameters:
+// int stillTicks - How many ticks in a row a body has to be still to sleep.
+//=============================================================================
+void VelocityStore::sleepStill(int stillTicks)
+{
+	// Going backwards means the body swapped into a sleeper's spot has
+	// already been looked at.
+	for (int i = m_awakeCount - 1; 0 <= i; i--)
+	{
+		if (moving(i))
+		{
+			m_stillTicks[i] = 0;
+		}
+		else
+		{
+			m_stillTicks[i]++;
+
+			if (stillTicks <= m_stillTicks[i])
+			{
+				m_awakeCount--;
+				swapSlots(i, m_awakeCount);
+			}
+		}
+	}
+}
+
+void VelocityStore::setVelocity(int index, Vector2D velocity)
+{
+	m_velocityX[index] = velocity.getX();
+	m_velocityY[index] = velocity.getY();
+}
+
+void VelocityStore::increaseVelocity(int index, float xIncrease, float yIncrease)
+{
+	m_velocityX[index] += xIncrease;
+	m_velocityY[index] += yIncrease;
+}
+
+//=============================================================================
+// Function: void applyFriction(float)
+// Description:
+// Slows every awake velocity down by the amount on each axis. Sleeping
+// bodies are already stopped. Speeds smaller than the amount stop instead
+// of flipping around. There's no branching in the loops, so the compiler
+// is free to do several velocities at once.
+// Parameters:
+// float amount - How much speed to take away.
+//=============================================================================
+void VelocityStore::applyFriction(float amount)
+{
+	int velocityCount = m_awakeCount;
+
+	float *velocityX = m_velocityX.data();
+	float *velocityY = m_velocityY.data();
+
+	for (int i = 0; i < velocityCount; i++)
+	{
+		velocityX[i] = std::copysign(std::max(std::fabs(velocityX[i]) - amount, 0.0f), velocityX[i]);
+	}
+
+	for (int i = 0; i < velocityCount; i++)
+	{
+		velocityY[i] = std::copysign(std::max(std::fabs(velocityY[i]) - amount, 0.0f), velocityY[i]);
+	}
+}
+
+//=============================================================================
+// Function: void applyFriction(Fixed)
+// Description:
+// The same as applyFriction(float), but the velocities are slowed down
+// with integer math for the fixed point physics.
+// Parameters:
+// Fixed amount - How much speed to take away.
+//=============================================================================
+void VelocityStore::applyFriction(Fixed amount)
+{
+	int velocityCount = m_awakeCount;
+
+	float *velocities[2]{ m_velocityX.data(), m_velocityY.data() };
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		float *velocity = velocities[axis];
+
+		for (int i = 0; i < velocityCount; i++)
+		{
+			Fixed speed = toFixed(velocity[i]);
+			Fixed slowed = std::max(fixedAbs(speed) - amount, 0);
+
+			velocity[i] = toFloat(speed < 0 ? -slowed : slowed);
+		}
+	}
+}
+
+void VelocityStore::swapSlots(int first, int second)
+{
+	if (first == second)
+	{
+		return;
+	}
+
+	std::swap(m_entityIDs[first], m_entityIDs[second]);
+	std::swap(m_velocityX[first], m_velocityX[second]);
+	std::swap(m_velocityY[first], m_velocityY[second]);
+	std::swap(m_stillTicks[first], m_stillTicks[second]);
+
+	m_indices[entitySlot(m_entityIDs[first])] = first;
+	m_indices[entitySlot(m_entityIDs[second])] = second;
+}
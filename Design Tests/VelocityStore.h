@@ -0,0 +1,67 @@
+#pragma once
+//==========================================================================================
+// File Name: VelocityStore.h
+// Author: Brian Blackmon
+// Date Created: 9/16/2019
+// Purpose: 
+// Holds the velocity of every entity that has one. The velocities are packed
+// together in plain arrays, one per axis, so the physics can run through all
+// of them in order without chasing pointers. Each entity ID maps to its
+// spot in the arrays, and removing an entity moves the last one into its spot.
+// The awake bodies are kept at the front of the arrays and the sleeping ones
+// after them, so the physics only has to run through the front.
+//==========================================================================================
+#include <vector>
+#include "Vector2D.h"
+#include "FixedPoint.h"
+
+class VelocityStore
+{
+public:
+	VelocityStore();
+	~VelocityStore();
+
+	// Gives the entity a velocity of 0 if it doesn't have one yet. New
+	// bodies start asleep. Returns the entity's index either way.
+	int add(int ID);
+	void remove(int ID);
+	void clear();
+
+	// Returns -1 if the entity doesn't have a velocity
+	int indexOf(int ID);
+
+	int count() { return (int)m_entityIDs.size(); }
+	// The awake bodies are the indices below this
+	int awakeCount() { return m_awakeCount; }
+	int entityID(int index) { return m_entityIDs[index]; }
+
+	Vector2D velocity(int index) { return Vector2D(m_velocityX[index], m_velocityY[index]); }
+	bool moving(int index) { return m_velocityX[index] != 0.0f || m_velocityY[index] != 0.0f; }
+
+	// Moves the body to the awake part of the arrays, which changes its
+	// index. Sleeping bodies must be woken before their velocity is changed.
+	void wake(int ID);
+	void sleepStill(int stillTicks);
+
+	void setVelocity(int index, Vector2D velocity);
+	void increaseVelocity(int index, float xIncrease, float yIncrease);
+
+	void applyFriction(float amount);
+	void applyFriction(Fixed amount);
+
+private:
+	const int m_NO_INDEX = -1;
+
+	// The index of each entity's velocity, indexed by its slot
+	std::vector<int> m_indices;
+
+	std::vector<int> m_entityIDs;
+	std::vector<float> m_velocityX;
+	std::vector<float> m_velocityY;
+	// How many ticks in a row each body hasn't been moving
+	std::vector<int> m_stillTicks;
+
+	int m_awakeCount;
+
+	void swapSlots(int first, int second);
+};
@@ -0,0 +1,125 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int workerCount)
+	:m_job(NULL), m_jobCount(0), m_nextJob(0), m_batch(0), m_busyWorkers(0), m_stopping(false)
+{
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_threads.push_back(std::thread(&WorkerPool::workerLoop, this));
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_wake.notify_all();
+
+	for (unsigned int i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+}
+
+//=============================================================================
+// Function: void run(int, const std::function<void(int)>&)
+// Description:
+// Hands the jobs out to the workers and works on them from this thread
+// too. Jobs are taken in order, but which thread runs which job and when
+// is up to chance, so jobs can't share anything they write to.
+// Parameters:
+// int jobCount - How many jobs there are.
+// const std::function<void(int)> &job - Gets called with each job's number.
+//=============================================================================
+void WorkerPool::run(int jobCount, const std::function<void(int)> &job)
+{
+	if (jobCount <= 0)
+	{
+		return;
+	}
+
+	// Not worth waking anyone up for
+	if (m_threads.empty() || jobCount == 1)
+	{
+		for (int i = 0; i < jobCount; i++)
+		{
+			job(i);
+		}
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_job = &job;
+		m_jobCount = jobCount;
+		m_nextJob = 0;
+		m_busyWorkers = (int)m_threads.size();
+		m_batch++;
+	}
+
+	m_wake.notify_all();
+
+	runJobs();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	m_finished.wait(lock, [this]() { return m_busyWorkers == 0; });
+
+	m_job = NULL;
+}
+
+int WorkerPool::defaultWorkerCount()
+{
+	int cores = (int)std::thread::hardware_concurrency();
+
+	return (1 < cores ? cores - 1 : 0);
+}
+
+void WorkerPool::workerLoop()
+{
+	unsigned int lastBatch = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_wake.wait(lock, [this, lastBatch]() { return m_stopping || m_batch != lastBatch; });
+
+			if (m_stopping)
+			{
+				return;
+			}
+
+			lastBatch = m_batch;
+		}
+
+		runJobs();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_busyWorkers--;
+		}
+
+		m_finished.notify_one();
+	}
+}
+
+// Keeps taking the next job until they've all been taken
+void WorkerPool::runJobs()
+{
+	int job = m_nextJob++;
+
+	while (job < m_jobCount)
+	{
+		(*m_job)(job);
+
+		job = m_nextJob++;
+	}
+}
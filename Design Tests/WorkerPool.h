@@ -0,0 +1,53 @@
+#pragma once
+//==========================================================================================
+// File Name: WorkerPool.h
+// Author: Brian Blackmon
+// Date Created: 9/17/2019
+// Purpose: 
+// A handful of threads that sit waiting for work. A batch of jobs is handed
+// out to them and the thread that handed it out helps until every job in
+// the batch is finished. Jobs are numbered, so whoever runs them can keep
+// each job's results apart and put them together in order afterwards.
+//==========================================================================================
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+class WorkerPool
+{
+public:
+	WorkerPool(int workerCount);
+	~WorkerPool();
+
+	// How many threads there are besides the one calling run
+	int workerCount() { return (int)m_threads.size(); }
+
+	// Runs job(0) through job(jobCount - 1) and returns once they're all done
+	void run(int jobCount, const std::function<void(int)> &job);
+
+	// One less than the number of cores, so the calling thread has one too
+	static int defaultWorkerCount();
+
+private:
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_finished;
+
+	const std::function<void(int)> *m_job;
+	int m_jobCount;
+	std::atomic<int> m_nextJob;
+
+	// Counts up with every batch so the workers can tell a new one started
+	unsigned int m_batch;
+	// How many workers are still on the current batch
+	int m_busyWorkers;
+	bool m_stopping;
+
+	void workerLoop();
+	void runJobs();
+};
@@ -1,5 +1,6 @@
 #include "World.h"
 #include <iostream>
+#include <algorithm>
 #include "ResourceManager.h"
 #include "Texture.h"
 #include "EntitySystem.h"
@@ -91,6 +92,11 @@ std::string World::roomData(int roomType)
 	return data;
 }
 
+void World::setSeed(unsigned int seed)
+{
+	srand(seed);
+}
+
 void World::dungeon()
 {
 	createDungeon();
@@ -246,6 +252,8 @@ void World::loadData(std::string roomPath)
 //=============================================================================
 void World::loadTiles()
 {
+	TileCollisionLayer *walls = bakeWalls();
+
 	for (unsigned int room = 0; room < m_rooms.size(); room++)
 	{
 		int x = (int)m_rooms[room]->rect()->getTopLeft().getX();
@@ -384,14 +392,13 @@ void World::loadTiles()
 						}
 					}
 
-					int entityType = 4;
-
-					if (tileSolid)
+					// Walls only need a sprite. Their collision goes in the wall layer.
+					if (tileSolid && walls)
 					{
-						entityType = 3;
+						walls->setSolid(tileX, tileY, true);
 					}
 
-					tile = entity->createEntity(entityType, Vector2D((float)tileX + (tileSize / 2), (float)tileY + (tileSize / 2)));
+					tile = entity->createEntity(4, Vector2D((float)tileX + (tileSize / 2), (float)tileY + (tileSize / 2)));
 
 					int randTex = 0;
 
@@ -474,15 +481,13 @@ void World::loadTiles()
 						solid = true;
 					}
 
-					if (solid)
+					if (solid && walls)
 					{
-						tile = entity->createEntity(3, Vector2D((float)tileX + (tileSize / 2), (float)tileY + (tileSize / 2)));
-					}
-					else
-					{
-						tile = entity->createEntity(4, Vector2D((float)tileX + (tileSize / 2), (float)tileY + (tileSize / 2)));
+						walls->setSolid(tileX, tileY, true);
 					}
 
+					tile = entity->createEntity(4, Vector2D((float)tileX + (tileSize / 2), (float)tileY + (tileSize / 2)));
+
 					int randTex = 0;
 
 					if (tileType < 2)
@@ -535,15 +540,13 @@ void World::loadTiles()
 						solid = true;
 					}
 
-					if (solid)
+					if (solid && walls)
 					{
-						tile = entity->createEntity(3, Vector2D((float)tileX + (tileSize / 2), (float)tileY + (tileSize / 2)));
-					}
-					else
-					{
-						tile = entity->createEntity(4, Vector2D((float)tileX + (tileSize / 2), (float)tileY + (tileSize / 2)));
+						walls->setSolid(tileX, tileY, true);
 					}
 
+					tile = entity->createEntity(4, Vector2D((float)tileX + (tileSize / 2), (float)tileY + (tileSize / 2)));
+
 					int randTex = 0;
 
 					if (tileType < 2)
@@ -654,6 +657,51 @@ void World::loadTiles()
 	}
 }
 
+//=============================================================================
+// Function: TileCollisionLayer* bakeWalls()
+// Description:
+// Sizes the collision system's wall layer to cover every room and hallway
+// and clears out the walls of the last dungeon.
+// Output:
+// Returns the wall layer on success.
+// Returns NULL if there's no collision system yet.
+//=============================================================================
+TileCollisionLayer* World::bakeWalls()
+{
+	CollisionSystem *collision = PhysicsSystem::instance()->collisionSystem();
+
+	if (!collision || m_rooms.empty())
+	{
+		return NULL;
+	}
+
+	Shape::Rectangle *first = m_rooms[0]->rect();
+
+	int minX = (int)first->getTopLeft().getX();
+	int minY = (int)first->getTopLeft().getY();
+	int maxX = minX + first->width();
+	int maxY = minY + first->height();
+
+	for (unsigned int i = 0; i < m_rooms.size() + m_hallways.size(); i++)
+	{
+		Shape::Rectangle *rect = (i < m_rooms.size() ? m_rooms[i]->rect() : m_hallways[i - m_rooms.size()]->rect());
+
+		int left = (int)(rect->center().getX() - (rect->width() / 2));
+		int top = (int)(rect->center().getY() - (rect->height() / 2));
+
+		minX = std::min(minX, left);
+		minY = std::min(minY, top);
+		maxX = std::max(maxX, left + rect->width());
+		maxY = std::max(maxY, top + rect->height());
+	}
+
+	TileCollisionLayer *walls = collision->tileLayer();
+
+	walls->reset(minX, minY, maxX - minX, maxY - minY, 32);
+
+	return walls;
+}
+
 void World::generateHallways()
 {
 	// Find the closest room for each room
@@ -845,10 +893,6 @@ void World::createDungeon()
 	int roomWidth = 0;
 	int roomHeight = 0;
 
-	Uint32 seed = SDL_GetTicks();
-
-	srand(seed);
-
 	CollisionSystem *collisionSys = PhysicsSystem::instance()->collisionSystem();
 
 	roomType = rand() % m_roomData.size();
@@ -8,6 +8,7 @@
 //==========================================================================================
 #include "Room.h"
 #include "SettingIO.h"
+#include "TileCollisionLayer.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -24,6 +25,9 @@ public:
 	
 	bool exists() { return m_exists; }
 	
+	// Starts the random numbers the dungeons are made from. The same seed
+	// makes the same dungeons.
+	void setSeed(unsigned int seed);
 	void dungeon();
 	void clear();
 	void renderRooms();
@@ -38,6 +42,7 @@ private:
 
 	void loadData(std::string roomPath);
 	void loadTiles();
+	TileCollisionLayer* bakeWalls();
 	void generateHallways();
 
 	bool validateRooms(Room *room, int &runCount);